@@ -0,0 +1,101 @@
+// RHASKSampleStream.cpp
+//
+// Streams of samples for running the RH_ASK modem on Linux without a timer interrupt
+// Part of the RadioHead library
+
+#include <RHASKSampleStream.h>
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI)
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+int32_t RHASKSampleSource::write(const uint8_t* samples, uint32_t len)
+{
+    (void)samples; // Not used
+    return len;
+}
+
+RHASKFileSampleSource::RHASKFileSampleSource(int readFd, int writeFd)
+    :
+    _readFd(readFd),
+    _writeFd(writeFd),
+    _atEnd(false)
+{
+    setNonBlocking();
+}
+
+bool RHASKFileSampleSource::open(const char* readPath, const char* writePath)
+{
+    close();
+    _atEnd = false;
+    if (readPath)
+    {
+	_readFd = strcmp(readPath, "-") ? ::open(readPath, O_RDONLY) : 0;
+	if (_readFd < 0)
+	    return false;
+	setNonBlocking();
+    }
+    if (writePath)
+    {
+	_writeFd = strcmp(writePath, "-") ? ::open(writePath, O_WRONLY | O_CREAT | O_TRUNC, 0644) : 1;
+	if (_writeFd < 0)
+	{
+	    close(); // Dont leak the read file
+	    return false;
+	}
+    }
+    return true;
+}
+
+void RHASKFileSampleSource::close()
+{
+    // stdin and stdout are left open
+    if (_readFd > 0)
+	::close(_readFd);
+    if (_writeFd > 1)
+	::close(_writeFd);
+    _readFd = -1;
+    _writeFd = -1;
+}
+
+void RHASKFileSampleSource::setNonBlocking()
+{
+    if (_readFd >= 0)
+	fcntl(_readFd, F_SETFL, fcntl(_readFd, F_GETFL) | O_NONBLOCK);
+}
+
+int32_t RHASKFileSampleSource::read(uint8_t* samples, uint32_t len)
+{
+    if (_readFd < 0 || _atEnd)
+	return -1;
+    ssize_t result = ::read(_readFd, samples, len);
+    if (result > 0)
+	return result;
+    if (result < 0 && (errno == EAGAIN || errno == EINTR))
+	return 0; // Nothing available just now
+    _atEnd = true;
+    return -1;
+}
+
+int32_t RHASKFileSampleSource::write(const uint8_t* samples, uint32_t len)
+{
+    if (_writeFd < 0)
+	return len;
+    uint32_t sent = 0;
+    while (sent < len)
+    {
+	ssize_t result = ::write(_writeFd, samples + sent, len - sent);
+	if (result < 0)
+	{
+	    if (errno == EINTR)
+		continue;
+	    return -1;
+	}
+	sent += result;
+    }
+    return sent;
+}
+
+#endif
@@ -0,0 +1,104 @@
+// RHASKSampleStream.h
+//
+// Streams of samples for running the RH_ASK modem on Linux without a timer interrupt
+// Part of the RadioHead library
+
+#ifndef RHASKSampleStream_h
+#define RHASKSampleStream_h
+
+#include <RadioHead.h>
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI)
+
+/////////////////////////////////////////////////////////////////////
+/// \class RHASKSampleSource RHASKSampleStream.h <RHASKSampleStream.h>
+/// \brief Abstract base class for a stream of samples for RH_ASK to demodulate and modulate, on Linux.
+///
+/// On Linux there is no timer interrupt to sample the receiver pin 8 times per bit, so instead RH_ASK
+/// can demodulate a stream of samples provided by a subclass of this class, many samples at a time.
+/// Each sample is one unsigned octet, such as 8 bit unsigned PCM audio from a sound card
+/// connected to a cheap 433MHz OOK receiver, or a GPIO pin or logic analyser sampled at a fixed rate.
+/// Samples at or above the threshold set by RH_ASK::setSampleThreshold() are a 1, others a 0.
+/// When transmitting, RH_ASK writes the modulated samples (0x00 or 0xff) back to the same object.
+///
+/// Subclass this to get samples from somewhere else, such as ALSA or a GPIO driver.
+/// See RHASKFileSampleSource for files, pipes and other file descriptors.
+class RHASKSampleSource
+{
+public:
+    /// Reads as many samples as are available now, without blocking.
+    /// \param[out] samples Where to put the samples
+    /// \param[in] len Maximum number of samples to read
+    /// \return The number of samples read, 0 if none are available now, or -1 if the end of the stream
+    /// has been reached or there was an error
+    virtual int32_t read(uint8_t* samples, uint32_t len) = 0;
+
+    /// Writes samples from the RH_ASK modulator. May block until they have been consumed.
+    /// The default discards them.
+    /// \param[in] samples The samples to write
+    /// \param[in] len Number of samples
+    /// \return The number of samples written, or -1 if there was an error
+    virtual int32_t write(const uint8_t* samples, uint32_t len);
+};
+
+/////////////////////////////////////////////////////////////////////
+/// \class RHASKFileSampleSource RHASKSampleStream.h <RHASKSampleStream.h>
+/// \brief RHASKSampleSource that reads and writes samples through file descriptors.
+///
+/// Can be used with recorded captures (to regression-test the modem, or decode off line), named pipes,
+/// or live sound cards by piping through the ALSA tools, for example:
+/// \code
+/// arecord -t raw -f U8 -r 48000 -c 1 | ./ask_sample_receiver
+/// \endcode
+/// The read descriptor is set non-blocking, so RH_ASK::available() does not block waiting for samples.
+class RHASKFileSampleSource : public RHASKSampleSource
+{
+public:
+    /// Constructor.
+    /// \param[in] readFd File descriptor to read samples from, or -1 for none. Defaults to stdin.
+    /// \param[in] writeFd File descriptor to write modulated samples to, or -1 to discard them.
+    RHASKFileSampleSource(int readFd = 0, int writeFd = -1);
+
+    /// Opens files to read and write samples, replacing (and closing) any file descriptors previously set.
+    /// \param[in] readPath Path of the file or named pipe to read from, "-" for stdin, or NULL for none.
+    /// \param[in] writePath Path of the file or named pipe to write to (which will be created or truncated),
+    /// "-" for stdout, or NULL to discard modulated samples.
+    /// \return true if all the named files could be opened. If not, none are left open.
+    bool            open(const char* readPath, const char* writePath = NULL);
+
+    /// Closes the read and write file descriptors, except stdin and stdout.
+    void            close();
+
+    /// Reads as many samples as are available now.
+    /// \param[out] samples Where to put the samples
+    /// \param[in] len Maximum number of samples to read
+    /// \return The number of samples read, 0 if none are available now, or -1 at the end of the file
+    virtual int32_t read(uint8_t* samples, uint32_t len);
+
+    /// Writes modulated samples to the write file descriptor, if any.
+    /// \param[in] samples The samples to write
+    /// \param[in] len Number of samples
+    /// \return The number of samples written, or -1 if there was an error
+    virtual int32_t write(const uint8_t* samples, uint32_t len);
+
+    /// Tells whether the end of the input has been reached.
+    /// \return true if the end of the read file descriptor has been reached
+    bool            atEnd() { return _atEnd;}
+
+protected:
+    /// Makes the read file descriptor non-blocking
+    void            setNonBlocking();
+
+    /// File descriptor samples are read from, or -1
+    int             _readFd;
+
+    /// File descriptor modulated samples are written to, or -1
+    int             _writeFd;
+
+    /// True when the end of the read file has been reached
+    bool            _atEnd;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,290 @@
+// RHAdaptiveDataRate.cpp
+//
+// Adaptive data rate control of the LoRa spreading factor for each peer of an RH_RF95.
+// Part of the RadioHead library
+
+#include <RHAdaptiveDataRate.h>
+
+// The demodulation floor in tenths of a dB for a spreading factor, from the SX1276 datasheet:
+// -5dB at SF6, falling by 2.5dB per step to -20dB at SF12
+#define RH_ADR_FLOOR(sf) (100 - 25 * (int16_t)(sf))
+
+////////////////////////////////////////////////////////////////////
+// Constructors
+RHAdaptiveDataRate::RHAdaptiveDataRate(RH_RF95& driver, uint8_t thisAddress)
+    : RHReliableDatagram(driver, thisAddress),
+      _rf95(driver)
+{
+    _numPeers = 0;
+    _baseSF = 7;
+    _currentSF = 7;
+    _currentPeer = RH_BROADCAST_ADDRESS;
+    _minSF = 7;
+    _maxSF = 12;
+    _margin = RH_ADR_DEFAULT_MARGIN;
+    _maxLosses = RH_ADR_DEFAULT_MAX_LOSSES;
+    _silenceTimeout = 0;
+    _adaptations = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+// Public methods
+bool RHAdaptiveDataRate::init()
+{
+    if (!RHReliableDatagram::init())
+	return false;
+    _baseSF = _currentSF = _rf95.spreadingFactor();
+    _currentPeer = RH_BROADCAST_ADDRESS;
+    _numPeers = 0;
+    return true;
+}
+
+void RHAdaptiveDataRate::setMargin(uint8_t margin)
+{
+    _margin = margin;
+}
+
+void RHAdaptiveDataRate::setSpreadingFactorRange(uint8_t minSF, uint8_t maxSF)
+{
+    _minSF = minSF < 6 ? 6 : minSF;
+    _maxSF = maxSF > 12 ? 12 : maxSF;
+}
+
+void RHAdaptiveDataRate::setMaxLosses(uint8_t losses)
+{
+    _maxLosses = losses;
+}
+
+void RHAdaptiveDataRate::setSilenceTimeout(unsigned long timeout)
+{
+    _silenceTimeout = timeout;
+}
+
+bool RHAdaptiveDataRate::sendtoWait(uint8_t* buf, uint8_t len, uint8_t address)
+{
+    if (address == RH_BROADCAST_ADDRESS)
+	return RHReliableDatagram::sendtoWait(buf, len, address);
+
+    Peer* p = peer(address, true);
+    useSpreadingFactor(p->sf);
+    _currentPeer = address;
+    if (RHReliableDatagram::sendtoWait(buf, len, address))
+    {
+	// The last frame received was the ACK
+	p->losses = 0;
+	p->lastHeard = millis();
+	addSample(p);
+	adapt(p);
+	return true;
+    }
+    if (++p->losses >= _maxLosses && p->sf != _baseSF)
+    {
+	// Maybe the link has got worse, or the peer has fallen back already
+	changeSpreadingFactor(p, _baseSF);
+	useSpreadingFactor(_baseSF);
+    }
+    return false;
+}
+
+bool RHAdaptiveDataRate::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags)
+{
+    uint8_t _from;
+    uint8_t _to;
+    uint8_t _id;
+    uint8_t _flags;
+    uint8_t bufLen = *len;
+
+    checkSilence();
+    if (!RHReliableDatagram::recvfromAck(buf, len, &_from, &_to, &_id, &_flags))
+	return false;
+
+    Peer* p = peer(_from, true);
+    // We heard it, so the peer is sending at the spreading factor we are listening on,
+    // for example after falling back
+    if (p->sf != _currentSF)
+	changeSpreadingFactor(p, _currentSF);
+    p->lastHeard = millis();
+    _currentPeer = _from;
+
+    if (_flags & RH_FLAGS_ADR_CONTROL)
+    {
+	// Already acknowledged at the old spreading factor, so change now
+	if (   _to == _thisAddress
+	    && *len >= 2
+	    && buf[0] == RH_ADR_MESSAGE_TYPE_SET_SF
+	    && buf[1] >= 6 && buf[1] <= 12)
+	{
+	    changeSpreadingFactor(p, buf[1]);
+	    useSpreadingFactor(buf[1]);
+	}
+	*len = bufLen; // Not for the application
+	return false;
+    }
+
+    addSample(p);
+    if (_to == _thisAddress)
+	adapt(p);
+
+    if (from)  *from =  _from;
+    if (to)    *to =    _to;
+    if (id)    *id =    _id;
+    if (flags) *flags = _flags;
+    return true;
+}
+
+bool RHAdaptiveDataRate::recvfromAckTimeout(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags)
+{
+    unsigned long starttime = millis();
+    int32_t timeLeft;
+    while ((timeLeft = timeout - (millis() - starttime)) > 0)
+    {
+	if (waitAvailableTimeout(timeLeft))
+	{
+	    if (recvfromAck(buf, len, from, to, id, flags))
+		return true;
+	}
+	YIELD;
+    }
+    checkSilence();
+    return false;
+}
+
+uint8_t RHAdaptiveDataRate::peerSpreadingFactor(uint8_t address)
+{
+    Peer* p = peer(address, false);
+    return p ? p->sf : _baseSF;
+}
+
+int8_t RHAdaptiveDataRate::peerSNR(uint8_t address)
+{
+    Peer* p = peer(address, false);
+    int8_t best = -128;
+    if (p)
+	for (uint8_t i = 0; i < p->historyLen; i++)
+	    if (p->snr[i] > best)
+		best = p->snr[i];
+    return best;
+}
+
+int16_t RHAdaptiveDataRate::peerRssi(uint8_t address)
+{
+    Peer* p = peer(address, false);
+    if (!p || !p->historyLen)
+	return 0;
+    int32_t total = 0;
+    for (uint8_t i = 0; i < p->historyLen; i++)
+	total += p->rssi[i];
+    return total / p->historyLen;
+}
+
+uint32_t RHAdaptiveDataRate::adaptations()
+{
+    return _adaptations;
+}
+
+void RHAdaptiveDataRate::resetAdaptations()
+{
+    _adaptations = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+// Protected methods
+RHAdaptiveDataRate::Peer* RHAdaptiveDataRate::peer(uint8_t address, bool create)
+{
+    uint8_t i;
+    for (i = 0; i < _numPeers; i++)
+	if (_peers[i].address == address)
+	    return &_peers[i];
+    if (!create)
+	return NULL;
+
+    if (_numPeers < RH_ADR_MAX_PEERS)
+	i = _numPeers++;
+    else
+    {
+	// Forget the peer heard from least recently
+	unsigned long now = millis();
+	i = 0;
+	for (uint8_t j = 1; j < _numPeers; j++)
+	    if (now - _peers[j].lastHeard > now - _peers[i].lastHeard)
+		i = j;
+	if (_peers[i].address == _currentPeer)
+	    _currentPeer = RH_BROADCAST_ADDRESS;
+    }
+    Peer* p = &_peers[i];
+    p->address = address;
+    p->sf = _baseSF;
+    p->losses = 0;
+    p->historyLen = 0;
+    p->historyNext = 0;
+    p->lastHeard = millis();
+    return p;
+}
+
+void RHAdaptiveDataRate::useSpreadingFactor(uint8_t sf)
+{
+    if (sf != _currentSF)
+    {
+	_rf95.setSpreadingFactor(sf);
+	_currentSF = sf;
+    }
+}
+
+void RHAdaptiveDataRate::changeSpreadingFactor(Peer* p, uint8_t sf)
+{
+    if (p->sf != sf)
+	_adaptations++;
+    p->sf = sf;
+    p->losses = 0;
+    p->historyLen = 0;
+    p->historyNext = 0;
+    p->lastHeard = millis();
+}
+
+void RHAdaptiveDataRate::addSample(Peer* p)
+{
+    p->snr[p->historyNext] = _rf95.lastSNR();
+    p->rssi[p->historyNext] = _rf95.lastRssi();
+    p->historyNext = (p->historyNext + 1) % RH_ADR_HISTORY_LEN;
+    if (p->historyLen < RH_ADR_HISTORY_LEN)
+	p->historyLen++;
+}
+
+void RHAdaptiveDataRate::adapt(Peer* p)
+{
+    // Only the lower address of each link decides
+    if (_thisAddress > p->address || p->historyLen < RH_ADR_HISTORY_LEN)
+	return;
+
+    // The fastest spreading factor whose floor plus margin is at or below the best recent SNR
+    int16_t needed = RH_ADR_FLOOR(0) + 10 * _margin - 10 * peerSNR(p->address);
+    uint8_t sf = needed <= 25 * _minSF ? _minSF : (needed + 24) / 25;
+    if (sf > _maxSF)
+	sf = _maxSF;
+    if (sf == p->sf)
+	return;
+
+    uint8_t buf[2] = { RH_ADR_MESSAGE_TYPE_SET_SF, sf };
+    setHeaderFlags(RH_FLAGS_ADR_CONTROL, 0);
+    bool acked = RHReliableDatagram::sendtoWait(buf, sizeof(buf), p->address);
+    setHeaderFlags(RH_FLAGS_NONE, RH_FLAGS_ADR_CONTROL);
+    if (acked)
+    {
+	changeSpreadingFactor(p, sf);
+	useSpreadingFactor(sf);
+    }
+    // Else try again after the next frame from the peer
+}
+
+void RHAdaptiveDataRate::checkSilence()
+{
+    if (!_silenceTimeout || _currentPeer == RH_BROADCAST_ADDRESS || _currentSF == _baseSF)
+	return;
+    Peer* p = peer(_currentPeer, false);
+    if (p && millis() - p->lastHeard <= _silenceTimeout)
+	return;
+    if (p)
+	changeSpreadingFactor(p, _baseSF);
+    useSpreadingFactor(_baseSF);
+    _currentPeer = RH_BROADCAST_ADDRESS;
+}
@@ -0,0 +1,243 @@
+// RHAdaptiveDataRate.h
+//
+// Adaptive data rate control of the LoRa spreading factor for each peer of an RH_RF95.
+// Part of the RadioHead library
+
+#ifndef RHAdaptiveDataRate_h
+#define RHAdaptiveDataRate_h
+
+#include <RHReliableDatagram.h>
+#include <RH_RF95.h>
+
+/// The ADR control bit in the header FLAGS. This indicates that the payload is an
+/// ADR control message, not application data.
+#define RH_FLAGS_ADR_CONTROL 0x20
+
+// Types of ADR control message, the first octet of the payload
+#define RH_ADR_MESSAGE_TYPE_SET_SF      1
+
+// The max number of peers whose links are tracked at once.
+// When a new peer is seen, the one heard from least recently is forgotten
+#ifndef RH_ADR_MAX_PEERS
+ #define RH_ADR_MAX_PEERS               4
+#endif
+
+// The number of received frames from each peer whose SNR and RSSI are kept.
+// The spreading factor for a peer is only changed after this many frames have been received at the current one
+#ifndef RH_ADR_HISTORY_LEN
+ #define RH_ADR_HISTORY_LEN             8
+#endif
+
+// Default margin in dB required above the demodulation floor of the chosen spreading factor
+#define RH_ADR_DEFAULT_MARGIN           10
+
+// Default number of sendtoWait() failures in a row before falling back to the base spreading factor
+#define RH_ADR_DEFAULT_MAX_LOSSES       3
+
+/////////////////////////////////////////////////////////////////////
+/// \class RHAdaptiveDataRate RHAdaptiveDataRate.h <RHAdaptiveDataRate.h>
+/// \brief RHReliableDatagram subclass that chooses the fastest LoRa spreading factor
+/// each peer can reliably be reached with.
+///
+/// Manager class that extends RHReliableDatagram for use with RH_RF95. Every frame received from a peer,
+/// including the ACKs to messages sent by sendtoWait(), adds the SNR and RSSI measured by the radio
+/// to a short history for that peer. Once RH_ADR_HISTORY_LEN frames have been received, the fastest
+/// spreading factor whose demodulation floor (-7.5dB at SF7 down to -20dB at SF12, from the SX1276 datasheet)
+/// plus the margin set by setMargin() is below the best SNR in the history is chosen for that link, and an
+/// ADR control message is sent to the peer with sendtoWait() to tell it to change too.
+/// Nodes close to each other can then use SF7 instead of SF12, which takes about 1/30 of the airtime.
+///
+/// When sendtoWait() fails setMaxLosses() times in a row, the link falls back to the base spreading factor,
+/// which is the one the driver was configured with when init() was called. The peer falls back too,
+/// when its own messages fail, or if it does not hear from this node for the time set by setSilenceTimeout().
+///
+/// To prevent both ends of a link changing it at once, only the node with the lower address sends control messages
+/// on each link. In a star network this is usually the gateway. The other node follows.
+///
+/// The spreading factor for a peer is set in the driver before each message is sent to it, and the driver stays at that
+/// spreading factor afterwards, so it is ready for the reply. So RHAdaptiveDataRate suits point to point links and
+/// gateways that exchange messages with one node at a time. Both ends of each link must use RHAdaptiveDataRate,
+/// and call recvfromAck() or recvfromAckTimeout() frequently, since that is where control messages are processed.
+///
+/// The timeout set by setTimeout() must be long enough for an ACK at the slowest spreading factor in use.
+///
+/// \par Message Format
+///
+/// ADR control messages have the RH_FLAGS_ADR_CONTROL bit set in the header FLAGS, and are acknowledged like any other
+/// message. The payload is:
+/// - 1 octet TYPE, RH_ADR_MESSAGE_TYPE_SET_SF
+/// - 1 octet SF, the spreading factor to use on this link from now on, 6 to 12
+///
+/// The receiver of the control message changes after sending the ACK, and the sender after receiving it.
+class RHAdaptiveDataRate : public RHReliableDatagram
+{
+public:
+    /// \brief Defines the state of the link to one peer
+    typedef struct
+    {
+	uint8_t       address;                  ///< Address of the peer
+	uint8_t       sf;                       ///< Spreading factor used on the link
+	uint8_t       losses;                   ///< Number of sendtoWait() failures in a row
+	uint8_t       historyLen;               ///< Number of valid entries in snr and rssi
+	uint8_t       historyNext;              ///< Index of the next entry to write in snr and rssi
+	int8_t        snr[RH_ADR_HISTORY_LEN];  ///< SNR of recently received frames in dB
+	int16_t       rssi[RH_ADR_HISTORY_LEN]; ///< RSSI of recently received frames in dBm
+	unsigned long lastHeard;                ///< millis() when the last frame was received
+    } Peer;
+
+    /// Constructor.
+    /// \param[in] driver The RH_RF95 driver to use to transport messages.
+    /// \param[in] thisAddress The address to assign to this node. Defaults to 0
+    RHAdaptiveDataRate(RH_RF95& driver, uint8_t thisAddress = 0);
+
+    /// Initialise this instance and the driver connected to it.
+    /// The current spreading factor of the driver becomes the base spreading factor for all links.
+    /// Call after configuring the modem.
+    /// \return true if initialisation succeeded.
+    bool init();
+
+    /// Sets the margin in dB required above the demodulation floor of a spreading factor
+    /// before it is used. Higher margins make changes less likely to cause lost messages. Defaults to 10.
+    /// \param[in] margin The margin in dB
+    void setMargin(uint8_t margin);
+
+    /// Sets the range of spreading factors that may be chosen. Defaults to 7 to 12.
+    /// \param[in] minSF The fastest spreading factor that may be chosen, 6 to 12.
+    /// \param[in] maxSF The slowest spreading factor that may be chosen, 6 to 12.
+    void setSpreadingFactorRange(uint8_t minSF, uint8_t maxSF);
+
+    /// Sets the number of sendtoWait() failures in a row to a peer before the link to it falls back
+    /// to the base spreading factor. Defaults to 3.
+    /// \param[in] losses The number of failures
+    void setMaxLosses(uint8_t losses);
+
+    /// Sets how long the driver may listen at the spreading factor of a peer without hearing from it,
+    /// before falling back to the base spreading factor. Set this on nodes that do not send
+    /// regularly, so they do not miss the peer if it falls back. Defaults to 0, which disables it.
+    /// \param[in] timeout The time in milliseconds, or 0 to disable it
+    void setSilenceTimeout(unsigned long timeout);
+
+    /// Sends a message to the node(s) with the given address at the spreading factor chosen for the link,
+    /// and waits for an ACK, as RHReliableDatagram::sendtoWait(). The SNR and RSSI of the ACK are
+    /// added to the history of the peer, which may cause a control message to be sent to it.
+    /// Broadcasts are sent at the spreading factor currently set in the driver.
+    /// \param[in] buf Pointer to the binary message to send
+    /// \param[in] len Number of octets to send
+    /// \param[in] address The address to send the message to.
+    /// \return true if the message was acknowledged, or was broadcast.
+    bool sendtoWait(uint8_t* buf, uint8_t len, uint8_t address);
+
+    /// If there is a valid application message available for this node, sends an ACK to the
+    /// SRC address, copies the message to buf and returns true, as RHReliableDatagram::recvfromAck().
+    /// ADR control messages are processed and not returned.
+    /// \param[in] buf Location to copy the received message
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the SRC address
+    /// \param[in] to If present and not NULL, the referenced uint8_t will be set to the DEST address
+    /// \param[in] id If present and not NULL, the referenced uint8_t will be set to the ID
+    /// \param[in] flags If present and not NULL, the referenced uint8_t will be set to the FLAGS
+    /// \return true if a valid message was copied to buf
+    bool recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
+
+    /// Similar to recvfromAck(), but waits for up to timeout milliseconds for an application message.
+    /// \param[in] buf Location to copy the received message
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \param[in] timeout Maximum time to wait in milliseconds
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the SRC address
+    /// \param[in] to If present and not NULL, the referenced uint8_t will be set to the DEST address
+    /// \param[in] id If present and not NULL, the referenced uint8_t will be set to the ID
+    /// \param[in] flags If present and not NULL, the referenced uint8_t will be set to the FLAGS
+    /// \return true if a valid message was copied to buf
+    bool recvfromAckTimeout(uint8_t* buf, uint8_t* len,  uint16_t timeout, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
+
+    /// Returns the spreading factor used on the link to a peer.
+    /// \param[in] address The address of the peer
+    /// \return The spreading factor, or the base spreading factor if the peer is not known
+    uint8_t peerSpreadingFactor(uint8_t address);
+
+    /// Returns the best SNR of the recent frames from a peer, which is what the spreading factor is chosen from.
+    /// \param[in] address The address of the peer
+    /// \return The SNR in dB, or -128 if nothing has been received from the peer at its current spreading factor
+    int8_t  peerSNR(uint8_t address);
+
+    /// Returns the mean RSSI of the recent frames from a peer.
+    /// \param[in] address The address of the peer
+    /// \return The RSSI in dBm, or 0 if nothing has been received from the peer at its current spreading factor
+    int16_t peerRssi(uint8_t address);
+
+    /// Returns the number of times the spreading factor of a link has been changed,
+    /// by control messages or fallbacks, since the last call to resetAdaptations()
+    /// \return The number of changes
+    uint32_t adaptations();
+
+    /// Resets the count of spreading factor changes
+    void resetAdaptations();
+
+protected:
+    /// Finds the state of the link to a peer.
+    /// \param[in] address The address of the peer
+    /// \param[in] create If true and the peer is not known, forgets the least recently heard peer to make room for it
+    /// \return The state of the link, or NULL if the peer is not known and create is false
+    Peer*   peer(uint8_t address, bool create);
+
+    /// Sets the spreading factor in the driver, if it is not already set.
+    /// \param[in] sf The spreading factor
+    void    useSpreadingFactor(uint8_t sf);
+
+    /// Changes the spreading factor of the link to a peer and clears its history.
+    /// \param[in] p The peer
+    /// \param[in] sf The new spreading factor
+    void    changeSpreadingFactor(Peer* p, uint8_t sf);
+
+    /// Adds the SNR and RSSI of the last frame received by the driver to the history of a peer.
+    /// \param[in] p The peer
+    void    addSample(Peer* p);
+
+    /// If this node controls the link to a peer and its history is full, chooses the fastest adequate
+    /// spreading factor for it, and if it is different sends a control message to the peer.
+    /// \param[in] p The peer
+    void    adapt(Peer* p);
+
+    /// Falls back to the base spreading factor if the peer whose spreading factor the driver
+    /// is using has not been heard for longer than the silence timeout
+    void    checkSilence();
+
+private:
+    /// The driver, for access to the LoRa modem settings
+    RH_RF95&      _rf95;
+
+    /// State of the links to known peers
+    Peer          _peers[RH_ADR_MAX_PEERS];
+
+    /// Number of valid entries in _peers
+    uint8_t       _numPeers;
+
+    /// The spreading factor every link starts with
+    uint8_t       _baseSF;
+
+    /// The spreading factor currently set in the driver
+    uint8_t       _currentSF;
+
+    /// The address of the peer whose spreading factor is set in the driver, or RH_BROADCAST_ADDRESS
+    uint8_t       _currentPeer;
+
+    /// Fastest spreading factor that may be chosen
+    uint8_t       _minSF;
+
+    /// Slowest spreading factor that may be chosen
+    uint8_t       _maxSF;
+
+    /// Margin in dB above the demodulation floor
+    uint8_t       _margin;
+
+    /// Number of failures in a row before falling back
+    uint8_t       _maxLosses;
+
+    /// Time in milliseconds without hearing from _currentPeer before falling back, or 0
+    unsigned long _silenceTimeout;
+
+    /// Count of spreading factor changes
+    uint32_t      _adaptations;
+};
+
+#endif
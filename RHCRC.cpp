@@ -45,6 +45,8 @@
 #define lo8(x) ((x)&0xff) 
 #define hi8(x) ((x)>>8)
 
+#if (RH_CRC_METHOD == RH_CRC_BITWISE)
+
 uint16_t RHcrc16_update(uint16_t crc, uint8_t a)
 {
     int i;
@@ -101,4 +103,317 @@ uint8_t RHcrc_ibutton_update(uint8_t crc, uint8_t data)
     return crc;
 }
 
+#else // RH_CRC_TABLE or RH_CRC_SLICE8
+
+#if defined(__AVR__)
+ #include <avr/pgmspace.h>
+ #define RH_CRC_TABLE_ATTR PROGMEM
+ #define RH_CRC_READ16(t, i) pgm_read_word(&(t)[i])
+ #define RH_CRC_READ8(t, i)  pgm_read_byte(&(t)[i])
+#else
+ #define RH_CRC_TABLE_ATTR
+ #define RH_CRC_READ16(t, i) ((t)[i])
+ #define RH_CRC_READ8(t, i)  ((t)[i])
+#endif
+
+// Reflected polynomial 0xA001
+static const uint16_t crc16_table[256] RH_CRC_TABLE_ATTR =
+{
+    0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241,
+    0xc601, 0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440,
+    0xcc01, 0x0cc0, 0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40,
+    0x0a00, 0xcac1, 0xcb81, 0x0b40, 0xc901, 0x09c0, 0x0880, 0xc841,
+    0xd801, 0x18c0, 0x1980, 0xd941, 0x1b00, 0xdbc1, 0xda81, 0x1a40,
+    0x1e00, 0xdec1, 0xdf81, 0x1f40, 0xdd01, 0x1dc0, 0x1c80, 0xdc41,
+    0x1400, 0xd4c1, 0xd581, 0x1540, 0xd701, 0x17c0, 0x1680, 0xd641,
+    0xd201, 0x12c0, 0x1380, 0xd341, 0x1100, 0xd1c1, 0xd081, 0x1040,
+    0xf001, 0x30c0, 0x3180, 0xf141, 0x3300, 0xf3c1, 0xf281, 0x3240,
+    0x3600, 0xf6c1, 0xf781, 0x3740, 0xf501, 0x35c0, 0x3480, 0xf441,
+    0x3c00, 0xfcc1, 0xfd81, 0x3d40, 0xff01, 0x3fc0, 0x3e80, 0xfe41,
+    0xfa01, 0x3ac0, 0x3b80, 0xfb41, 0x3900, 0xf9c1, 0xf881, 0x3840,
+    0x2800, 0xe8c1, 0xe981, 0x2940, 0xeb01, 0x2bc0, 0x2a80, 0xea41,
+    0xee01, 0x2ec0, 0x2f80, 0xef41, 0x2d00, 0xedc1, 0xec81, 0x2c40,
+    0xe401, 0x24c0, 0x2580, 0xe541, 0x2700, 0xe7c1, 0xe681, 0x2640,
+    0x2200, 0xe2c1, 0xe381, 0x2340, 0xe101, 0x21c0, 0x2080, 0xe041,
+    0xa001, 0x60c0, 0x6180, 0xa141, 0x6300, 0xa3c1, 0xa281, 0x6240,
+    0x6600, 0xa6c1, 0xa781, 0x6740, 0xa501, 0x65c0, 0x6480, 0xa441,
+    0x6c00, 0xacc1, 0xad81, 0x6d40, 0xaf01, 0x6fc0, 0x6e80, 0xae41,
+    0xaa01, 0x6ac0, 0x6b80, 0xab41, 0x6900, 0xa9c1, 0xa881, 0x6840,
+    0x7800, 0xb8c1, 0xb981, 0x7940, 0xbb01, 0x7bc0, 0x7a80, 0xba41,
+    0xbe01, 0x7ec0, 0x7f80, 0xbf41, 0x7d00, 0xbdc1, 0xbc81, 0x7c40,
+    0xb401, 0x74c0, 0x7580, 0xb541, 0x7700, 0xb7c1, 0xb681, 0x7640,
+    0x7200, 0xb2c1, 0xb381, 0x7340, 0xb101, 0x71c0, 0x7080, 0xb041,
+    0x5000, 0x90c1, 0x9181, 0x5140, 0x9301, 0x53c0, 0x5280, 0x9241,
+    0x9601, 0x56c0, 0x5780, 0x9741, 0x5500, 0x95c1, 0x9481, 0x5440,
+    0x9c01, 0x5cc0, 0x5d80, 0x9d41, 0x5f00, 0x9fc1, 0x9e81, 0x5e40,
+    0x5a00, 0x9ac1, 0x9b81, 0x5b40, 0x9901, 0x59c0, 0x5880, 0x9841,
+    0x8801, 0x48c0, 0x4980, 0x8941, 0x4b00, 0x8bc1, 0x8a81, 0x4a40,
+    0x4e00, 0x8ec1, 0x8f81, 0x4f40, 0x8d01, 0x4dc0, 0x4c80, 0x8c41,
+    0x4400, 0x84c1, 0x8581, 0x4540, 0x8701, 0x47c0, 0x4680, 0x8641,
+    0x8201, 0x42c0, 0x4380, 0x8341, 0x4100, 0x81c1, 0x8081, 0x4040
+};
+
+// Polynomial 0x1021, MSB first
+static const uint16_t crc_xmodem_table[256] RH_CRC_TABLE_ATTR =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
+};
+
+// Reflected polynomial 0x8408
+static const uint16_t crc_ccitt_table[256] RH_CRC_TABLE_ATTR =
+{
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+};
+
+// Reflected polynomial 0x8C
+static const uint8_t crc_ibutton_table[256] RH_CRC_TABLE_ATTR =
+{
+    0x00, 0x5e, 0xbc, 0xe2, 0x61, 0x3f, 0xdd, 0x83,
+    0xc2, 0x9c, 0x7e, 0x20, 0xa3, 0xfd, 0x1f, 0x41,
+    0x9d, 0xc3, 0x21, 0x7f, 0xfc, 0xa2, 0x40, 0x1e,
+    0x5f, 0x01, 0xe3, 0xbd, 0x3e, 0x60, 0x82, 0xdc,
+    0x23, 0x7d, 0x9f, 0xc1, 0x42, 0x1c, 0xfe, 0xa0,
+    0xe1, 0xbf, 0x5d, 0x03, 0x80, 0xde, 0x3c, 0x62,
+    0xbe, 0xe0, 0x02, 0x5c, 0xdf, 0x81, 0x63, 0x3d,
+    0x7c, 0x22, 0xc0, 0x9e, 0x1d, 0x43, 0xa1, 0xff,
+    0x46, 0x18, 0xfa, 0xa4, 0x27, 0x79, 0x9b, 0xc5,
+    0x84, 0xda, 0x38, 0x66, 0xe5, 0xbb, 0x59, 0x07,
+    0xdb, 0x85, 0x67, 0x39, 0xba, 0xe4, 0x06, 0x58,
+    0x19, 0x47, 0xa5, 0xfb, 0x78, 0x26, 0xc4, 0x9a,
+    0x65, 0x3b, 0xd9, 0x87, 0x04, 0x5a, 0xb8, 0xe6,
+    0xa7, 0xf9, 0x1b, 0x45, 0xc6, 0x98, 0x7a, 0x24,
+    0xf8, 0xa6, 0x44, 0x1a, 0x99, 0xc7, 0x25, 0x7b,
+    0x3a, 0x64, 0x86, 0xd8, 0x5b, 0x05, 0xe7, 0xb9,
+    0x8c, 0xd2, 0x30, 0x6e, 0xed, 0xb3, 0x51, 0x0f,
+    0x4e, 0x10, 0xf2, 0xac, 0x2f, 0x71, 0x93, 0xcd,
+    0x11, 0x4f, 0xad, 0xf3, 0x70, 0x2e, 0xcc, 0x92,
+    0xd3, 0x8d, 0x6f, 0x31, 0xb2, 0xec, 0x0e, 0x50,
+    0xaf, 0xf1, 0x13, 0x4d, 0xce, 0x90, 0x72, 0x2c,
+    0x6d, 0x33, 0xd1, 0x8f, 0x0c, 0x52, 0xb0, 0xee,
+    0x32, 0x6c, 0x8e, 0xd0, 0x53, 0x0d, 0xef, 0xb1,
+    0xf0, 0xae, 0x4c, 0x12, 0x91, 0xcf, 0x2d, 0x73,
+    0xca, 0x94, 0x76, 0x28, 0xab, 0xf5, 0x17, 0x49,
+    0x08, 0x56, 0xb4, 0xea, 0x69, 0x37, 0xd5, 0x8b,
+    0x57, 0x09, 0xeb, 0xb5, 0x36, 0x68, 0x8a, 0xd4,
+    0x95, 0xcb, 0x29, 0x77, 0xf4, 0xaa, 0x48, 0x16,
+    0xe9, 0xb7, 0x55, 0x0b, 0x88, 0xd6, 0x34, 0x6a,
+    0x2b, 0x75, 0x97, 0xc9, 0x4a, 0x14, 0xf6, 0xa8,
+    0x74, 0x2a, 0xc8, 0x96, 0x15, 0x4b, 0xa9, 0xf7,
+    0xb6, 0xe8, 0x0a, 0x54, 0xd7, 0x89, 0x6b, 0x35
+};
+
+uint16_t RHcrc16_update(uint16_t crc, uint8_t a)
+{
+    return (crc >> 8) ^ RH_CRC_READ16(crc16_table, lo8(crc ^ a));
+}
+
+uint16_t RHcrc_xmodem_update (uint16_t crc, uint8_t data)
+{
+    return (crc << 8) ^ RH_CRC_READ16(crc_xmodem_table, hi8(crc) ^ data);
+}
+
+uint16_t RHcrc_ccitt_update (uint16_t crc, uint8_t data)
+{
+    return (crc >> 8) ^ RH_CRC_READ16(crc_ccitt_table, lo8(crc ^ data));
+}
+
+uint8_t RHcrc_ibutton_update(uint8_t crc, uint8_t data)
+{
+    return RH_CRC_READ8(crc_ibutton_table, crc ^ data);
+}
+
+#endif
+
+#if (RH_CRC_METHOD == RH_CRC_SLICE8)
+
+// _slice[k][i] is the CRC of octet i followed by k zero octets, so 8 octets
+// can be folded in at once, each with its own table.
+// _slice[0] is a copy of the 256 entry table, for locality
+static uint16_t crc16_slice[8][256];
+static uint16_t crc_xmodem_slice[8][256];
+static uint16_t crc_ccitt_slice[8][256];
+static uint8_t  crc_ibutton_slice[8][256];
+
+// Builds the slice tables before main() runs, so there are no races between threads
+static struct RHcrcSliceInit
+{
+    RHcrcSliceInit()
+    {
+	uint16_t i;
+	uint8_t k;
+	for (i = 0; i < 256; i++)
+	{
+	    crc16_slice[0][i] = crc16_table[i];
+	    crc_xmodem_slice[0][i] = crc_xmodem_table[i];
+	    crc_ccitt_slice[0][i] = crc_ccitt_table[i];
+	    crc_ibutton_slice[0][i] = crc_ibutton_table[i];
+	}
+	for (k = 1; k < 8; k++)
+	{
+	    for (i = 0; i < 256; i++)
+	    {
+		uint16_t c = crc16_slice[k - 1][i];
+		crc16_slice[k][i] = (c >> 8) ^ crc16_slice[0][lo8(c)];
+		c = crc_xmodem_slice[k - 1][i];
+		crc_xmodem_slice[k][i] = (c << 8) ^ crc_xmodem_slice[0][hi8(c)];
+		c = crc_ccitt_slice[k - 1][i];
+		crc_ccitt_slice[k][i] = (c >> 8) ^ crc_ccitt_slice[0][lo8(c)];
+		crc_ibutton_slice[k][i] = crc_ibutton_slice[0][crc_ibutton_slice[k - 1][i]];
+	    }
+	}
+    }
+} crcSliceInit;
+
+// Slice-by-8 for the reflected 16 bit CRCs
+static uint16_t crc16_reflected_slice8(uint16_t (*t)[256], uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len >= 8)
+    {
+	crc ^= buf[0] | ((uint16_t)buf[1] << 8);
+	crc = t[7][lo8(crc)] ^ t[6][hi8(crc)]
+	    ^ t[5][buf[2]] ^ t[4][buf[3]] ^ t[3][buf[4]]
+	    ^ t[2][buf[5]] ^ t[1][buf[6]] ^ t[0][buf[7]];
+	buf += 8;
+	len -= 8;
+    }
+    while (len--)
+	crc = (crc >> 8) ^ t[0][lo8(crc ^ *buf++)];
+    return crc;
+}
+
+uint16_t RHcrc16_buf(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    return crc16_reflected_slice8(crc16_slice, crc, buf, len);
+}
+
+uint16_t RHcrc_xmodem_buf(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    uint16_t (*t)[256] = crc_xmodem_slice;
+    while (len >= 8)
+    {
+	crc ^= ((uint16_t)buf[0] << 8) | buf[1];
+	crc = t[7][hi8(crc)] ^ t[6][lo8(crc)]
+	    ^ t[5][buf[2]] ^ t[4][buf[3]] ^ t[3][buf[4]]
+	    ^ t[2][buf[5]] ^ t[1][buf[6]] ^ t[0][buf[7]];
+	buf += 8;
+	len -= 8;
+    }
+    while (len--)
+	crc = (crc << 8) ^ t[0][hi8(crc) ^ *buf++];
+    return crc;
+}
+
+uint16_t RHcrc_ccitt_buf(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    return crc16_reflected_slice8(crc_ccitt_slice, crc, buf, len);
+}
+
+uint8_t RHcrc_ibutton_buf(uint8_t crc, const uint8_t* buf, uint16_t len)
+{
+    uint8_t (*t)[256] = crc_ibutton_slice;
+    while (len >= 8)
+    {
+	crc = t[7][crc ^ buf[0]] ^ t[6][buf[1]]
+	    ^ t[5][buf[2]] ^ t[4][buf[3]] ^ t[3][buf[4]]
+	    ^ t[2][buf[5]] ^ t[1][buf[6]] ^ t[0][buf[7]];
+	buf += 8;
+	len -= 8;
+    }
+    while (len--)
+	crc = t[0][crc ^ *buf++];
+    return crc;
+}
+
+#else // RH_CRC_BITWISE or RH_CRC_TABLE: 1 octet at a time
+
+uint16_t RHcrc16_buf(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc16_update(crc, *buf++);
+    return crc;
+}
+
+uint16_t RHcrc_xmodem_buf(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc_xmodem_update(crc, *buf++);
+    return crc;
+}
+
+uint16_t RHcrc_ccitt_buf(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc_ccitt_update(crc, *buf++);
+    return crc;
+}
+
+uint8_t RHcrc_ibutton_buf(uint8_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc_ibutton_update(crc, *buf++);
+    return crc;
+}
 
+#endif
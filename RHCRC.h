@@ -11,9 +11,35 @@
 
 #include <RadioHead.h>
 
+// Ways of computing the CRCs, selected at compile time with RH_CRC_METHOD
+// Bit at a time: smallest code and no tables. Best for AVR and MSP430
+#define RH_CRC_BITWISE 0
+// 256 entry table per CRC, in flash, 1 lookup per octet
+#define RH_CRC_TABLE   1
+// Slice-by-8: 8 tables per CRC built in RAM at startup, 8 octets per step. For Linux hosts
+#define RH_CRC_SLICE8  2
+
+#ifndef RH_CRC_METHOD
+ #if (RH_PLATFORM == RH_PLATFORM_UNIX || RH_PLATFORM == RH_PLATFORM_RASPI)
+  #define RH_CRC_METHOD RH_CRC_SLICE8
+ #elif defined(__AVR__) || (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8) || (RH_PLATFORM == RH_PLATFORM_ATTINY) || (RH_PLATFORM == RH_PLATFORM_ATTINY_MEGA) || (RH_PLATFORM == RH_PLATFORM_MSP430)
+  #define RH_CRC_METHOD RH_CRC_BITWISE
+ #else
+  #define RH_CRC_METHOD RH_CRC_TABLE
+ #endif
+#endif
+
+// Update the CRC with one octet
 extern uint16_t RHcrc16_update(uint16_t crc, uint8_t a);
 extern uint16_t RHcrc_xmodem_update (uint16_t crc, uint8_t data);
 extern uint16_t RHcrc_ccitt_update (uint16_t crc, uint8_t data);
 extern uint8_t  RHcrc_ibutton_update(uint8_t crc, uint8_t data);
 
+// Update the CRC with len octets from buf. Same result as calling the _update function for each octet,
+// but faster with RH_CRC_TABLE and RH_CRC_SLICE8
+extern uint16_t RHcrc16_buf(uint16_t crc, const uint8_t* buf, uint16_t len);
+extern uint16_t RHcrc_xmodem_buf(uint16_t crc, const uint8_t* buf, uint16_t len);
+extern uint16_t RHcrc_ccitt_buf(uint16_t crc, const uint8_t* buf, uint16_t len);
+extern uint8_t  RHcrc_ibutton_buf(uint8_t crc, const uint8_t* buf, uint16_t len);
+
 #endif
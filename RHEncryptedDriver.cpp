@@ -12,10 +12,60 @@ RHEncryptedDriver::RHEncryptedDriver(RHGenericDriver& driver, BlockCipher& block
       _blockcipher(blockcipher)
 {
     _buffer = (uint8_t *)calloc(_driver.maxMessageLength(), sizeof(uint8_t));
+    _tagLen = 0;
+    _txCounter = 0;
+    _rxRejected = 0;
+    memset(_replay, 0, sizeof(_replay));
+    _replayNext = 0;
+    _hardware = false;
+    _hardwareAllowed = false;
+}
+
+bool RHEncryptedDriver::setAEAD(uint8_t tagLen)
+{
+    if (tagLen && (   _blockcipher.blockSize() != RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN
+		   || tagLen < 4 || tagLen > 16 || (tagLen & 1)))
+	return false;
+    if (tagLen && _hardware)
+    {
+	// The radio cant do CCM
+	_driver.setHardwareEncryption(NULL, 0);
+	_hardware = false;
+    }
+    _tagLen = tagLen;
+    return true;
+}
+
+void RHEncryptedDriver::setHardwareAes(bool enable)
+{
+    _hardwareAllowed = enable;
+    if (!enable && _hardware)
+    {
+	// The cipher already has the key
+	_driver.setHardwareEncryption(NULL, 0);
+	_hardware = false;
+    }
+}
+
+bool RHEncryptedDriver::setKey(const uint8_t* key, uint8_t len)
+{
+    if (!_blockcipher.setKey(key, len))
+	return false;
+    // Let the radio do the work if we are allowed to and it can
+    _hardware =    _hardwareAllowed && !_tagLen && _blockcipher.blockSize() == 16
+	        && _driver.setHardwareEncryption(key, len);
+    if (!_hardware)
+	_driver.setHardwareEncryption(NULL, 0);
+    return true;
 }
 
 bool RHEncryptedDriver::recv(uint8_t* buf, uint8_t* len)
 {
+    if (_hardware)
+	return _driver.recv(buf, len);
+    if (_tagLen)
+	return recvAEAD(buf, len);
+
     int h = 0; // Index of output _buffer
 
     bool status = _driver.recv(_buffer, len);
@@ -52,6 +102,10 @@ bool RHEncryptedDriver::send(const uint8_t* data, uint8_t len)
 {
     if (len > maxMessageLength())
 	return false;
+    if (_hardware)
+	return _driver.send(data, len);
+    if (_tagLen)
+	return sendAEAD(data, len);
     
     bool status = true;
     int blockSize = _blockcipher.blockSize(); // Size of blocks used by encryption
@@ -142,6 +196,11 @@ uint8_t RHEncryptedDriver::maxMessageLength()
 {
     int driver_len = _driver.maxMessageLength();
     
+    if (_hardware)
+	return driver_len;
+    if (_tagLen)
+	return driver_len > RH_ENCRYPTED_DRIVER_COUNTER_LEN + _tagLen ? driver_len - RH_ENCRYPTED_DRIVER_COUNTER_LEN - _tagLen : 0;
+
 #ifndef ALLOW_MULTIPLE_MSG
     driver_len = ((int)(driver_len/_blockcipher.blockSize()) ) * _blockcipher.blockSize();
 #endif
@@ -152,4 +211,183 @@ uint8_t RHEncryptedDriver::maxMessageLength()
     return driver_len;
 }
 
+// AES-CCM as in RFC 3610, with a 13 octet nonce (so L = 2) and the 4 headers as additional data
+void RHEncryptedDriver::ccmNonce(uint8_t* block, uint8_t from, uint8_t id, uint32_t counter)
+{
+    memset(block, 0, RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN);
+    block[0] = 1; // L - 1
+    block[1] = from;
+    block[2] = id;
+    block[3] = counter >> 24;
+    block[4] = counter >> 16;
+    block[5] = counter >> 8;
+    block[6] = counter;
+    // The rest of the nonce and the block counter are 0
+}
+
+void RHEncryptedDriver::ccmMac(const uint8_t* nonce, const uint8_t* aad, const uint8_t* data, uint8_t len, uint8_t* mac)
+{
+    uint8_t i;
+
+    // B_0: flags, nonce, message length. Adata, M' and L' in the flags
+    memcpy(mac, nonce, RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN);
+    mac[0] = 0x40 | (((_tagLen - 2) / 2) << 3) | 1;
+    mac[14] = 0;
+    mac[15] = len;
+    _blockcipher.encryptBlock(mac, mac);
+
+    // B_1: length of the additional data, the 4 headers, padded with 0
+    mac[1] ^= 4;
+    for (i = 0; i < 4; i++)
+	mac[2 + i] ^= aad[i];
+    _blockcipher.encryptBlock(mac, mac);
+
+    // The message, padded with 0
+    while (len)
+    {
+	uint8_t n = len < RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN ? len : RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN;
+	for (i = 0; i < n; i++)
+	    mac[i] ^= data[i];
+	_blockcipher.encryptBlock(mac, mac);
+	data += n;
+	len -= n;
+    }
+}
+
+void RHEncryptedDriver::ccmCrypt(const uint8_t* nonce, uint8_t* data, uint8_t len, uint8_t* tag)
+{
+    uint8_t a[RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN];
+    uint8_t s[RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN];
+    uint8_t i;
+
+    memcpy(a, nonce, sizeof(a));
+    // S_0 encrypts the tag
+    _blockcipher.encryptBlock(s, a);
+    for (i = 0; i < _tagLen; i++)
+	tag[i] ^= s[i];
+    // S_1 onwards encrypt the message
+    while (len)
+    {
+	a[15]++; // At most 16 blocks, so never carries
+	_blockcipher.encryptBlock(s, a);
+	uint8_t n = len < RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN ? len : RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN;
+	for (i = 0; i < n; i++)
+	    data[i] ^= s[i];
+	data += n;
+	len -= n;
+    }
+}
+
+bool RHEncryptedDriver::sendAEAD(const uint8_t* data, uint8_t len)
+{
+    if (_txCounter == 0xffffffff)
+	return false; // Counter exhausted, a new key is needed
+
+    uint32_t counter = ++_txCounter;
+    uint8_t nonce[RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN];
+    uint8_t mac[RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN];
+    uint8_t aad[4] = { _txHeaderTo, _txHeaderFrom, _txHeaderId, _txHeaderFlags };
+    uint8_t* payload = &_buffer[RH_ENCRYPTED_DRIVER_COUNTER_LEN];
+
+    _buffer[0] = counter >> 24;
+    _buffer[1] = counter >> 16;
+    _buffer[2] = counter >> 8;
+    _buffer[3] = counter;
+    memcpy(payload, data, len);
+    ccmNonce(nonce, _txHeaderFrom, _txHeaderId, counter);
+    ccmMac(nonce, aad, payload, len, mac);
+    ccmCrypt(nonce, payload, len, mac);
+    memcpy(payload + len, mac, _tagLen);
+    return _driver.send(_buffer, RH_ENCRYPTED_DRIVER_COUNTER_LEN + len + _tagLen);
+}
+
+bool RHEncryptedDriver::recvAEAD(uint8_t* buf, uint8_t* len)
+{
+    uint8_t rxLen = _driver.maxMessageLength(); // Size of _buffer
+    if (!_driver.recv(_buffer, &rxLen))
+	return false;
+    if (rxLen < RH_ENCRYPTED_DRIVER_COUNTER_LEN + _tagLen)
+    {
+	_rxRejected++;
+	return false;
+    }
+
+    uint8_t from = _driver.headerFrom();
+    uint8_t id = _driver.headerId();
+    uint32_t counter = ((uint32_t)_buffer[0] << 24) | ((uint32_t)_buffer[1] << 16) | ((uint32_t)_buffer[2] << 8) | _buffer[3];
+    if (!isFresh(from, counter))
+    {
+	_rxRejected++;
+	return false;
+    }
+
+    uint8_t nonce[RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN];
+    uint8_t mac[RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN];
+    uint8_t aad[4] = { _driver.headerTo(), from, id, _driver.headerFlags() };
+    uint8_t payloadLen = rxLen - RH_ENCRYPTED_DRIVER_COUNTER_LEN - _tagLen;
+    uint8_t* payload = &_buffer[RH_ENCRYPTED_DRIVER_COUNTER_LEN];
+    uint8_t* tag = payload + payloadLen;
+
+    ccmNonce(nonce, from, id, counter);
+    ccmCrypt(nonce, payload, payloadLen, tag); // Decrypts the message and the tag
+    ccmMac(nonce, aad, payload, payloadLen, mac);
+    uint8_t diff = 0, i;
+    for (i = 0; i < _tagLen; i++)
+	diff |= mac[i] ^ tag[i]; // Constant time compare
+    if (diff)
+    {
+	_rxRejected++;
+	return false;
+    }
+    markSeen(from, counter);
+
+    if (buf && len)
+    {
+	if (*len > payloadLen)
+	    *len = payloadLen;
+	memcpy(buf, payload, *len);
+    }
+    return true;
+}
+
+RHEncryptedDriver::ReplayEntry* RHEncryptedDriver::replayEntry(uint8_t from, bool create)
+{
+    uint8_t i;
+    for (i = 0; i < RH_ENCRYPTED_DRIVER_REPLAY_SENDERS; i++)
+	if (_replay[i].valid && _replay[i].from == from)
+	    return &_replay[i];
+    if (!create)
+	return NULL;
+    // Take over the oldest entry
+    ReplayEntry* e = &_replay[_replayNext];
+    _replayNext = (_replayNext + 1) % RH_ENCRYPTED_DRIVER_REPLAY_SENDERS;
+    e->from = from;
+    e->valid = 1;
+    e->counter = 0;
+    e->window = 0;
+    return e;
+}
+
+bool RHEncryptedDriver::isFresh(uint8_t from, uint32_t counter)
+{
+    ReplayEntry* e = replayEntry(from, false);
+    if (!e || counter > e->counter)
+	return true;
+    uint32_t age = e->counter - counter;
+    return age < 32 && !(e->window & ((uint32_t)1 << age));
+}
+
+void RHEncryptedDriver::markSeen(uint8_t from, uint32_t counter)
+{
+    ReplayEntry* e = replayEntry(from, true);
+    if (counter > e->counter)
+    {
+	uint32_t shift = counter - e->counter;
+	e->window = shift < 32 ? (e->window << shift) | 1 : 1;
+	e->counter = counter;
+    }
+    else
+	e->window |= (uint32_t)1 << (e->counter - counter);
+}
+
 #endif
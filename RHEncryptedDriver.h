@@ -26,6 +26,18 @@
 // With STRICT_CONTENT_LEN, receiver will try to extract length from every message !!!!
 //#define ALLOW_MULTIPLE_MSG  
 
+// Length of the clear text frame counter at the start of each message in AEAD mode
+#define RH_ENCRYPTED_DRIVER_COUNTER_LEN  4
+
+// Block size of the cipher required for AEAD mode (AES-CCM)
+#define RH_ENCRYPTED_DRIVER_CCM_BLOCK_LEN 16
+
+// Number of senders whose frame counters are remembered for replay rejection in AEAD mode.
+// Increase this on a gateway that hears from many nodes
+#ifndef RH_ENCRYPTED_DRIVER_REPLAY_SENDERS
+ #define RH_ENCRYPTED_DRIVER_REPLAY_SENDERS 8
+#endif
+
 /////////////////////////////////////////////////////////////////////
 /// \class RHEncryptedDriver RHEncryptedDriver <RHEncryptedDriver.h>
 /// \brief Virtual Driver to encrypt/decrypt data. Can be used with any other RadioHead driver.
@@ -40,6 +52,42 @@
 /// In order to enable this module you must uncomment #define RH_ENABLE_ENCRYPTION_MODULE at the bottom of RadioHead.h
 /// But ensure you have installed the Crypto directory from arduinolibs first:
 /// http://rweather.github.io/arduinolibs/index.html
+///
+/// By default each block of the message is encrypted on its own (ECB), so identical messages give identical
+/// ciphertext, and corrupted or forged messages are not detected.
+///
+/// \par Hardware Encryption
+///
+/// If the cipher is AES128, you can call setHardwareAes(true) and then set the key with setKey() (rather than
+/// on the cipher itself). If the radio supports on-chip AES with that length of key (such as RH_RF69),
+/// the radio does the encryption instead, and messages pass straight through this driver with no encryption
+/// cost on the host. Otherwise the cipher is used as usual. Hardware encryption is off by default, because the
+/// radio always uses AES: enabling it with any other cipher (even one with a 16 octet key, such as Speck)
+/// would silently change the cipher, and nodes using the software cipher could not decrypt the messages.
+/// Caution: the radio's encryption is not compatible with the software one, so all nodes must 
+/// use the same radio type and setup. The radio's payload limit for encryption is reflected in
+/// maxMessageLength(), so use RHFragmentedDatagram if you need to send larger messages.
+/// AEAD mode is always done in software, so call setKey() after setAEAD().
+///
+/// \par AEAD Mode
+///
+/// If you call setAEAD() with a cipher of 16 octet blocks (such as AES128 or AES256), messages are instead
+/// encrypted and authenticated with AES-CCM (RFC 3610). Each message is sent as:
+/// - 4 octets frame counter, in network byte order, incremented for every message sent
+/// - the encrypted message, the same length as the original (no padding)
+/// - a tag of 4 to 16 octets, as set with setAEAD()
+///
+/// The 13 octet CCM nonce is made from the FROM and ID headers and the frame counter, and the TO, FROM, ID and
+/// FLAGS headers are authenticated along with the message. Received messages that fail authentication, or whose
+/// frame counter has been seen before from the same sender, are silently dropped and counted by rxRejected().
+/// Up to 32 frames from a sender may arrive out of order. Counters are remembered for the last
+/// RH_ENCRYPTED_DRIVER_REPLAY_SENDERS senders.
+///
+/// Caution: the frame counter must never repeat with the same key, or the encryption is broken. It starts at 0
+/// each time the node restarts, so for a fixed key you should save txCounter() in non-volatile memory from time to time,
+/// and restore it with setTxCounter() (plus a margin) at startup.
+///
+/// The AEAD mode does no memory allocation after construction.
 
 class RHEncryptedDriver : public RHGenericDriver
 {
@@ -74,6 +122,45 @@ public:
     /// \return true if a valid message was copied to buf
     virtual bool recv(uint8_t* buf, uint8_t* len);
 
+    /// Enables or disables the authenticated encryption (AES-CCM) mode described above.
+    /// Both sender and receiver must use the same mode and tag length.
+    /// \param[in] tagLen Length of the authentication tag in octets: 4, 6, 8, 10, 12, 14 or 16.
+    /// 0 returns to the default ECB mode.
+    /// \return true if the mode was set, false if tagLen is invalid or the cipher does not have 16 octet blocks
+    bool setAEAD(uint8_t tagLen);
+
+    /// Allows the radio to do the encryption instead of the cipher, see "Hardware Encryption" above.
+    /// Only valid when the cipher is AES128, since the radio always uses AES.
+    /// Call before setKey(). Disabling it takes effect immediately, using the cipher with the key already set.
+    /// \param[in] enable true to allow hardware encryption. The default is false.
+    void setHardwareAes(bool enable);
+
+    /// Sets the key for the cipher. If hardware encryption has been allowed with setHardwareAes(),
+    /// the transport driver supports hardware encryption with this length of key 
+    /// (see RHGenericDriver::setHardwareEncryption()) and AEAD mode is not enabled, 
+    /// the radio does the encryption instead of the cipher.
+    /// \param[in] key The key
+    /// \param[in] len Length of the key in octets
+    /// \return true if the key was accepted by the cipher
+    bool setKey(const uint8_t* key, uint8_t len);
+
+    /// Tells whether the radio is doing the encryption, see setKey()
+    /// \return true if encryption is done by the radio hardware
+    bool hardwareEncryption() { return _hardware;};
+
+    /// Returns the frame counter of the last message sent in AEAD mode
+    /// \return The frame counter
+    uint32_t txCounter() { return _txCounter; };
+
+    /// Sets the frame counter for messages sent in AEAD mode. The next message is sent with counter + 1.
+    /// \param[in] counter The new frame counter
+    void setTxCounter(uint32_t counter) { _txCounter = counter; };
+
+    /// Returns the count of messages dropped in AEAD mode because they were too short, failed authentication
+    /// or were replays
+    /// \return The number of messages rejected
+    uint16_t rxRejected() { return _rxRejected; };
+
     /// Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
     /// Then optionally waits for Channel Activity Detection (CAD) 
     /// to show the channnel is clear (if the radio supports CAD) by calling waitCAD().
@@ -124,6 +211,11 @@ public:
     /// current radio channel as active, else false. If there is no radio-specific CAD, returns false.
     virtual bool            isChannelActive() { return _driver.isChannelActive();};
 
+    /// Tells whether the underlying driver acknowledges and retransmits messages in the radio hardware,
+    /// so managers such as RHReliableDatagram do not send their own acknowledgements.
+    /// \return true if the radio hardware is acknowledging messages
+    virtual bool            hardwareAcknowledge() { return _driver.hardwareAcknowledge();};
+
     /// Sets the address of this node. Defaults to 0xFF. Subclasses or the user may want to change this.
     /// This will be used to test the adddress in incoming messages. In non-promiscuous mode,
     /// only messages with a TO header the same as thisAddress or the broadcast addess (0xFF) will be accepted.
@@ -137,15 +229,15 @@ public:
 
     /// Sets the TO header to be sent in all subsequent messages
     /// \param[in] to The new TO header value
-    virtual void           setHeaderTo(uint8_t to){ _driver.setHeaderTo(to);};
+    virtual void           setHeaderTo(uint8_t to){ _txHeaderTo = to; _driver.setHeaderTo(to);};
 
     /// Sets the FROM header to be sent in all subsequent messages
     /// \param[in] from The new FROM header value
-    virtual void           setHeaderFrom(uint8_t from){ _driver.setHeaderFrom(from);};
+    virtual void           setHeaderFrom(uint8_t from){ _txHeaderFrom = from; _driver.setHeaderFrom(from);};
 
     /// Sets the ID header to be sent in all subsequent messages
     /// \param[in] id The new ID header value
-    virtual void           setHeaderId(uint8_t id){ _driver.setHeaderId(id);};
+    virtual void           setHeaderId(uint8_t id){ _txHeaderId = id; _driver.setHeaderId(id);};
 
     /// Sets and clears bits in the FLAGS header to be sent in all subsequent messages
     /// First it clears he FLAGS according to the clear argument, then sets the flags according to the 
@@ -154,7 +246,7 @@ public:
     /// \param[in] clear bitmask of flags to clear. Defaults to RH_FLAGS_APPLICATION_SPECIFIC
     ///            which clears the application specific flags, resulting in new application specific flags
     ///            identical to the set.
-    virtual void           setHeaderFlags(uint8_t set, uint8_t clear = RH_FLAGS_APPLICATION_SPECIFIC) { _driver.setHeaderFlags(set, clear);};
+    virtual void           setHeaderFlags(uint8_t set, uint8_t clear = RH_FLAGS_APPLICATION_SPECIFIC) { RHGenericDriver::setHeaderFlags(set, clear); _driver.setHeaderFlags(set, clear);};
 
     /// Tells the receiver to accept messages with any TO address, not just messages
     /// addressed to thisAddress or the broadcast address
@@ -216,6 +308,60 @@ public:
     virtual uint16_t       txGood() { return _driver.txGood();};
 
 private:
+    /// Remembers the frame counters received from one sender in AEAD mode
+    typedef struct
+    {
+	uint8_t  from;     ///< The sender
+	uint8_t  valid;    ///< This entry is in use
+	uint32_t counter;  ///< Highest frame counter received
+	uint32_t window;   ///< Bit n set if counter - n has been received
+    } ReplayEntry;
+
+    /// Builds the CCM counter block A_i (and from it B_0) for a message
+    /// \param[in] block Location of the 16 octet block
+    /// \param[in] from FROM header of the message
+    /// \param[in] id ID header of the message
+    /// \param[in] counter Frame counter of the message
+    void ccmNonce(uint8_t* block, uint8_t from, uint8_t id, uint32_t counter);
+
+    /// Computes the CCM CBC-MAC of a message
+    /// \param[in] nonce A_0 from ccmNonce()
+    /// \param[in] aad The 4 headers to authenticate
+    /// \param[in] data The clear text message
+    /// \param[in] len Length of the message
+    /// \param[out] mac Location of the 16 octet MAC
+    void ccmMac(const uint8_t* nonce, const uint8_t* aad, const uint8_t* data, uint8_t len, uint8_t* mac);
+
+    /// Encrypts or decrypts a message in place with CCM counter mode, and encrypts the tag
+    /// \param[in] nonce A_0 from ccmNonce()
+    /// \param[in,out] data The message
+    /// \param[in] len Length of the message
+    /// \param[in,out] tag The _tagLen octet tag to XOR with S_0
+    void ccmCrypt(const uint8_t* nonce, uint8_t* data, uint8_t len, uint8_t* tag);
+
+    /// Finds the replay state for a sender, optionally creating it
+    /// \param[in] from The sender
+    /// \param[in] create true to take over an entry if there is none for this sender
+    /// \return pointer to the entry, or NULL
+    ReplayEntry* replayEntry(uint8_t from, bool create);
+
+    /// Tests whether a frame counter from a sender has not been seen before
+    /// \param[in] from The sender
+    /// \param[in] counter The frame counter
+    /// \return true if it is new
+    bool isFresh(uint8_t from, uint32_t counter);
+
+    /// Records a frame counter from a sender as seen
+    /// \param[in] from The sender
+    /// \param[in] counter The frame counter
+    void markSeen(uint8_t from, uint32_t counter);
+
+    /// Sends a message in AEAD mode
+    bool sendAEAD(const uint8_t* data, uint8_t len);
+
+    /// Receives a message in AEAD mode
+    bool recvAEAD(uint8_t* buf, uint8_t* len);
+
     /// The underlying transport river we are to use
     RHGenericDriver&        _driver;
     
@@ -234,6 +380,27 @@ private:
     
     /// Buffer to store encrypted/decrypted message
     uint8_t*                _buffer;
+
+    /// Length of the AEAD tag, 0 if AEAD mode is not in use
+    uint8_t                 _tagLen;
+
+    /// Frame counter of the last message sent in AEAD mode
+    uint32_t                _txCounter;
+
+    /// Count of messages rejected in AEAD mode
+    uint16_t                _rxRejected;
+
+    /// Frame counters received from recent senders
+    ReplayEntry             _replay[RH_ENCRYPTED_DRIVER_REPLAY_SENDERS];
+
+    /// Index of the next entry of _replay to take over
+    uint8_t                 _replayNext;
+
+    /// True if the radio is doing the encryption
+    bool                    _hardware;
+
+    /// True if the radio may do the encryption, see setHardwareAes()
+    bool                    _hardwareAllowed;
 };
 
 /// @example nrf24_encrypted_client.pde
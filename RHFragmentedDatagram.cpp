@@ -0,0 +1,486 @@
+// RHFragmentedDatagram.cpp
+//
+// Fragmentation and reassembly of messages larger than the driver can carry in one frame.
+// Part of the RadioHead library
+
+#include <RHFragmentedDatagram.h>
+
+// Default timeout for status reports in milliseconds
+#define RH_FRAGMENT_DEFAULT_TIMEOUT 200
+
+// Default number of retries without progress
+#define RH_FRAGMENT_DEFAULT_RETRIES 3
+
+// Marks an unused entry in _completed and _rejected
+#define RH_FRAGMENT_NO_TRANSFER 0xffff
+
+////////////////////////////////////////////////////////////////////
+// ReadFunction for sending from a buffer
+static bool readBuffer(uint16_t offset, uint8_t* buf, uint8_t len, void* context)
+{
+    memcpy(buf, (const uint8_t*)context + offset, len);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// Constructors
+RHFragmentedDatagram::RHFragmentedDatagram(RHGenericDriver& driver, uint8_t thisAddress)
+    : RHDatagram(driver, thisAddress)
+{
+    _timeout = RH_FRAGMENT_DEFAULT_TIMEOUT;
+    _retries = RH_FRAGMENT_DEFAULT_RETRIES;
+    _retransmissions = 0;
+    _lastTransfer = 0;
+    _lastPoll = 0;
+    _streaming = false;
+    memset(_slots, 0, sizeof(_slots));
+    for (uint8_t i = 0; i < RH_FRAGMENT_SLOTS; i++)
+    {
+	_completed[i] = RH_FRAGMENT_NO_TRANSFER;
+	_completedTime[i] = 0;
+    }
+    _completedIndex = 0;
+    _rejected = RH_FRAGMENT_NO_TRANSFER;
+}
+
+////////////////////////////////////////////////////////////////////
+// Public methods
+void RHFragmentedDatagram::setTimeout(uint16_t timeout)
+{
+    _timeout = timeout;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::setRetries(uint8_t retries)
+{
+    _retries = retries;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::setStreaming(bool streaming)
+{
+    _streaming = streaming;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::sendtoWait(const uint8_t* buf, uint16_t len, uint8_t address)
+{
+    return sendtoWait(len, address, readBuffer, (void*)buf);
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::sendtoWait(uint16_t len, uint8_t address, ReadFunction read, void* context)
+{
+    uint8_t maxLen = _driver.maxMessageLength();
+    if (len == 0 || maxLen <= RH_FRAGMENT_HEADER_LEN || maxLen <= RH_FRAGMENT_STATUS_HEADER_LEN)
+	return false;
+    uint8_t fragSize = maxLen - RH_FRAGMENT_HEADER_LEN;
+    uint16_t count = ((uint32_t)len + fragSize - 1) / fragSize;
+    uint8_t transfer = ++_lastTransfer;
+
+    // Send the whole message back to back without waiting for anything
+    uint16_t i;
+    for (i = 0; i < count; i++)
+	if (!sendFragment(transfer, fragSize, i, len, address, read, context))
+	    return false;
+    waitPacketSent();
+
+    // Never wait for status reports to broadcasts:
+    if (address == RH_BROADCAST_ADDRESS)
+	return true;
+
+    uint16_t lastReceived = 0;
+    uint8_t retries = 0;
+    while (retries <= _retries)
+    {
+	// Ask the receiver what is missing. The reply has the same header ID, so
+	// late replies to earlier polls can be told apart
+	uint8_t thisPoll = ++_lastPoll;
+	setHeaderId(thisPoll);
+	_buf[0] = RH_FRAGMENT_TYPE_POLL;
+	_buf[1] = transfer;
+	if (!sendto(_buf, 2, address))
+	    return false;
+	waitPacketSent();
+
+	uint8_t statusLen = 0;
+	unsigned long thisSendTime = millis(); // Timeout does not include the poll transmit time
+	int32_t timeLeft;
+	while (!statusLen && (timeLeft = _timeout - (millis() - thisSendTime)) > 0)
+	{
+	    if (waitAvailableTimeout(timeLeft))
+	    {
+		uint8_t from, to, id;
+		uint8_t rxLen = sizeof(_buf);
+		if (RHDatagram::recvfrom(_buf, &rxLen, &from, &to, &id))
+		{
+		    Slot* slot;
+		    if (   from == address
+			&& to == _thisAddress
+			&& id == thisPoll
+			&& rxLen >= RH_FRAGMENT_STATUS_HEADER_LEN
+			&& _buf[0] == RH_FRAGMENT_TYPE_STATUS
+			&& _buf[1] == transfer)
+			statusLen = rxLen; // Its the status report we are waiting for
+		    else if (!_streaming || _buf[0] != RH_FRAGMENT_TYPE_DATA)
+			handleMessage(from, to, id, rxLen, &slot); // Maybe the receiver is sending to us too
+		    // Else discard it: there is no one to give a streamed fragment to yet
+		}
+	    }
+	    YIELD;
+	}
+	if (!statusLen)
+	{
+	    // Timeout exhausted, maybe retry
+	    retries++;
+	    continue;
+	}
+
+	if (_buf[2] == RH_FRAGMENT_STATUS_COMPLETE)
+	    return true;
+	if (_buf[2] == RH_FRAGMENT_STATUS_REJECTED)
+	    return false;
+
+	// Only count retries in a row that make no progress
+	uint16_t received = get16(&_buf[3]);
+	if (received > lastReceived)
+	{
+	    lastReceived = received;
+	    retries = 0;
+	}
+	else
+	    retries++;
+
+	// Resend the missing fragments. An empty bitmap means everything from BASE is missing.
+	// Sending reuses _buf, so keep what we need of the bitmap first
+	uint16_t base = get16(&_buf[5]);
+	uint8_t bitmapLen = statusLen - RH_FRAGMENT_STATUS_HEADER_LEN;
+	uint8_t bitmap[RH_FRAGMENT_RESEND_BITMAP_LEN];
+	if (bitmapLen > sizeof(bitmap))
+	    bitmapLen = sizeof(bitmap);
+	memcpy(bitmap, &_buf[RH_FRAGMENT_STATUS_HEADER_LEN], bitmapLen);
+	for (i = base; i < count; i++)
+	{
+	    uint16_t bit = i - base;
+	    if (bitmapLen)
+	    {
+		if (bit >= (uint16_t)bitmapLen * 8)
+		    break;
+		if (!(bitmap[bit >> 3] & (1 << (bit & 7))))
+		    continue;
+	    }
+	    if (!sendFragment(transfer, fragSize, i, len, address, read, context))
+		return false;
+	    _retransmissions++;
+	}
+	waitPacketSent();
+	YIELD;
+    }
+    // Retries exhausted
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::recvfrom(uint8_t* buf, uint16_t* len, uint8_t* from)
+{
+    Slot* slot;
+    receive(&slot);
+
+    if (_streaming)
+	return false;
+    for (uint8_t i = 0; i < RH_FRAGMENT_SLOTS; i++)
+    {
+	slot = &_slots[i];
+	if (slot->state == SlotComplete)
+	{
+	    if (buf && len)
+	    {
+		if (*len > slot->total)
+		    *len = slot->total;
+		memcpy(buf, &_pool[slot->offset], *len);
+	    }
+	    if (from) *from = slot->from;
+	    freeSlot(slot, true);
+	    return true;
+	}
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::recvfromTimeout(uint8_t* buf, uint16_t* len, uint16_t timeout, uint8_t* from)
+{
+    unsigned long starttime = millis();
+    int32_t timeLeft;
+    // A message may already be complete, such as one received while sendtoWait() was waiting
+    while (!recvfrom(buf, len, from))
+    {
+	if ((timeLeft = timeout - (millis() - starttime)) <= 0)
+	    return false;
+	waitAvailableTimeout(timeLeft);
+	YIELD;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::recvFragment(uint8_t* buf, uint8_t* len, uint16_t* offset, uint16_t* total, uint8_t* from)
+{
+    Slot* slot;
+    if (!_streaming || !receive(&slot))
+	return false;
+
+    // The new fragment is still in _buf
+    uint16_t index = get16(&_buf[3]);
+    uint16_t fragOffset = index * slot->fragSize;
+    uint8_t dataLen = slot->total - fragOffset < slot->fragSize ? slot->total - fragOffset : slot->fragSize;
+    if (buf && len)
+    {
+	if (*len > dataLen)
+	    *len = dataLen;
+	memcpy(buf, &_buf[RH_FRAGMENT_HEADER_LEN], *len);
+    }
+    if (offset) *offset = fragOffset;
+    if (total)  *total =  slot->total;
+    if (from)   *from =   slot->from;
+    if (slot->state == SlotComplete)
+	freeSlot(slot, true);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+uint32_t RHFragmentedDatagram::retransmissions()
+{
+    return _retransmissions;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::resetRetransmissions()
+{
+    _retransmissions = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+// Protected methods
+bool RHFragmentedDatagram::sendFragment(uint8_t transfer, uint8_t fragSize, uint16_t index, uint16_t total,
+					uint8_t address, ReadFunction read, void* context)
+{
+    uint16_t offset = index * fragSize;
+    uint8_t dataLen = total - offset < fragSize ? total - offset : fragSize;
+    _buf[0] = RH_FRAGMENT_TYPE_DATA;
+    _buf[1] = transfer;
+    _buf[2] = fragSize;
+    put16(&_buf[3], index);
+    put16(&_buf[5], total);
+    if (!read(offset, &_buf[RH_FRAGMENT_HEADER_LEN], dataLen, context))
+	return false;
+    // The driver waits for any previous fragment to be sent
+    return sendto(_buf, RH_FRAGMENT_HEADER_LEN + dataLen, address);
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::receive(Slot** slot)
+{
+    uint8_t len = sizeof(_buf);
+    uint8_t from, to, id;
+#if (RH_PLATFORM == RH_PLATFORM_RASPI)
+    // Pooling of nIRQ is used instead of a real interrupt service/handler
+    if (!RHDatagram::recvfrom(_buf, &len, &from, &to, &id))
+#else
+    if (!available() || !RHDatagram::recvfrom(_buf, &len, &from, &to, &id))
+#endif
+	return false;
+    return handleMessage(from, to, id, len, slot);
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::handleMessage(uint8_t from, uint8_t to, uint8_t id, uint8_t len, Slot** slot)
+{
+    if (len > RH_FRAGMENT_HEADER_LEN && _buf[0] == RH_FRAGMENT_TYPE_DATA)
+	return receiveFragment(from, len, slot);
+    if (len >= 2 && _buf[0] == RH_FRAGMENT_TYPE_POLL && to == _thisAddress)
+	sendStatus(from, _buf[1], id);
+    // Else discard it
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::receiveFragment(uint8_t from, uint8_t len, Slot** slot)
+{
+    uint8_t  transfer = _buf[1];
+    uint8_t  fragSize = _buf[2];
+    uint16_t index = get16(&_buf[3]);
+    uint16_t total = get16(&_buf[5]);
+    if (fragSize == 0 || total == 0)
+	return false;
+    uint16_t count = ((uint32_t)total + fragSize - 1) / fragSize;
+    if (index >= count)
+	return false;
+    uint16_t offset = index * fragSize;
+    uint8_t dataLen = len - RH_FRAGMENT_HEADER_LEN;
+    if (dataLen != (total - offset < fragSize ? total - offset : fragSize))
+	return false; // Corrupt
+
+    // Late retransmission of a message we already have?
+    if (wasCompleted(from, transfer))
+	return false;
+
+    Slot* s = getSlot(from, transfer);
+    if (!s)
+    {
+	uint32_t need = (uint32_t)(count + 7) / 8;
+	if (!_streaming)
+	    need += total;
+	if (need > RH_FRAGMENT_POOL_LEN)
+	{
+	    // It will never fit, tell the sender when it asks
+	    _rejected = ((uint16_t)from << 8) | transfer;
+	    return false;
+	}
+	if (!(s = allocateSlot(need)))
+	    return false; // No room for it yet, the sender will retry
+	s->from = from;
+	s->transfer = transfer;
+	s->fragSize = fragSize;
+	s->total = total;
+	s->count = count;
+	s->received = 0;
+	memset(&_pool[s->offset], 0, s->len);
+    }
+    else if (s->fragSize != fragSize || s->total != total)
+	return false; // Inconsistent with the earlier fragments
+
+    s->lastTime = millis();
+    uint8_t* bitmap = &_pool[s->offset + (_streaming ? 0 : s->total)];
+    uint8_t mask = 1 << (index & 7);
+    if (s->state != SlotReceiving || (bitmap[index >> 3] & mask))
+	return false; // Seen it before
+    bitmap[index >> 3] |= mask;
+    if (!_streaming)
+	memcpy(&_pool[s->offset + offset], &_buf[RH_FRAGMENT_HEADER_LEN], dataLen);
+    if (++s->received == s->count)
+	s->state = SlotComplete;
+    *slot = s;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::sendStatus(uint8_t from, uint8_t transfer, uint8_t id)
+{
+    uint8_t len = RH_FRAGMENT_STATUS_HEADER_LEN;
+    uint16_t received = 0;
+    uint16_t base = 0;
+    _buf[0] = RH_FRAGMENT_TYPE_STATUS;
+    _buf[1] = transfer;
+    _buf[2] = RH_FRAGMENT_STATUS_INCOMPLETE;
+
+    Slot* s = getSlot(from, transfer);
+    if ((s && s->state == SlotComplete) || wasCompleted(from, transfer))
+	_buf[2] = RH_FRAGMENT_STATUS_COMPLETE;
+    else if (!s && _rejected == (((uint16_t)from << 8) | transfer))
+	_buf[2] = RH_FRAGMENT_STATUS_REJECTED;
+    else if (s)
+    {
+	// Report the missing fragments from the first one, as many as will fit
+	uint8_t* bitmap = &_pool[s->offset + (_streaming ? 0 : s->total)];
+	received = s->received;
+	while (base < s->count && (bitmap[base >> 3] & (1 << (base & 7))))
+	    base++;
+	uint16_t maxBits = (uint16_t)(_driver.maxMessageLength() - RH_FRAGMENT_STATUS_HEADER_LEN) * 8;
+	uint16_t bits = s->count - base < maxBits ? s->count - base : maxBits;
+	uint8_t* missing = &_buf[RH_FRAGMENT_STATUS_HEADER_LEN];
+	memset(missing, 0, (bits + 7) / 8);
+	for (uint16_t bit = 0; bit < bits; bit++)
+	{
+	    uint16_t i = base + bit;
+	    if (!(bitmap[i >> 3] & (1 << (i & 7))))
+		missing[bit >> 3] |= 1 << (bit & 7);
+	}
+	len += (bits + 7) / 8;
+    }
+    // Else we have seen nothing of it: the empty bitmap asks for everything
+    put16(&_buf[3], received);
+    put16(&_buf[5], base);
+    setHeaderId(id);
+    sendto(_buf, len, from);
+    waitPacketSent();
+}
+
+////////////////////////////////////////////////////////////////////
+RHFragmentedDatagram::Slot* RHFragmentedDatagram::getSlot(uint8_t from, uint8_t transfer)
+{
+    for (uint8_t i = 0; i < RH_FRAGMENT_SLOTS; i++)
+	if (   _slots[i].state != SlotFree
+	    && _slots[i].from == from
+	    && _slots[i].transfer == transfer)
+	    return &_slots[i];
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////
+RHFragmentedDatagram::Slot* RHFragmentedDatagram::allocateSlot(uint16_t len)
+{
+    uint8_t i;
+    // Abandon messages that have stopped arriving
+    for (i = 0; i < RH_FRAGMENT_SLOTS; i++)
+	if (   _slots[i].state == SlotReceiving
+	    && millis() - _slots[i].lastTime > RH_FRAGMENT_REASSEMBLY_TIMEOUT)
+	    freeSlot(&_slots[i], false);
+
+    Slot* slot = NULL;
+    for (i = 0; i < RH_FRAGMENT_SLOTS; i++)
+	if (_slots[i].state == SlotFree)
+	    slot = &_slots[i];
+    if (!slot)
+	return NULL;
+
+    // First fit: move past any memory in use that overlaps, until nothing does
+    uint32_t offset = 0;
+    bool moved = true;
+    while (moved)
+    {
+	moved = false;
+	for (i = 0; i < RH_FRAGMENT_SLOTS; i++)
+	{
+	    Slot* s = &_slots[i];
+	    if (   s->state != SlotFree
+		&& offset < (uint32_t)s->offset + s->len
+		&& s->offset < offset + len)
+	    {
+		offset = (uint32_t)s->offset + s->len;
+		moved = true;
+	    }
+	}
+    }
+    if (offset + len > RH_FRAGMENT_POOL_LEN)
+	return NULL;
+
+    slot->state = SlotReceiving;
+    slot->offset = offset;
+    slot->len = len;
+    return slot;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::freeSlot(Slot* slot, bool completed)
+{
+    if (completed)
+    {
+	_completed[_completedIndex] = ((uint16_t)slot->from << 8) | slot->transfer;
+	_completedTime[_completedIndex] = millis();
+	_completedIndex = (_completedIndex + 1) % RH_FRAGMENT_SLOTS;
+    }
+    slot->state = SlotFree;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::wasCompleted(uint8_t from, uint8_t transfer)
+{
+    uint16_t key = ((uint16_t)from << 8) | transfer;
+    // Forget them eventually, in case the sender restarts and reuses TRANSFER
+    for (uint8_t i = 0; i < RH_FRAGMENT_SLOTS; i++)
+	if (   _completed[i] == key
+	    && millis() - _completedTime[i] <= RH_FRAGMENT_REASSEMBLY_TIMEOUT)
+	    return true;
+    return false;
+}
@@ -0,0 +1,321 @@
+// RHFragmentedDatagram.h
+//
+// Fragmentation and reassembly of messages larger than the driver can carry in one frame.
+// Part of the RadioHead library
+
+#ifndef RHFragmentedDatagram_h
+#define RHFragmentedDatagram_h
+
+#include <RHDatagram.h>
+
+// Types of fragment protocol message, the first octet of every payload
+#define RH_FRAGMENT_TYPE_DATA            1
+#define RH_FRAGMENT_TYPE_POLL            2
+#define RH_FRAGMENT_TYPE_STATUS          3
+
+// Results carried in a RH_FRAGMENT_TYPE_STATUS message
+#define RH_FRAGMENT_STATUS_INCOMPLETE    0
+#define RH_FRAGMENT_STATUS_COMPLETE      1
+#define RH_FRAGMENT_STATUS_REJECTED      2
+
+// Length of the header in each RH_FRAGMENT_TYPE_DATA message
+#define RH_FRAGMENT_HEADER_LEN           7
+
+// Length of the RH_FRAGMENT_TYPE_STATUS message before the bitmap of missing fragments
+#define RH_FRAGMENT_STATUS_HEADER_LEN    7
+
+// Octets of the status bitmap kept by sendtoWait() while it resends missing fragments.
+// Any missing fragments past the first RH_FRAGMENT_RESEND_BITMAP_LEN * 8 are resent after the next status report
+#define RH_FRAGMENT_RESEND_BITMAP_LEN    16
+
+// The max number of messages that can be received at once
+#define RH_FRAGMENT_SLOTS                2
+
+// Reassembly of a message that has seen no fragments for this many milliseconds
+// may be abandoned to make room for another one
+#define RH_FRAGMENT_REASSEMBLY_TIMEOUT   10000
+
+/////////////////////////////////////////////////////////////////////
+/// \class RHFragmentedDatagram RHFragmentedDatagram.h <RHFragmentedDatagram.h>
+/// \brief RHDatagram subclass for sending and receiving addressed messages up to 65535 octets,
+/// fragmented to fit the driver, with selective retransmission of lost fragments.
+///
+/// Manager class that extends RHDatagram to carry messages much larger than maxMessageLength() of the
+/// driver, such as firmware images or configuration blobs.
+/// sendtoWait() splits the message into as many fragments as needed, each as large as the driver allows,
+/// and transmits them all back to back without waiting for acknowledgements. It then asks the receiver
+/// which fragments are missing, retransmits only those, and repeats until the receiver reports the whole
+/// message has arrived, or there is no progress after the configured number of retries.
+///
+/// The receiver reassembles messages in a fixed size pool of RH_FRAGMENT_POOL_LEN octets (defined in RadioHead.h:
+/// 128 on AVR and other processors with little RAM, 1024 elsewhere), and up to
+/// RH_FRAGMENT_SLOTS messages (from different senders) can be in progress at once. A message that could never fit
+/// in the pool is rejected and sendtoWait() returns false at once.
+/// Completed messages are collected with recvfrom().
+///
+/// Alternatively, with setStreaming(true) the receiver does not keep the message, but returns each new
+/// fragment with its offset in the message from recvFragment() as soon as it arrives (possibly out of
+/// order), so it can be written straight to flash or a file. Then the pool only holds 1 bit per fragment.
+/// Likewise, the sender can supply the message through a ReadFunction instead of a buffer,
+/// so it never needs to be in memory at once.
+///
+/// \par Memory
+///
+/// Each instance uses about RH_MAX_MESSAGE_LEN (255) + RH_FRAGMENT_POOL_LEN + 60 octets of RAM:
+/// one message buffer shared by sending and receiving, the reassembly pool, and the bookkeeping for
+/// RH_FRAGMENT_SLOTS messages. That is about 450 octets on AVR, so on small processors you may want to define
+/// a smaller RH_FRAGMENT_POOL_LEN and use streaming receive. sendtoWait() also uses
+/// RH_FRAGMENT_RESEND_BITMAP_LEN octets of stack.
+///
+/// There is no message queuing or threading in RHFragmentedDatagram.
+/// Messages are only processed when you call recvfrom() or recvFragment(), so you must call them
+/// frequently. While sendtoWait() is waiting for a status report, it still answers polls and reassembles
+/// fragments from other senders, so two nodes can send messages to each other at the same time.
+/// In streaming mode, fragments that arrive then are discarded, and recovered later by the sender.
+///
+/// You can use RHFragmentedDatagram to broadcast messages, with a TO address of RH_BROADCAST_ADDRESS,
+/// however the fragments are then sent only once and any lost fragments are not recovered.
+///
+/// \par Message Format
+///
+/// All messages use the normal RHDatagram TO and FROM headers. The payload of each message starts with:
+/// - 1 octet TYPE, one of RH_FRAGMENT_TYPE_*
+/// - 1 octet TRANSFER, incremented for each message sent by a node, to identify all its fragments
+///
+/// RH_FRAGMENT_TYPE_DATA messages carry one fragment, and continue with:
+/// - 1 octet FRAGSIZE, the number of data octets in every fragment except maybe the last one
+/// - 2 octets INDEX, the 0 based number of this fragment, in network byte order
+/// - 2 octets TOTAL, the length of the whole message in octets, in network byte order
+/// - 1 to FRAGSIZE octets of data, from offset INDEX * FRAGSIZE in the message
+///
+/// RH_FRAGMENT_TYPE_POLL messages from the sender ask the receiver for a status report and have nothing more.
+/// The status report is sent with the same header ID as the poll.
+///
+/// RH_FRAGMENT_TYPE_STATUS messages from the receiver continue with:
+/// - 1 octet RESULT, one of RH_FRAGMENT_STATUS_*
+/// - 2 octets RECEIVED, the number of fragments received so far, in network byte order
+/// - 2 octets BASE, the index of the first missing fragment, in network byte order
+/// - 0 or more octets bitmap, 1 bit for each fragment from BASE onwards (LSB first) set if it is missing
+///
+class RHFragmentedDatagram : public RHDatagram
+{
+public:
+    /// Function that supplies message data to sendtoWait() for streaming send
+    /// \param[in] offset Offset in the message of the first octet wanted
+    /// \param[in] buf Location to copy the data to
+    /// \param[in] len Number of octets wanted
+    /// \param[in] context The context pointer passed to sendtoWait()
+    /// \return true if the data was copied to buf
+    typedef bool (*ReadFunction)(uint16_t offset, uint8_t* buf, uint8_t len, void* context);
+
+    /// Values for the possible states of a reassembly slot
+    typedef enum
+    {
+	SlotFree = 0,       ///< Not in use
+	SlotReceiving,      ///< Waiting for more fragments
+	SlotComplete        ///< All fragments received, waiting to be collected by recvfrom()
+    } SlotState;
+
+    /// Defines the state of a message being received
+    typedef struct
+    {
+	uint8_t       state;     ///< One of SlotState
+	uint8_t       from;      ///< The sender of the message
+	uint8_t       transfer;  ///< TRANSFER from the sender
+	uint8_t       fragSize;  ///< FRAGSIZE from the sender
+	uint16_t      total;     ///< Length of the message
+	uint16_t      count;     ///< Number of fragments in the message
+	uint16_t      received;  ///< Number of different fragments received so far
+	uint16_t      offset;    ///< Offset of the reassembly memory in the pool
+	uint16_t      len;       ///< Octets of reassembly memory: the message (unless streaming) then the bitmap
+	unsigned long lastTime;  ///< millis() when the last fragment arrived
+    } Slot;
+
+    /// Constructor.
+    /// \param[in] driver The RadioHead driver to use to transport messages.
+    /// \param[in] thisAddress The address to assign to this node. Defaults to 0
+    RHFragmentedDatagram(RHGenericDriver& driver, uint8_t thisAddress = 0);
+
+    /// Sets the time to wait for a status report after asking for one. Defaults to 200ms.
+    /// It must be longer than the transmit time of the status report plus the poll time of the receiver.
+    /// \param[in] timeout The new timeout period in milliseconds
+    void setTimeout(uint16_t timeout);
+
+    /// Sets the maximum number of times in a row sendtoWait() will ask for a status report
+    /// without getting one, or getting one that shows no progress, before giving up. Defaults to 3.
+    /// \param[in] retries The maximum number a retries.
+    void setRetries(uint8_t retries);
+
+    /// Sets whether received messages are returned fragment by fragment by recvFragment()
+    /// instead of being reassembled for recvfrom(). Defaults to false.
+    /// \param[in] streaming true to receive fragment by fragment
+    void setStreaming(bool streaming);
+
+    /// Sends a message of any length up to 65535 octets to the node(s) with the given address,
+    /// fragmented to fit the driver. Retransmits lost fragments until the whole message is
+    /// reported as received, or the retries are exhausted.
+    /// \param[in] buf Pointer to the binary message to send
+    /// \param[in] len Number of octets to send (> 0)
+    /// \param[in] address The address to send the message to.
+    /// \return true if the whole message was received by the addressed node, or was broadcast.
+    bool sendtoWait(const uint8_t* buf, uint16_t len, uint8_t address);
+
+    /// Similar to sendtoWait() above, but gets the message data from a function as it is needed,
+    /// a fragment at a time. Fragments that need to be retransmitted are read again.
+    /// \param[in] len Number of octets to send (> 0)
+    /// \param[in] address The address to send the message to.
+    /// \param[in] read Function that supplies the message data
+    /// \param[in] context Passed to every call of read
+    /// \return true if the whole message was received by the addressed node, or was broadcast.
+    bool sendtoWait(uint16_t len, uint8_t address, ReadFunction read, void* context = NULL);
+
+    /// Processes any received fragments and status requests, and if a complete message
+    /// is available for this node, copies it to buf and returns true.
+    /// Does not return anything in streaming mode.
+    /// \param[in] buf Location to copy the received message
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the FROM address
+    /// \return true if a message was copied to buf
+    bool recvfrom(uint8_t* buf, uint16_t* len, uint8_t* from = NULL);
+
+    /// Similar to recvfrom(), but blocks until a message is available or the timeout expires.
+    /// \param[in] buf Location to copy the received message
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \param[in] timeout Maximum time to wait in milliseconds
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the FROM address
+    /// \return true if a message was copied to buf
+    bool recvfromTimeout(uint8_t* buf, uint16_t* len, uint16_t timeout, uint8_t* from = NULL);
+
+    /// In streaming mode, processes any received fragments and status requests, and if a fragment
+    /// not seen before is available for this node, copies its data to buf and returns true.
+    /// Fragments may arrive in any order, but each is only returned once.
+    /// \param[in] buf Location to copy the fragment data
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \param[out] offset Set to the offset of the fragment data in the message
+    /// \param[out] total Set to the length of the whole message. When the lengths of the fragments
+    ///             returned add up to this, the message is complete.
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the FROM address
+    /// \return true if fragment data was copied to buf
+    bool recvFragment(uint8_t* buf, uint8_t* len, uint16_t* offset, uint16_t* total, uint8_t* from = NULL);
+
+    /// Returns the number of fragments that have been retransmitted since the last call to
+    /// resetRetransmissions()
+    /// \return The number of retransmitted fragments
+    uint32_t retransmissions();
+
+    /// Resets the count of retransmitted fragments
+    void resetRetransmissions();
+
+protected:
+    /// Sends one fragment of a message
+    /// \param[in] transfer TRANSFER for the message
+    /// \param[in] fragSize FRAGSIZE for the message
+    /// \param[in] index Index of the fragment
+    /// \param[in] total Length of the message
+    /// \param[in] address The address to send the message to.
+    /// \param[in] read Function that supplies the message data
+    /// \param[in] context Passed to read
+    /// \return true if the fragment was sent
+    bool sendFragment(uint8_t transfer, uint8_t fragSize, uint16_t index, uint16_t total,
+		      uint8_t address, ReadFunction read, void* context);
+
+    /// Gets a received message, if any, and handles it. A new fragment is left in _buf.
+    /// \param[out] slot Set to the slot the fragment belongs to if a new fragment was received
+    /// \return true if a new fragment was received
+    bool receive(Slot** slot);
+
+    /// Handles a message just received into _buf. A new fragment is left in _buf.
+    /// \param[in] from The sender
+    /// \param[in] to The destination
+    /// \param[in] id Header ID of the message
+    /// \param[in] len Length of the message in _buf
+    /// \param[out] slot Set to the slot the fragment belongs to if it is a new fragment
+    /// \return true if it is a new fragment
+    bool handleMessage(uint8_t from, uint8_t to, uint8_t id, uint8_t len, Slot** slot);
+
+    /// Handles a received fragment
+    /// \param[in] from The sender
+    /// \param[in] len Length of the message in _buf
+    /// \param[out] slot Set to the slot the fragment belongs to
+    /// \return true if this fragment was not received before
+    bool receiveFragment(uint8_t from, uint8_t len, Slot** slot);
+
+    /// Sends a status report for a message
+    /// \param[in] from The sender of the message
+    /// \param[in] transfer TRANSFER of the message
+    /// \param[in] id Header ID of the poll, copied to the status report
+    void sendStatus(uint8_t from, uint8_t transfer, uint8_t id);
+
+    /// Finds a slot for a message being received
+    /// \param[in] from The sender of the message
+    /// \param[in] transfer TRANSFER of the message
+    /// \return pointer to the Slot or NULL
+    Slot* getSlot(uint8_t from, uint8_t transfer);
+
+    /// Allocates a slot and reassembly memory for a new message
+    /// \param[in] len Octets of reassembly memory needed
+    /// \return pointer to the Slot or NULL if there is not enough room
+    Slot* allocateSlot(uint16_t len);
+
+    /// Releases a slot and remembers its message was completed, for later status reports
+    /// \param[in] slot The slot
+    /// \param[in] completed true if the whole message was received
+    void freeSlot(Slot* slot, bool completed);
+
+    /// Tests whether a message was completed recently
+    /// \param[in] from The sender of the message
+    /// \param[in] transfer TRANSFER of the message
+    /// \return true if it was
+    bool wasCompleted(uint8_t from, uint8_t transfer);
+
+    /// Reads a 16 bit network byte order value
+    static uint16_t get16(const uint8_t* p) { return ((uint16_t)p[0] << 8) | p[1]; }
+
+    /// Writes a 16 bit network byte order value
+    static void     put16(uint8_t* p, uint16_t v) { p[0] = v >> 8; p[1] = v & 0xff; }
+
+    /// Timeout for status reports in milliseconds
+    uint16_t      _timeout;
+
+    /// Number of retries without progress
+    uint8_t       _retries;
+
+    /// Count of retransmitted fragments
+    uint32_t      _retransmissions;
+
+    /// The last TRANSFER used by this node
+    uint8_t       _lastTransfer;
+
+    /// The last header ID used for a poll by this node
+    uint8_t       _lastPoll;
+
+    /// Return fragments from recvFragment() instead of messages from recvfrom()
+    bool          _streaming;
+
+private:
+    /// Temporary message buffer, for both receiving and sending
+    uint8_t       _buf[RH_MAX_MESSAGE_LEN];
+
+    /// The messages being received
+    Slot          _slots[RH_FRAGMENT_SLOTS];
+
+    /// Sender (high octet) and TRANSFER (low octet) of recently completed messages
+    uint16_t      _completed[RH_FRAGMENT_SLOTS];
+
+    /// millis() when each of _completed was completed
+    unsigned long _completedTime[RH_FRAGMENT_SLOTS];
+
+    /// Sender (high octet) and TRANSFER (low octet) of the last message that did not fit
+    uint16_t      _rejected;
+
+    /// Index of the next entry to use in _completed
+    uint8_t       _completedIndex;
+
+    /// Reassembly memory
+    uint8_t       _pool[RH_FRAGMENT_POOL_LEN];
+};
+
+/// @example simulator_fragmented_client.pde
+/// @example simulator_fragmented_server.pde
+
+#endif
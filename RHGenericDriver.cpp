@@ -100,6 +100,18 @@ bool RHGenericDriver::isChannelActive()
     return false;
 }
 
+bool RHGenericDriver::hardwareAcknowledge()
+{
+    return false;
+}
+
+bool RHGenericDriver::setHardwareEncryption(const uint8_t* key, uint8_t len)
+{
+    (void)key; // Not used
+    (void)len; // Not used
+    return false;
+}
+
 void RHGenericDriver::setPromiscuous(bool promiscuous)
 {
     _promiscuous = promiscuous;
@@ -152,6 +152,21 @@ public:
     /// current radio channel as active, else false. If there is no radio-specific CAD, returns false.
     virtual bool            isChannelActive();
 
+    /// Tells whether this driver acknowledges and retransmits messages sent to a single node
+    /// in the radio hardware. If so, waitPacketSent() only returns true if the message was acknowledged
+    /// by the receiving radio, and RHReliableDatagram relies on that instead of exchanging its own 
+    /// acknowledgement messages. All the nodes must agree on this.
+    /// \return true if the radio hardware is acknowledging messages. The default is false.
+    virtual bool            hardwareAcknowledge();
+
+    /// Enables or disables encryption of all messages in the radio hardware, for radios that support it.
+    /// RHEncryptedDriver uses this to hand encryption over to the radio when it can.
+    /// \param[in] key The key to use, or NULL to disable hardware encryption
+    /// \param[in] len Length of key in octets
+    /// \return true if the radio supports hardware encryption with this length of key and it was enabled 
+    /// (or disabled if key is NULL). The default is false.
+    virtual bool            setHardwareEncryption(const uint8_t* key, uint8_t len);
+
     /// Sets the address of this node. Defaults to 0xFF. Subclasses or the user may want to change this.
     /// This will be used to test the adddress in incoming messages. In non-promiscuous mode,
     /// only messages with a TO header the same as thisAddress or the broadcast addess (0xFF) will be accepted.
@@ -20,10 +20,88 @@ uint8_t RHMesh::_tmpMessage[RH_ROUTER_MAX_MESSAGE_LEN];
 RHMesh::RHMesh(RHGenericDriver& driver, uint8_t thisAddress) 
     : RHRouter(driver, thisAddress)
 {
+    _source_routing = false;
+    clearSourceRoutingTable();
 }
 
 ////////////////////////////////////////////////////////////////////
 // Public methods
+void RHMesh::setSourceRouting(bool source_routing)
+{
+    _source_routing = source_routing;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHMesh::addSourceRouteTo(uint8_t dest, uint8_t* hops, uint8_t numHops, bool reverse)
+{
+    if (numHops > RH_MESH_MAX_SOURCE_ROUTE_HOPS)
+	return; // Too long to keep, will be routed hop-by-hop
+
+    SourceRouteEntry* entry = NULL;
+    uint8_t i;
+    // First look for an existing entry we can update
+    for (i = 0; i < RH_MESH_SOURCE_ROUTE_TABLE_SIZE && !entry; i++)
+	if (_sourceRoutes[i].dest == dest && _sourceRoutes[i].state != Invalid)
+	    entry = &_sourceRoutes[i];
+    // Look for an invalid entry we can use
+    for (i = 0; i < RH_MESH_SOURCE_ROUTE_TABLE_SIZE && !entry; i++)
+	if (_sourceRoutes[i].state == Invalid)
+	    entry = &_sourceRoutes[i];
+    if (!entry)
+    {
+	// Need to make room for a new one. The last slot is invalid now
+	deleteSourceRoute(0);
+	entry = &_sourceRoutes[RH_MESH_SOURCE_ROUTE_TABLE_SIZE - 1];
+    }
+
+    entry->dest = dest;
+    entry->state = Valid;
+    entry->numHops = numHops;
+    for (i = 0; i < numHops; i++)
+	entry->hops[i] = reverse ? hops[numHops - 1 - i] : hops[i];
+}
+
+////////////////////////////////////////////////////////////////////
+RHMesh::SourceRouteEntry* RHMesh::getSourceRouteTo(uint8_t dest)
+{
+    uint8_t i;
+    for (i = 0; i < RH_MESH_SOURCE_ROUTE_TABLE_SIZE; i++)
+	if (_sourceRoutes[i].dest == dest && _sourceRoutes[i].state != Invalid)
+	    return &_sourceRoutes[i];
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHMesh::deleteSourceRoute(uint8_t index)
+{
+    // Delete a path by moving following paths on top of it
+    memmove(&_sourceRoutes[index], &_sourceRoutes[index+1], 
+	    sizeof(SourceRouteEntry) * (RH_MESH_SOURCE_ROUTE_TABLE_SIZE - index - 1));
+    _sourceRoutes[RH_MESH_SOURCE_ROUTE_TABLE_SIZE - 1].state = Invalid;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHMesh::deleteSourceRouteTo(uint8_t dest)
+{
+    uint8_t i;
+    for (i = 0; i < RH_MESH_SOURCE_ROUTE_TABLE_SIZE; i++)
+    {
+	if (_sourceRoutes[i].dest == dest && _sourceRoutes[i].state != Invalid)
+	{
+	    deleteSourceRoute(i);
+	    return true;
+	}
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHMesh::clearSourceRoutingTable()
+{
+    uint8_t i;
+    for (i = 0; i < RH_MESH_SOURCE_ROUTE_TABLE_SIZE; i++)
+	_sourceRoutes[i].state = Invalid;
+}
 
 ////////////////////////////////////////////////////////////////////
 // Discovers a route to the destination (if necessary), sends and 
@@ -33,11 +111,41 @@ uint8_t RHMesh::sendtoWait(uint8_t* buf, uint8_t len, uint8_t address, uint8_t f
     if (len > RH_MESH_MAX_MESSAGE_LEN)
 	return RH_ROUTER_ERROR_INVALID_LENGTH;
 
+    SourceRouteEntry* path = NULL;
     if (address != RH_BROADCAST_ADDRESS)
     {
-	RoutingTableEntry* route = getRouteTo(address);
-	if (!route && !doArp(address))
-	    return RH_ROUTER_ERROR_NO_ROUTE;
+	if (_source_routing)
+	    path = getSourceRouteTo(address);
+	if (!path && !getRouteTo(address))
+	{
+	    if (!doArp(address))
+		return RH_ROUTER_ERROR_NO_ROUTE;
+	    if (_source_routing)
+		path = getSourceRouteTo(address);
+	}
+	// A source routed message also carries the routelen, the path and a second msgType
+	if (   path
+	    && (   (size_t)len + 2 + path->numHops > RH_MESH_MAX_MESSAGE_LEN
+		|| (size_t)len + 3 + path->numHops + sizeof(RoutedMessageHeader) > _driver.maxMessageLength()))
+	{
+	    // Too long to carry the path, so route it hop-by-hop instead
+	    path = NULL;
+	    if (!getRouteTo(address) && !doArp(address))
+		return RH_ROUTER_ERROR_NO_ROUTE;
+	}
+    }
+
+    if (path)
+    {
+	// Embed the path and encapsulate the application layer message after it
+	MeshSourceRoutedMessage* s = (MeshSourceRoutedMessage*)&_tmpMessage;
+	s->header.msgType = RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED;
+	s->routelen = path->numHops;
+	memcpy(s->route, path->hops, path->numHops);
+	MeshApplicationMessage* a = (MeshApplicationMessage*)&s->route[path->numHops];
+	a->header.msgType = RH_MESH_MESSAGE_TYPE_APPLICATION;
+	memcpy(a->data, buf, len);
+	return RHRouter::sendtoWait(_tmpMessage, sizeof(RHMesh::MeshMessageHeader) + 1 + path->numHops + sizeof(RHMesh::MeshMessageHeader) + len, address, flags);
     }
 
     // Now have a route. Contruct an application layer message and send it via that route
@@ -66,6 +174,9 @@ bool RHMesh::doArp(uint8_t address)
     // FIXME: timeout should be configurable
     unsigned long starttime = millis();
     int32_t timeLeft;
+    // Dont let RHRouter::recvfromAck() return queued application messages, which would be lost
+    bool held = _e2eQueueHeld;
+    _e2eQueueHeld = true;
     while ((timeLeft = RH_MESH_ARP_TIMEOUT - (millis() - starttime)) > 0)
     {
 	if (waitAvailableTimeout(timeLeft))
@@ -78,12 +189,17 @@ bool RHMesh::doArp(uint8_t address)
 		    // Got a reply, now add the next hop to the dest to the routing table
 		    // The first hop taken is the first octet
 		    addRouteTo(address, headerFrom());
+		    // and keep the whole path if we are going to source route
+		    if (_source_routing)
+			addSourceRouteTo(address, p->route, messageLen - sizeof(RHMesh::MeshMessageHeader) - 2);
+		    _e2eQueueHeld = held;
 		    return true;
 		}
 	    }
 	}
 	YIELD;
     }
+    _e2eQueueHeld = held;
     return false;
 }
 
@@ -116,12 +232,29 @@ void RHMesh::peekAtMessage(RoutedMessage* message, uint8_t messageLen)
 	MeshRouteFailureMessage* d = (MeshRouteFailureMessage*)message->data;
 	deleteRouteTo(d->dest);
     }
+    else if (   _source_routing
+	     && message->header.dest == _thisAddress
+	     && messageLen > sizeof(RoutedMessageHeader) + sizeof(MeshMessageHeader) + 1
+	     && m->msgType == RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED)
+    {
+	// A source routed message for us. Remember the way back, so we can reply 
+	// (or acknowledge end-to-end) without route discovery
+	MeshSourceRoutedMessage* d = (MeshSourceRoutedMessage*)message->data;
+	if (   messageLen >= sizeof(RoutedMessageHeader) + sizeof(MeshMessageHeader) + 1 + d->routelen + sizeof(MeshMessageHeader)
+	    && d->route[d->routelen] == RH_MESH_MESSAGE_TYPE_APPLICATION)
+	    addSourceRouteTo(message->header.source, d->route, d->routelen, true);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 // This is called when a message is to be delivered to the next hop
 uint8_t RHMesh::route(RoutedMessage* message, uint8_t messageLen)
 {
+    if (   messageLen > sizeof(RoutedMessageHeader) + 1
+	&& message->data[0] == RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED
+	&& message->header.dest != RH_BROADCAST_ADDRESS)
+	return sourceRoute(message, messageLen);
+
     uint8_t from = headerFrom(); // Might get clobbered during call to superclass route()
     uint8_t ret = RHRouter::route(message, messageLen);
     if (   ret == RH_ROUTER_ERROR_NO_ROUTE
@@ -143,6 +276,81 @@ uint8_t RHMesh::route(RoutedMessage* message, uint8_t messageLen)
     return ret;
 }
 
+////////////////////////////////////////////////////////////////////
+// Forwards a source routed message to the next node in its embedded path,
+// without looking at the routing table
+uint8_t RHMesh::sourceRoute(RoutedMessage* message, uint8_t messageLen)
+{
+    MeshSourceRoutedMessage* s = (MeshSourceRoutedMessage*)message->data;
+    uint8_t routelen = s->routelen;
+    // Need at least the path and the encapsulated msgType
+    if (messageLen < sizeof(RoutedMessageHeader) + sizeof(MeshMessageHeader) + 1 + routelen + sizeof(MeshMessageHeader))
+	return RH_ROUTER_ERROR_INVALID_LENGTH;
+
+    // Find us in the path. The next hop is the one after us, or the dest if we are last
+    uint8_t i = 0;
+    if (message->header.source != _thisAddress)
+    {
+	while (i < routelen && s->route[i] != _thisAddress)
+	    i++;
+	if (i == routelen)
+	    return RH_ROUTER_ERROR_NO_ROUTE; // Not on the path, so not ours to forward
+	i++;
+    }
+    uint8_t next_hop = (i < routelen) ? s->route[i] : message->header.dest;
+
+    // message may get clobbered by the calls below
+    uint8_t source = message->header.source;
+    uint8_t dest = message->header.dest;
+    uint8_t innerType = s->route[routelen];
+    if (RHReliableDatagram::sendtoWait((uint8_t*)message, messageLen, next_hop))
+	return RH_ROUTER_ERROR_NONE;
+
+    if (source == _thisAddress)
+    {
+	// Our own path is broken. Forget it, so the next message will rediscover
+	deleteSourceRouteTo(dest);
+	deleteRouteTo(dest);
+    }
+    else if (innerType != RH_MESH_MESSAGE_TYPE_ROUTE_FAILURE)
+    {
+	// Tell only the originator, source routed back along the part of the path already 
+	// traversed, so nodes along the way dont need routes back to it
+	MeshSourceRoutedMessage* p = (MeshSourceRoutedMessage*)&_tmpMessage;
+	p->header.msgType = RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED;
+	p->routelen = i - 1; // The nodes before us
+	uint8_t j;
+	for (j = 0; j < p->routelen; j++)
+	    p->route[j] = s->route[p->routelen - 1 - j];
+	MeshRouteFailureMessage* f = (MeshRouteFailureMessage*)&p->route[p->routelen];
+	f->header.msgType = RH_MESH_MESSAGE_TYPE_ROUTE_FAILURE;
+	f->dest = dest; // Who you were trying to deliver to
+	RHRouter::sendtoWait(_tmpMessage, sizeof(RHMesh::MeshMessageHeader) + 1 + p->routelen + sizeof(MeshRouteFailureMessage), source);
+    }
+    return RH_ROUTER_ERROR_UNABLE_TO_DELIVER;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHMesh::acknowledgeE2E(uint8_t id, uint8_t dest)
+{
+    SourceRouteEntry* path = _source_routing ? getSourceRouteTo(dest) : NULL;
+    if (!path)
+    {
+	RHRouter::acknowledgeE2E(id, dest);
+	return;
+    }
+    // The ACK reads as an empty application message, source routed back along the path.
+    // Cant use _tmpMessage: it holds the message being acknowledged
+    uint8_t ack[sizeof(RHMesh::MeshMessageHeader) + 1 + RH_MESH_MAX_SOURCE_ROUTE_HOPS + sizeof(RHMesh::MeshMessageHeader)];
+    MeshSourceRoutedMessage* s = (MeshSourceRoutedMessage*)ack;
+    s->header.msgType = RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED;
+    s->routelen = path->numHops;
+    memcpy(s->route, path->hops, path->numHops);
+    s->route[path->numHops] = RH_MESH_MESSAGE_TYPE_APPLICATION;
+    sendtoFromSourceIdWait(ack, sizeof(RHMesh::MeshMessageHeader) + 1 + path->numHops + sizeof(RHMesh::MeshMessageHeader), 
+			   dest, _thisAddress, id, RH_ROUTER_FLAGS_E2E_ACK);
+}
+
 ////////////////////////////////////////////////////////////////////
 // Subclasses may want to override
 bool RHMesh::isPhysicalAddress(uint8_t* address, uint8_t addresslen)
@@ -159,6 +367,8 @@ bool RHMesh::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t* d
     uint8_t _dest;
     uint8_t _id;
     uint8_t _flags;
+    if (popE2EQueue(buf, len, source, dest, id, flags))
+	return true;
     if (RHRouter::recvfromAck(_tmpMessage, &tmpMessageLen, &_source, &_dest, &_id, &_flags))
     {
 	MeshMessageHeader* p = (MeshMessageHeader*)&_tmpMessage;
@@ -179,6 +389,38 @@ bool RHMesh::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t* d
 	    
 	    return true;
 	}
+	else if (   tmpMessageLen > sizeof(MeshMessageHeader) + 1
+		 && p->msgType == RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED)
+	{
+	    MeshSourceRoutedMessage* s = (MeshSourceRoutedMessage*)p;
+	    // The encapsulated message follows the path
+	    uint8_t offset = sizeof(MeshMessageHeader) + 1 + s->routelen;
+	    if (tmpMessageLen < offset + sizeof(MeshMessageHeader))
+		return false;
+	    MeshMessageHeader* m = (MeshMessageHeader*)&s->route[s->routelen];
+	    if (m->msgType == RH_MESH_MESSAGE_TYPE_APPLICATION)
+	    {
+		MeshApplicationMessage* a = (MeshApplicationMessage*)m;
+		if (source) *source = _source;
+		if (dest)   *dest   = _dest;
+		if (id)     *id     = _id;
+		if (flags)  *flags  = _flags;
+		uint8_t msgLen = tmpMessageLen - offset - sizeof(MeshMessageHeader);
+		if (*len > msgLen)
+		    *len = msgLen;
+		memcpy(buf, a->data, *len);
+
+		return true;
+	    }
+	    else if (   m->msgType == RH_MESH_MESSAGE_TYPE_ROUTE_FAILURE
+		     && tmpMessageLen >= offset + sizeof(MeshRouteFailureMessage))
+	    {
+		// A path we originated is broken
+		MeshRouteFailureMessage* f = (MeshRouteFailureMessage*)m;
+		deleteSourceRouteTo(f->dest);
+		deleteRouteTo(f->dest);
+	    }
+	}
 	else if (   _dest == RH_BROADCAST_ADDRESS 
 		 && tmpMessageLen > 1 
 		 && p->msgType == RH_MESH_MESSAGE_TYPE_ROUTE_DISCOVERY_REQUEST)
@@ -233,6 +475,8 @@ bool RHMesh::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t* d
 ////////////////////////////////////////////////////////////////////
 bool RHMesh::recvfromAckTimeout(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags)
 {  
+    if (popE2EQueue(buf, len, from, to, id, flags))
+	return true;
     unsigned long starttime = millis();
     int32_t timeLeft;
     while ((timeLeft = timeout - (millis() - starttime)) > 0)
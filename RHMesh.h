@@ -14,10 +14,18 @@
 #define RH_MESH_MESSAGE_TYPE_ROUTE_DISCOVERY_REQUEST        1
 #define RH_MESH_MESSAGE_TYPE_ROUTE_DISCOVERY_RESPONSE       2
 #define RH_MESH_MESSAGE_TYPE_ROUTE_FAILURE                  3
+#define RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED                  4
 
 // Timeout for address resolution in milliecs
 #define RH_MESH_ARP_TIMEOUT 4000
 
+// The number of discovered paths the originator keeps for source routing
+#define RH_MESH_SOURCE_ROUTE_TABLE_SIZE 4
+
+// The max number of intermediate nodes in a stored source route.
+// Longer discovered paths are routed hop-by-hop instead
+#define RH_MESH_MAX_SOURCE_ROUTE_HOPS 8
+
 /////////////////////////////////////////////////////////////////////
 /// \class RHMesh RHMesh.h <RHMesh.h>
 /// \brief RHRouter subclass for sending addressed, optionally acknowledged datagrams
@@ -84,6 +92,26 @@
 /// (either because an intermediate node is off the air, or has moved out of range) a new route 
 /// will be established the next time a message is to be sent.
 ///
+/// \par Source Routing
+///
+/// By default, messages are routed hop-by-hop: each node looks up the next hop in its own routing table,
+/// so the tables of all the intermediate nodes have to stay consistent.
+/// If source routing is enabled with setSourceRouting(true), the originating node keeps the complete list of 
+/// intermediate nodes from the RH_MESH_MESSAGE_TYPE_ROUTE_DISCOVERY_RESPONSE (up to 
+/// RH_MESH_SOURCE_ROUTE_TABLE_SIZE destinations, each up to RH_MESH_MAX_SOURCE_ROUTE_HOPS hops long) 
+/// and embeds it in each message it sends, as a MeshSourceRoutedMessage (message type 
+/// RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED). Intermediate nodes forward such messages to the next node listed 
+/// in the message, without consulting or modifying their routing tables. 
+/// A destination node that receives a source routed message remembers the reversed path, 
+/// so it can reply without its own route discovery.
+/// If an intermediate node cannot deliver a source routed message to the next hop, it returns a 
+/// RH_MESH_MESSAGE_TYPE_ROUTE_FAILURE to the originator only, source routed back along the path the message 
+/// came by, and the originator discards the path. 
+/// All nodes running this version of RHMesh forward source routed messages, regardless of whether they have 
+/// source routing enabled themselves.
+/// Source routed messages carry 2 + (number of intermediate nodes) octets more than hop-by-hop messages. 
+/// If the message does not fit, or no suitable path is known, it is routed hop-by-hop.
+///
 /// \par Message Format
 ///
 /// RHMesh uses a number of message formats layered on top of RHRouter:
@@ -94,6 +122,8 @@
 ///   (broadcast) and replies (unicast).
 /// - MeshRouteFailureMessage (message type RH_MESH_MESSAGE_TYPE_ROUTE_FAILURE) Informs nodes of 
 ///   route failures.
+/// - MeshSourceRoutedMessage (message type RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED) Carries the list of 
+///   intermediate nodes to the destination, followed by one of the other message types
 ///
 /// Part of the Arduino RH library for operating with HopeRF RH compatible transceivers 
 /// (see http://www.hoperf.com)
@@ -148,15 +178,53 @@ public:
 	uint8_t             dest; ///< The address of the destination towards which the route failed
     } MeshRouteFailureMessage;
 
+    /// Signals a message carrying its own route. The encapsulated RHMesh message 
+    /// (MeshApplicationMessage or MeshRouteFailureMessage) follows the routelen octets of route
+    typedef struct
+    {
+	MeshMessageHeader   header;   ///< msgType = RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED
+	uint8_t             routelen; ///< Number of intermediate node addresses in route
+	uint8_t             route[RH_MESH_MAX_MESSAGE_LEN - 1]; ///< Intermediate nodes in order from the source, then the encapsulated message
+    } MeshSourceRoutedMessage;
+
+    /// Defines an entry in the source route table
+    typedef struct
+    {
+	uint8_t      dest;      ///< Destination node address
+	uint8_t      state;     ///< State of this route, one of RouteState
+	uint8_t      numHops;   ///< Number of intermediate nodes in hops
+	uint8_t      hops[RH_MESH_MAX_SOURCE_ROUTE_HOPS]; ///< Intermediate node addresses in order from this node
+    } SourceRouteEntry;
+
     /// Constructor. 
     /// \param[in] driver The RadioHead driver to use to transport messages.
     /// \param[in] thisAddress The address to assign to this node. Defaults to 0
     RHMesh(RHGenericDriver& driver, uint8_t thisAddress = 0);
 
+    /// Sets the flag determining if messages originated by this node will be source routed 
+    /// along discovered paths. The default is false (route hop-by-hop).
+    /// Forwarding of source routed messages from other nodes does not depend on this setting.
+    /// \param[in] source_routing true or false
+    void setSourceRouting(bool source_routing);
+
+    /// Finds and returns a SourceRouteEntry for the given destination node
+    /// \param [in] dest The desired destination node address.
+    /// \return pointer to a SourceRouteEntry for dest, or NULL if no path is known
+    SourceRouteEntry* getSourceRouteTo(uint8_t dest);
+
+    /// Deletes from the source route table any path for the destination node.
+    /// \param [in] dest The destination node address
+    /// \return true if the path was present
+    bool deleteSourceRouteTo(uint8_t dest);
+
+    /// Clears all entries from the source route table
+    void clearSourceRoutingTable();
+
     /// Sends a message to the destination node. Initialises the RHRouter message header 
     /// (the SOURCE address is set to the address of this node, HOPS to 0) and calls 
     /// route() which looks up in the routing table the next hop to deliver to.
     /// If no route is known, initiates route discovery and waits for a reply.
+    /// If source routing is enabled and a path to dest is known, the path is embedded in the message.
     /// Then sends the message to the next hop
     /// Then waits for an acknowledgement from the next hop 
     /// (but not from the destination node (if that is different).
@@ -172,7 +240,7 @@ public:
     ///         - RH_ROUTER_ERROR_NO_ROUTE There was no route for dest in the local routing table
     ///         - RH_ROUTER_ERROR_UNABLE_TO_DELIVER Not able to deliver to the next hop 
     ///           (usually because it dod not acknowledge due to being off the air or out of range
-    uint8_t sendtoWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags = 0);
+    virtual uint8_t sendtoWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags = 0);
 
     /// Starts the receiver if it is not running already, processes and possibly routes any received messages
     /// addressed to other nodes
@@ -247,7 +315,38 @@ protected:
     /// \return true if the physical address of this node is identical to address
     virtual bool isPhysicalAddress(uint8_t* address, uint8_t addresslen);
 
+    /// Adds a path to the source route table, or updates it if already present.
+    /// If there is not enough room the oldest (first) path will be deleted.
+    /// \param [in] dest The destination node address
+    /// \param [in] hops The intermediate node addresses
+    /// \param [in] numHops Number of addresses in hops. Must not exceed RH_MESH_MAX_SOURCE_ROUTE_HOPS
+    /// \param [in] reverse If true, hops are in order from dest towards this node
+    void addSourceRouteTo(uint8_t dest, uint8_t* hops, uint8_t numHops, bool reverse = false);
+
+    /// Forwards a RH_MESH_MESSAGE_TYPE_SOURCE_ROUTED message to the next node listed in it.
+    /// Called by route(). Does not use the routing table.
+    /// \param [in] message Pointer to the RHRouter message to be sent.
+    /// \param [in] messageLen Length of message in octets
+    /// \return One of RH_ROUTER_ERROR_*
+    uint8_t sourceRoute(RoutedMessage* message, uint8_t messageLen);
+
+    /// Routes an end-to-end acknowledgement back to the source of a message, 
+    /// source routed if a path is known.
+    /// \param [in] id The ID of the message being acknowledged
+    /// \param [in] dest The source of the message being acknowledged
+    virtual void acknowledgeE2E(uint8_t id, uint8_t dest);
+
+    /// Flag to set if messages originated here are source routed
+    bool _source_routing;
+
 private:
+    /// Deletes a specific entry from the source route table
+    /// \param [in] index The 0 based index of the source route table entry to delete
+    void deleteSourceRoute(uint8_t index);
+
+    /// Local source route table
+    SourceRouteEntry _sourceRoutes[RH_MESH_SOURCE_ROUTE_TABLE_SIZE];
+
     /// Temporary message buffer
     static uint8_t _tmpMessage[RH_ROUTER_MAX_MESSAGE_LEN];
 
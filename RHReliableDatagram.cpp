@@ -71,6 +71,17 @@ bool RHReliableDatagram::sendtoWait(uint8_t* buf, uint8_t len, uint8_t address)
         setHeaderFlags(headerFlagsToSet, headerFlagsToClear);
 
         sendto(buf, len, address);
+        if (address != RH_BROADCAST_ADDRESS && _driver.hardwareAcknowledge())
+        {
+            // The radio does the ACKs and retransmissions itself, and
+            // only reports the message as sent if it was acknowledged
+            if (waitPacketSent())
+                return true;
+            if (retries > 1)
+                _retransmissions++;
+            YIELD;
+            continue;
+        }
 #if (RH_PLATFORM == RH_PLATFORM_RASPI)
         // _driver.send(...) already uses waitPacketSent()
 #else
@@ -149,10 +160,10 @@ bool RHReliableDatagram::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* from,
         if (!(_flags & RH_FLAGS_ACK))
         {
             // Its a normal message not an ACK
-            if (_to ==_thisAddress)
+            if (_to ==_thisAddress && !_driver.hardwareAcknowledge())
             {
                 // Its for this node and
-                // Its not a broadcast, so ACK it
+                // Its not a broadcast, so ACK it (unless the radio already did)
                 // Acknowledge message with ACK set in flags and ID set to received ID
                 acknowledge(_id, _from);
             }
@@ -22,7 +22,16 @@ RHRouter::RHRouter(RHGenericDriver& driver, uint8_t thisAddress)
 {
     _max_hops = RH_DEFAULT_MAX_HOPS;
     _isa_router = true;
+    _e2eTimeout = RH_ROUTER_DEFAULT_E2E_TIMEOUT;
+    _e2eRetries = RH_ROUTER_DEFAULT_E2E_RETRIES;
     clearRoutingTable();
+    memset(_receipts, 0, sizeof(_receipts));
+    memset(_seenE2E, 0xff, sizeof(_seenE2E));
+    _seenE2EIndex = 0;
+#if RH_ROUTER_E2E_QUEUE_SIZE > 0
+    _e2eQueueLen = 0;
+#endif
+    _e2eQueueHeld = false;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -46,6 +55,18 @@ void RHRouter::setIsaRouter(bool isa_router)
 {
     _isa_router = isa_router;
 }
+
+////////////////////////////////////////////////////////////////////
+void RHRouter::setE2ETimeout(uint16_t timeout)
+{
+    _e2eTimeout = timeout;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHRouter::setE2ERetries(uint8_t retries)
+{
+    _e2eRetries = retries;
+}
 ////////////////////////////////////////////////////////////////////
 void RHRouter::addRouteTo(uint8_t dest, uint8_t next_hop, uint8_t state)
 {
@@ -162,9 +183,192 @@ uint8_t RHRouter::sendtoWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t fl
     return sendtoFromSourceWait(buf, len, dest, _thisAddress, flags);
 }
 
+#if RH_ROUTER_E2E_QUEUE_SIZE > 0
+////////////////////////////////////////////////////////////////////
+// Waits for delivery to the final destination
+uint8_t RHRouter::sendtoWaitE2E(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags)
+{
+    if (dest == RH_BROADCAST_ADDRESS)
+	return sendtoWait(buf, len, dest, flags);
+
+    // Retries reuse the ID so the destination can discard duplicates
+    uint8_t thisSequenceNumber = _lastE2ESequenceNumber;
+    uint8_t ret = RH_ROUTER_ERROR_NO_REPLY;
+    uint8_t retries = 0;
+    while (retries++ <= _e2eRetries)
+    {
+	_lastE2ESequenceNumber = thisSequenceNumber;
+	ret = sendtoWait(buf, len, dest, flags | RH_ROUTER_FLAGS_E2E_ACK_REQUEST);
+	if (ret != RH_ROUTER_ERROR_NONE)
+	    continue; // Maybe a route will be found or the next hop will respond next time
+	// The ID actually used: subclasses may have sent their own messages first
+	uint8_t id = _lastE2ESequenceNumber - 1;
+	DeliveryReceipt* receipt = addReceipt(dest, id);
+	thisSequenceNumber = id;
+
+	// Process incoming messages until the ACK arrives or timeout.
+	// Messages for us are queued for later calls to recvfromAck()
+	unsigned long starttime = millis();
+	int32_t timeLeft;
+	bool held = _e2eQueueHeld;
+	_e2eQueueHeld = true;
+	while (   receipt->state == ReceiptPending
+	       && _e2eQueueLen < RH_ROUTER_E2E_QUEUE_SIZE
+	       && (timeLeft = _e2eTimeout - (millis() - starttime)) > 0)
+	{
+	    if (waitAvailableTimeout(timeLeft))
+	    {
+		QueuedMessage* q = &_e2eQueue[_e2eQueueLen];
+		q->len = sizeof(q->data);
+		if (recvfromAck(q->data, &q->len, &q->source, &q->dest, &q->id, &q->flags))
+		    _e2eQueueLen++;
+	    }
+	    YIELD;
+	}
+	_e2eQueueHeld = held;
+	bool delivered = receipt->state == ReceiptDelivered;
+	deleteReceipt(receipt - _receipts);
+	if (delivered)
+	    return RH_ROUTER_ERROR_NONE;
+	if (_e2eQueueLen >= RH_ROUTER_E2E_QUEUE_SIZE)
+	    return RH_ROUTER_ERROR_NO_REPLY; // Cant receive any more without losing messages
+	ret = RH_ROUTER_ERROR_NO_REPLY;
+    }
+    return ret;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////
+uint8_t RHRouter::sendtoWaitReceipt(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags, uint8_t* id)
+{
+    if (dest != RH_BROADCAST_ADDRESS)
+	flags |= RH_ROUTER_FLAGS_E2E_ACK_REQUEST;
+    uint8_t ret = sendtoWait(buf, len, dest, flags);
+    // The ID actually used: subclasses may have sent their own messages first
+    uint8_t thisSequenceNumber = _lastE2ESequenceNumber - 1;
+    if (ret == RH_ROUTER_ERROR_NONE && dest != RH_BROADCAST_ADDRESS)
+	addReceipt(dest, thisSequenceNumber);
+    if (id) *id = thisSequenceNumber;
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHRouter::deliveryReceipt(uint8_t* dest, uint8_t* id, bool* delivered)
+{
+    uint8_t i;
+    for (i = 0; i < RH_ROUTER_E2E_RECEIPTS_SIZE; i++)
+    {
+	if (   _receipts[i].state == ReceiptPending
+	    && (millis() - _receipts[i].sentTime) > _e2eTimeout)
+	    _receipts[i].state = ReceiptTimeout;
+	if (   _receipts[i].state == ReceiptDelivered
+	    || _receipts[i].state == ReceiptTimeout)
+	{
+	    if (dest)      *dest      = _receipts[i].dest;
+	    if (id)        *id        = _receipts[i].id;
+	    if (delivered) *delivered = _receipts[i].state == ReceiptDelivered;
+	    deleteReceipt(i);
+	    return true;
+	}
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+RHRouter::DeliveryReceipt* RHRouter::addReceipt(uint8_t dest, uint8_t id)
+{
+    uint8_t i;
+    for (i = 0; i < RH_ROUTER_E2E_RECEIPTS_SIZE; i++)
+	if (_receipts[i].state == ReceiptNone)
+	    break;
+    if (i == RH_ROUTER_E2E_RECEIPTS_SIZE)
+    {
+	// Need to make room for a new one
+	deleteReceipt(0);
+	i = RH_ROUTER_E2E_RECEIPTS_SIZE - 1;
+    }
+    _receipts[i].dest = dest;
+    _receipts[i].id = id;
+    _receipts[i].state = ReceiptPending;
+    _receipts[i].sentTime = millis();
+    return &_receipts[i];
+}
+
+////////////////////////////////////////////////////////////////////
+RHRouter::DeliveryReceipt* RHRouter::getReceipt(uint8_t dest, uint8_t id, uint8_t state)
+{
+    uint8_t i;
+    for (i = 0; i < RH_ROUTER_E2E_RECEIPTS_SIZE; i++)
+	if (_receipts[i].dest == dest && _receipts[i].id == id && _receipts[i].state == state)
+	    return &_receipts[i];
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHRouter::deleteReceipt(uint8_t index)
+{
+    // Delete a receipt by moving following receipts on top of it, so the oldest stays first
+    memmove(&_receipts[index], &_receipts[index+1], 
+	    sizeof(DeliveryReceipt) * (RH_ROUTER_E2E_RECEIPTS_SIZE - index - 1));
+    _receipts[RH_ROUTER_E2E_RECEIPTS_SIZE - 1].state = ReceiptNone;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHRouter::seenE2E(uint8_t source, uint8_t id)
+{
+    uint16_t key = ((uint16_t)source << 8) | id;
+    uint8_t i;
+    for (i = 0; i < RH_ROUTER_E2E_SEEN_SIZE; i++)
+	if (_seenE2E[i] == key)
+	    return true;
+    _seenE2E[_seenE2EIndex] = key;
+    _seenE2EIndex = (_seenE2EIndex + 1) % RH_ROUTER_E2E_SEEN_SIZE;
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHRouter::popE2EQueue(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t* dest, uint8_t* id, uint8_t* flags)
+{
+#if RH_ROUTER_E2E_QUEUE_SIZE > 0
+    if (_e2eQueueHeld || !_e2eQueueLen)
+	return false;
+
+    QueuedMessage* q = &_e2eQueue[0];
+    if (source) *source  = q->source;
+    if (dest)   *dest    = q->dest;
+    if (id)     *id      = q->id;
+    if (flags)  *flags   = q->flags;
+    if (*len > q->len)
+	*len = q->len;
+    memcpy(buf, q->data, *len);
+    _e2eQueueLen--;
+    memmove(&_e2eQueue[0], &_e2eQueue[1], sizeof(QueuedMessage) * _e2eQueueLen);
+    return true;
+#else
+    (void)buf; (void)len; (void)source; (void)dest; (void)id; (void)flags;
+    return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+void RHRouter::acknowledgeE2E(uint8_t id, uint8_t dest)
+{
+    // Not a zero length ACK, see RHReliableDatagram::acknowledge().
+    // Also reads as an application message to RHMesh nodes along the way
+    uint8_t ack = RH_ROUTER_ERROR_NONE;
+    // REVISIT: if this fails, the source will resend and we will ACK again
+    sendtoFromSourceIdWait(&ack, sizeof(ack), dest, _thisAddress, id, RH_ROUTER_FLAGS_E2E_ACK);
+}
+
 ////////////////////////////////////////////////////////////////////
 // Waits for delivery to the next hop (but not for delivery to the final destination)
 uint8_t RHRouter::sendtoFromSourceWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t source, uint8_t flags)
+{
+    return sendtoFromSourceIdWait(buf, len, dest, source, _lastE2ESequenceNumber++, flags);
+}
+
+////////////////////////////////////////////////////////////////////
+uint8_t RHRouter::sendtoFromSourceIdWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t source, uint8_t id, uint8_t flags)
 {
     if (((uint16_t)len + sizeof(RoutedMessageHeader)) > _driver.maxMessageLength())
 	return RH_ROUTER_ERROR_INVALID_LENGTH;
@@ -173,7 +377,7 @@ uint8_t RHRouter::sendtoFromSourceWait(uint8_t* buf, uint8_t len, uint8_t dest,
     _tmpMessage.header.source = source;
     _tmpMessage.header.dest = dest;
     _tmpMessage.header.hops = 0;
-    _tmpMessage.header.id = _lastE2ESequenceNumber++;
+    _tmpMessage.header.id = id;
     _tmpMessage.header.flags = flags;
     memcpy(_tmpMessage.data, buf, len);
 
@@ -216,6 +420,8 @@ bool RHRouter::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t*
     uint8_t _to;
     uint8_t _id;
     uint8_t _flags;
+    if (popE2EQueue(buf, len, source, dest, id, flags))
+	return true;
     if (RHReliableDatagram::recvfromAck((uint8_t*)&_tmpMessage, &tmpMessageLen, &_from, &_to, &_id, &_flags))
     {
 	// Here we simulate networks with limited visibility between nodes
@@ -271,6 +477,19 @@ bool RHRouter::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t*
 	// See if its for us or has to be routed
 	if (_tmpMessage.header.dest == _thisAddress || _tmpMessage.header.dest == RH_BROADCAST_ADDRESS)
 	{
+	    if (   _tmpMessage.header.dest == _thisAddress
+		&& (_tmpMessage.header.flags & RH_ROUTER_FLAGS_E2E_ACK))
+	    {
+		// End-to-end ACK for a message we sent, complete its receipt
+		DeliveryReceipt* receipt = getReceipt(_tmpMessage.header.source, _tmpMessage.header.id, ReceiptPending);
+		if (receipt)
+		    receipt->state = ReceiptDelivered;
+		return false;
+	    }
+	    bool ackE2E =    _tmpMessage.header.dest == _thisAddress
+		          && (_tmpMessage.header.flags & RH_ROUTER_FLAGS_E2E_ACK_REQUEST);
+	    bool duplicate = ackE2E && seenE2E(_tmpMessage.header.source, _tmpMessage.header.id);
+
 	    // Deliver it here
 	    if (source) *source  = _tmpMessage.header.source;
 	    if (dest)   *dest    = _tmpMessage.header.dest;
@@ -280,7 +499,10 @@ bool RHRouter::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t*
 	    if (*len > msgLen)
 		*len = msgLen;
 	    memcpy(buf, _tmpMessage.data, *len);
-	    return true; // Its for you!
+	    // Clobbers _tmpMessage
+	    if (ackE2E)
+		acknowledgeE2E(_tmpMessage.header.id, _tmpMessage.header.source);
+	    return !duplicate; // Its for you! Unless we already had it
 	}
 	else if (   _tmpMessage.header.dest != RH_BROADCAST_ADDRESS
 		 && _tmpMessage.header.hops++ < _max_hops)
@@ -301,6 +523,8 @@ bool RHRouter::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t*
 ////////////////////////////////////////////////////////////////////
 bool RHRouter::recvfromAckTimeout(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* source, uint8_t* dest, uint8_t* id, uint8_t* flags)
 {  
+    if (popE2EQueue(buf, len, source, dest, id, flags))
+	return true;
     unsigned long starttime = millis();
     int32_t timeLeft;
     while ((timeLeft = timeout - (millis() - starttime)) > 0)
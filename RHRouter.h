@@ -15,6 +15,34 @@
 // The default size of the routing table we keep
 #define RH_ROUTING_TABLE_SIZE 10
 
+// Default timeout in milliseconds for an end-to-end acknowledgement
+#define RH_ROUTER_DEFAULT_E2E_TIMEOUT 2000
+
+// Default number of end-to-end retries
+#define RH_ROUTER_DEFAULT_E2E_RETRIES 2
+
+// The number of delivery receipts we can be waiting for at once
+#define RH_ROUTER_E2E_RECEIPTS_SIZE 4
+
+// The number of recent end-to-end acknowledged messages remembered, to discard duplicates
+#define RH_ROUTER_E2E_SEEN_SIZE 8
+
+// The number of messages for this node that can be held while sendtoWaitE2E() waits for an acknowledgement.
+// Each one takes about RH_ROUTER_MAX_MESSAGE_LEN octets of RAM. At least 2 lets the destination reply
+// before its acknowledgement arrives. 0 leaves out sendtoWaitE2E() and the queue altogether, which is
+// the default on small processors: define it (eg -DRH_ROUTER_E2E_QUEUE_SIZE=2) to use sendtoWaitE2E() there
+#ifndef RH_ROUTER_E2E_QUEUE_SIZE
+ #if defined(__AVR__) || (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8) || (RH_PLATFORM == RH_PLATFORM_ATTINY) || (RH_PLATFORM == RH_PLATFORM_ATTINY_MEGA) || (RH_PLATFORM == RH_PLATFORM_MSP430)
+  #define RH_ROUTER_E2E_QUEUE_SIZE 0
+ #else
+  #define RH_ROUTER_E2E_QUEUE_SIZE 4
+ #endif
+#endif
+
+// End-to-end flags in the RHRouter header. The remaining bits are for the application
+#define RH_ROUTER_FLAGS_E2E_ACK           0x80
+#define RH_ROUTER_FLAGS_E2E_ACK_REQUEST   0x40
+
 // Error codes
 #define RH_ROUTER_ERROR_NONE              0
 #define RH_ROUTER_ERROR_INVALID_LENGTH    1
@@ -71,9 +99,9 @@
 /// call recvfromAck() or recvfromAckTimeout() frequently in your main loop. recvfromAck() will return 
 /// false if it receives a message but it is not for this node.
 ///
-/// RHRouter does not provide reliable end-to-end delivery, but uses reliable hop-to-hop delivery. 
+/// RHRouter does not provide reliable end-to-end delivery by default, but uses reliable hop-to-hop delivery. 
 /// If a message is unable to be delivered to an end node during to a delivery failure between 2 hops, 
-/// the source node will not be told about it.
+/// the source node will not be told about it. See End-to-end Acknowledgement below if you need to know.
 ///
 /// Note: This class is most useful for networks of nodes that are essentially static 
 /// (i.e. the nodes dont move around), and for which the 
@@ -95,6 +123,31 @@
 /// if more than RH_ROUTING_TABLE_SIZE are added, the oldest (first) one will be removed by calling 
 /// retireOldestRoute()
 ///
+/// \par End-to-end Acknowledgement
+///
+/// sendtoWaitE2E() sets RH_ROUTER_FLAGS_E2E_ACK_REQUEST in the FLAGS header. When the destination node
+/// receives such a message in recvfromAck() it routes back to the source a 1 octet message with the same ID
+/// and RH_ROUTER_FLAGS_E2E_ACK set in the FLAGS header. sendtoWaitE2E() waits up to the E2E timeout
+/// (see setE2ETimeout()) for that acknowledgement, and resends the message with the same ID up to 
+/// the E2E retries (see setE2ERetries()) times. Duplicates received by the destination due to lost 
+/// acknowledgements are acknowledged again, but not delivered again.
+///
+/// Messages for this node that arrive while sendtoWaitE2E() is waiting are acknowledged as usual and held
+/// in a queue of RH_ROUTER_E2E_QUEUE_SIZE messages, which the following calls to recvfromAck() return
+/// before anything else. If the queue is full, sendtoWaitE2E() stops receiving and returns
+/// RH_ROUTER_ERROR_NO_REPLY, rather than acknowledge a message it cannot keep.
+/// The queue costs about RH_ROUTER_E2E_QUEUE_SIZE * RH_ROUTER_MAX_MESSAGE_LEN octets of RAM, so on AVR and other
+/// small processors RH_ROUTER_E2E_QUEUE_SIZE defaults to 0, which leaves out sendtoWaitE2E() and the queue.
+/// Define RH_ROUTER_E2E_QUEUE_SIZE before including RHRouter.h to use it there.
+///
+/// If you do not want to block until the acknowledgement arrives, use sendtoWaitReceipt(), which returns
+/// as soon as the message is delivered to the next hop, and later poll deliveryReceipt() 
+/// (while calling recvfromAck() frequently) to find out whether each message was acknowledged
+/// by its destination within the E2E timeout. There are no retries in that case.
+///
+/// All the nodes must be running a version of RHRouter that supports end-to-end acknowledgement.
+/// The application must not use the FLAGS bits RH_ROUTER_FLAGS_E2E_ACK and RH_ROUTER_FLAGS_E2E_ACK_REQUEST.
+///
 /// \par Message Format
 ///
 /// RHRouter add to the lower level RHReliableDatagram (and even lower level RH) class message formats. 
@@ -107,9 +160,10 @@
 /// - 1 octet SOURCE, the source node address (ie the address of the originating node that first sent 
 ///   the message).
 /// - 1 octet HOPS, the number of hops this message has traversed so far.
-/// - 1 octet ID, an incrementing message ID for end-to-end message tracking for use by subclasses. 
-///   Not used by RHRouter.
-/// - 1 octet FLAGS, a bitmask for use by subclasses. Not used by RHRouter.
+/// - 1 octet ID, an incrementing message ID for end-to-end message tracking. 
+///   Used by RHRouter for end-to-end acknowledgements.
+/// - 1 octet FLAGS, a bitmask for use by subclasses. RHRouter uses RH_ROUTER_FLAGS_E2E_ACK 
+///   and RH_ROUTER_FLAGS_E2E_ACK_REQUEST.
 /// - 0 or more octets DATA, the application payload data. The length of this data is implicit 
 ///   in the length of the entire message.
 ///
@@ -168,6 +222,35 @@ public:
 	uint8_t      state;     ///< State of this route, one of RouteState
     } RoutingTableEntry;
 
+    /// Values for the possible states of delivery receipts
+    typedef enum
+    {
+	ReceiptNone = 0,       ///< Not in use
+	ReceiptPending,        ///< Waiting for the end-to-end acknowledgement
+	ReceiptDelivered,      ///< The destination acknowledged the message
+	ReceiptTimeout         ///< No acknowledgement within the E2E timeout
+    } ReceiptState;
+
+    /// Defines an entry in the table of delivery receipts
+    typedef struct
+    {
+	uint8_t       dest;     ///< Destination node address of the message
+	uint8_t       id;       ///< End-to-end ID of the message
+	uint8_t       state;    ///< State of this receipt, one of ReceiptState
+	unsigned long sentTime; ///< millis() when the message was sent
+    } DeliveryReceipt;
+
+    /// Defines a message for this node received while waiting in sendtoWaitE2E()
+    typedef struct
+    {
+	uint8_t       source;   ///< Source node address
+	uint8_t       dest;     ///< Destination node address
+	uint8_t       id;       ///< Message ID
+	uint8_t       flags;    ///< Message FLAGS
+	uint8_t       len;      ///< Number of octets in data
+	uint8_t       data[RH_ROUTER_MAX_MESSAGE_LEN]; ///< Application payload data
+    } QueuedMessage;
+
     /// Constructor. 
     /// \param[in] driver The RadioHead driver to use to transport messages.
     /// \param[in] thisAddress The address to assign to this node. Defaults to 0
@@ -193,6 +276,15 @@ public:
     /// \param [in] max_hops The new value for max_hops
     void setMaxHops(uint8_t max_hops);
 
+    /// Sets the maximum time to wait for an end-to-end acknowledgement from the destination node
+    /// \param [in] timeout The new timeout in milliseconds. Defaults to RH_ROUTER_DEFAULT_E2E_TIMEOUT
+    void setE2ETimeout(uint16_t timeout);
+
+    /// Sets the number of times sendtoWaitE2E() will resend a message that was not 
+    /// acknowledged end-to-end
+    /// \param [in] retries The new number of retries. Defaults to RH_ROUTER_DEFAULT_E2E_RETRIES
+    void setE2ERetries(uint8_t retries);
+
     /// Adds a route to the local routing table, or updates it if already present.
     /// If there is not enough room the oldest (first) route will be deleted by calling retireOldestRoute().
     /// \param [in] dest The destination node address. RH_BROADCAST_ADDRESS is permitted.
@@ -238,7 +330,48 @@ public:
     ///         - RH_ROUTER_ERROR_NO_ROUTE There was no route for dest in the local routing table
     ///         - RH_ROUTER_ERROR_UNABLE_TO_DELIVER Not able to deliver to the next hop 
     ///           (usually because it dod not acknowledge due to being off the air or out of range
-    uint8_t sendtoWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags = 0);
+    virtual uint8_t sendtoWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags = 0);
+
+    /// Sends a message to the destination node with sendtoWait() and waits for an acknowledgement
+    /// from the destination node itself. If none arrives within the E2E timeout, resends the message
+    /// (with the same ID) up to the E2E retries. Messages received for this node while waiting
+    /// are acknowledged and queued for the following calls to recvfromAck().
+    /// \param [in] buf The application message data
+    /// \param [in] len Number of octets in the application message data. 0 is permitted
+    /// \param [in] dest The destination node address. Broadcasts are sent by sendtoWait() without acknowledgement.
+    /// \param [in] flags Optional flags for use by subclasses or application layer, 
+    ///             delivered end-to-end to the dest address. The receiver can recover the flags with recvFromAck().
+    /// \return The result code:
+    ///         - RH_ROUTER_ERROR_NONE Message was delivered to and acknowledged by the final dest address
+    ///         - RH_ROUTER_ERROR_NO_REPLY No end-to-end acknowledgement after all retries
+    ///         - Any other error from sendtoWait() for the last attempt
+    /// Only available if RH_ROUTER_E2E_QUEUE_SIZE is greater than 0
+#if RH_ROUTER_E2E_QUEUE_SIZE > 0
+    uint8_t sendtoWaitE2E(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags = 0);
+#endif
+
+    /// Sends a message to the destination node with sendtoWait(), requesting an end-to-end
+    /// acknowledgement, but does not wait for it. The outcome is reported later by deliveryReceipt().
+    /// \param [in] buf The application message data
+    /// \param [in] len Number of octets in the application message data. 0 is permitted
+    /// \param [in] dest The destination node address. Broadcasts get no receipt.
+    /// \param [in] flags Optional flags for use by subclasses or application layer, 
+    ///             delivered end-to-end to the dest address.
+    /// \param [out] id If present and not NULL, the referenced uint8_t will be set to the ID of the message, 
+    ///             which will be reported by deliveryReceipt()
+    /// \return The result code of sendtoWait(). There will be a receipt only for RH_ROUTER_ERROR_NONE.
+    uint8_t sendtoWaitReceipt(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t flags = 0, uint8_t* id = NULL);
+
+    /// Returns the next completed delivery receipt for messages sent with sendtoWaitReceipt(), if any.
+    /// Acknowledgements are processed by recvfromAck(), so it must be called frequently.
+    /// A receipt is completed when the acknowledgement arrives, or when the E2E timeout expires.
+    /// If RH_ROUTER_E2E_RECEIPTS_SIZE receipts are pending, the oldest is discarded to make room for a new one.
+    /// \param [out] dest If present and not NULL, the referenced uint8_t will be set to the destination address
+    /// \param [out] id If present and not NULL, the referenced uint8_t will be set to the message ID
+    /// \param [out] delivered If present and not NULL, the referenced bool will be set true if the destination 
+    ///             acknowledged the message, or false if the E2E timeout expired
+    /// \return true if a completed receipt was returned
+    bool deliveryReceipt(uint8_t* dest = NULL, uint8_t* id = NULL, bool* delivered = NULL);
 
     /// Similar to sendtoWait() above, but spoofs the source address.
     /// For internal use only during routing
@@ -256,6 +389,18 @@ public:
     ///           (usually because it dod not acknowledge due to being off the air or out of range
     uint8_t sendtoFromSourceWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t source, uint8_t flags = 0);
 
+    /// Similar to sendtoFromSourceWait() above, but with the given end-to-end ID 
+    /// instead of the next sequence number.
+    /// For internal use only
+    /// \param [in] buf The application message data.
+    /// \param [in] len Number of octets in the application message data. 0 is permitted.
+    /// \param [in] dest The destination node address.
+    /// \param [in] source The (fake) originating node address.
+    /// \param [in] id The end-to-end ID for the RHRouter header
+    /// \param [in] flags The flags for the RHRouter header
+    /// \return The result code, as for sendtoFromSourceWait()
+    uint8_t sendtoFromSourceIdWait(uint8_t* buf, uint8_t len, uint8_t dest, uint8_t source, uint8_t id, uint8_t flags);
+
     /// Starts the receiver if it is not running already.
     /// If there is a valid message available for this node (or RH_BROADCAST_ADDRESS), 
     /// send an acknowledgement to the last hop
@@ -276,7 +421,7 @@ public:
     /// \param[in] flags If present and not NULL, the referenced uint8_t will be set to the FLAGS
     /// (not just those addressed to this node).
     /// \return true if a valid message was recvived for this node copied to buf
-    bool recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source = NULL, uint8_t* dest = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
+    virtual bool recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source = NULL, uint8_t* dest = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
 
     /// Starts the receiver if it is not running already.
     /// Similar to recvfromAck(), this will block until either a valid message available for this node
@@ -312,6 +457,42 @@ protected:
     /// \param [in] index The 0 based index of the routing table entry to delete
     void deleteRoute(uint8_t index);
 
+    /// Routes an end-to-end acknowledgement back to the source of a message.
+    /// Virtual so subclasses can wrap the ACK in their own message format
+    /// \param [in] id The ID of the message being acknowledged
+    /// \param [in] dest The source of the message being acknowledged
+    virtual void acknowledgeE2E(uint8_t id, uint8_t dest);
+
+    /// Tests whether a message requesting end-to-end acknowledgement has been seen recently,
+    /// and remembers it if not
+    /// \param [in] source The source of the message
+    /// \param [in] id The ID of the message
+    /// \return true if the message is a duplicate
+    bool seenE2E(uint8_t source, uint8_t id);
+
+    /// Removes the oldest message from the queue of messages received by sendtoWaitE2E(),
+    /// unless it is still waiting. Always false if RH_ROUTER_E2E_QUEUE_SIZE is 0.
+    /// Parameters are as for recvfromAck()
+    /// \return true if a queued message was copied to buf
+    bool popE2EQueue(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t* dest, uint8_t* id, uint8_t* flags);
+
+    /// Adds a pending delivery receipt
+    /// \param [in] dest The destination of the message
+    /// \param [in] id The ID of the message
+    /// \return pointer to the new DeliveryReceipt
+    DeliveryReceipt* addReceipt(uint8_t dest, uint8_t id);
+
+    /// Finds a delivery receipt
+    /// \param [in] dest The destination of the message
+    /// \param [in] id The ID of the message
+    /// \param [in] state The receipt state to look for
+    /// \return pointer to the DeliveryReceipt or NULL if there is none
+    DeliveryReceipt* getReceipt(uint8_t dest, uint8_t id, uint8_t state);
+
+    /// Deletes a specific delivery receipt
+    /// \param [in] index The 0 based index of the receipt to delete
+    void deleteReceipt(uint8_t index);
+
     /// The last end-to-end sequence number to be used
     /// Defaults to 0
     uint8_t _lastE2ESequenceNumber;
@@ -323,6 +504,16 @@ protected:
     /// Flag to set if packets are forwarded or not
     bool _isa_router;
 
+    /// Time to wait for an end-to-end acknowledgement in milliseconds
+    uint16_t _e2eTimeout;
+
+    /// Number of end-to-end retries
+    uint8_t _e2eRetries;
+
+    /// True while the queue of received messages must not be returned by recvfromAck(),
+    /// because sendtoWaitE2E() is filling it or a subclass is receiving its own messages
+    bool _e2eQueueHeld;
+
 private:
 
     /// Temporary mesage buffer
@@ -330,6 +521,23 @@ private:
 
     /// Local routing table
     RoutingTableEntry    _routes[RH_ROUTING_TABLE_SIZE];
+
+    /// Delivery receipts for messages waiting for end-to-end acknowledgement
+    DeliveryReceipt      _receipts[RH_ROUTER_E2E_RECEIPTS_SIZE];
+
+    /// Source (high octet) and ID (low octet) of recent messages we acknowledged end-to-end
+    uint16_t             _seenE2E[RH_ROUTER_E2E_SEEN_SIZE];
+
+    /// Index of the next slot to use in _seenE2E
+    uint8_t              _seenE2EIndex;
+
+#if RH_ROUTER_E2E_QUEUE_SIZE > 0
+    /// Messages for this node received while waiting in sendtoWaitE2E(), oldest first
+    QueuedMessage        _e2eQueue[RH_ROUTER_E2E_QUEUE_SIZE];
+
+    /// Number of messages in _e2eQueue
+    uint8_t              _e2eQueueLen;
+#endif
 };
 
 /// @example rf22_router_client.pde
@@ -12,6 +12,18 @@
 #define RH_TCP_MESSAGE_TYPE_NOP               0
 #define RH_TCP_MESSAGE_TYPE_THISADDRESS       1
 #define RH_TCP_MESSAGE_TYPE_PACKET            2
+#define RH_TCP_MESSAGE_TYPE_VERSION           3
+#define RH_TCP_MESSAGE_TYPE_PACKET_EXT        4
+
+// The protocol versions.
+// Version 1 has only RH_TCP_MESSAGE_TYPE_THISADDRESS and RH_TCP_MESSAGE_TYPE_PACKET.
+// Version 2 adds RH_TCP_MESSAGE_TYPE_VERSION and RH_TCP_MESSAGE_TYPE_PACKET_EXT.
+// A version 2 client sends RHTcpVersion when it connects. A version 2 server replies with its own
+// RHTcpVersion, and from then on both sides use RHTcpPacketExt. Version 1 servers ignore
+// RHTcpVersion and never reply, so the client continues with version 1 messages.
+#define RH_TCP_PROTOCOL_VERSION_1             1
+#define RH_TCP_PROTOCOL_VERSION_2             2
+#define RH_TCP_PROTOCOL_VERSION               RH_TCP_PROTOCOL_VERSION_2
 
 // Maximum message length (including the headers) we are willing to support
 #define RH_TCP_MAX_PAYLOAD_LEN 255
@@ -61,6 +73,37 @@ typedef struct
     uint8_t         payload[RH_TCP_MAX_MESSAGE_LEN]; ///< 0 or more, length deduced from length above
 }   RHTcpPacket;
 
+/// \brief RH_TCP message to negotiate the protocol version
+typedef struct
+{
+    uint32_t        length; ///< Number of octets following, in network byte order
+    uint8_t         type;   ///< == RH_TCP_MESSAGE_TYPE_VERSION
+    uint8_t         version; ///< Highest RH_TCP_PROTOCOL_VERSION_* supported by the sender
+}   RHTcpVersion;
+
+/// \brief RH_TCP radio message passed to or from the simulator, with the simulated radio parameters.
+/// Used instead of RHTcpPacket after both sides have agreed on RH_TCP_PROTOCOL_VERSION_2.
+/// All multi-octet fields are in network byte order.
+typedef struct
+{
+    uint32_t        length; ///< Number of octets following
+    uint8_t         type;   ///< == RH_TCP_MESSAGE_TYPE_PACKET_EXT
+    int16_t         rssi;   ///< Received signal strength in dBm. Set by the server for each delivery, 0 when sent
+    int8_t          snr;    ///< Signal to noise ratio in dB. Set by the server for each delivery, 0 when sent
+    uint32_t        frequency; ///< Transmitter frequency in kHz. Only received by nodes on the same frequency
+    uint8_t         spreadingFactor; ///< Transmitter spreading factor or other modem configuration tag. Only received by nodes with the same
+    uint32_t        txTimeSec;  ///< Time of transmission by the sender, seconds since the epoch
+    uint32_t        txTimeUsec; ///< Microseconds part of the time of transmission
+    uint8_t         to;     ///< Node address of the recipient
+    uint8_t         from;   ///< Node address of the sender
+    uint8_t         id;     ///< Message sequence number
+    uint8_t         flags;  ///< Message flags
+    uint8_t         payload[RH_TCP_MAX_MESSAGE_LEN]; ///< 0 or more, length deduced from length above
+}   RHTcpPacketExt;
+
+// Octets in RHTcpPacketExt between the type and the headers
+#define RH_TCP_PACKET_EXT_LEN 16
+
 #pragma pack(pop)
 
 #endif
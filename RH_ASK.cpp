@@ -42,6 +42,33 @@ static uint8_t symbols[] =
     0x23, 0x25, 0x26, 0x29, 0x2a, 0x2c, 0x32, 0x34
 };
 
+#ifndef RH_ASK_SYMBOL_SEARCH
+// 6 bit symbol to 4 bit nybble converter table, the inverse of symbols[]
+// Replaces a linear search of symbols[] for each nybble in the interrupt handler
+// Stored in flash (program) memory on AVR to save SRAM
+ #if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  #define RH_ASK_TABLE_ATTR PROGMEM
+  #define RH_ASK_READ_SYMBOL(s) pgm_read_byte(&symbols_6to4[s])
+ #else
+  #define RH_ASK_TABLE_ATTR
+  #define RH_ASK_READ_SYMBOL(s) (symbols_6to4[s])
+ #endif
+#define X RH_ASK_INVALID_SYMBOL
+static const uint8_t symbols_6to4[64] RH_ASK_TABLE_ATTR =
+{
+     X,  X,  X,  X,  X,  X,  X,  X,
+     X,  X,  X,  X,  X, 0x0, 0x1,  X,
+     X,  X,  X, 0x2,  X, 0x3, 0x4,  X,
+     X, 0x5, 0x6,  X, 0x7,  X,  X,  X,
+     X,  X,  X, 0x8,  X, 0x9, 0xa,  X,
+     X, 0xb, 0xc,  X, 0xd,  X,  X,  X,
+     X,  X, 0xe,  X, 0xf,  X,  X,  X,
+     X,  X,  X,  X,  X,  X,  X,  X
+};
+#undef X
+#endif
+
 // This is the value of the start symbol after 6-bit conversion and nybble swapping
 #define RH_ASK_START_SYMBOL 0xb38
 
@@ -59,6 +86,18 @@ RH_ASK::RH_ASK(uint16_t speed, uint8_t rxPin, uint8_t txPin, uint8_t pttPin, boo
     // 6-bit conversion to RH_ASK_START_SYMBOL
     uint8_t preamble[RH_ASK_PREAMBLE_LEN] = {0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x38, 0x2c};
     memcpy(_txBuf, preamble, sizeof(preamble));
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    _sampleSource = NULL;
+    _sampleRate = (uint32_t)_speed * RH_ASK_RX_SAMPLES_PER_BIT;
+    _sampleThreshold = 0x80;
+    _rxSamplePhase = 0;
+    _txSamplePhase = 0;
+    _rxSampleCount = 0;
+    _rxSampleHigh = 0;
+    _txLevel = false;
+    _sampleBufLen = 0;
+    _sampleBufIndex = 0;
+#endif
 }
 
 bool RH_ASK::init()
@@ -76,6 +115,8 @@ bool RH_ASK::init()
     RH_ASK_TX_DDR   |=  (1<<RH_ASK_TX_PIN);
     RH_ASK_RX_DDR   &= ~(1<<RH_ASK_RX_PIN);
  #endif
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    // No pins in the simulator, only sample streams
 #else
     // Set up digital IO pins for arduino
     pinMode(_txPin, OUTPUT);
@@ -449,8 +490,8 @@ void RH_INTERRUPT_ATTR RH_ASK::setModeIdle()
     if (_mode != RHModeIdle)
     {
 	// Disable the transmitter hardware
-	writePtt(LOW);
-	writeTx(LOW);
+	writePtt(false);
+	writeTx(false);
 	_mode = RHModeIdle;
     }
 }
@@ -460,8 +501,8 @@ void RH_INTERRUPT_ATTR RH_ASK::setModeRx()
     if (_mode != RHModeRx)
     {
 	// Disable the transmitter hardware
-	writePtt(LOW);
-	writeTx(LOW);
+	writePtt(false);
+	writeTx(false);
 	_mode = RHModeRx;
     }
 }
@@ -474,9 +515,13 @@ void RH_ASK::setModeTx()
 	_txIndex = 0;
 	_txBit = 0;
 	_txSample = 0;
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+	// Start the first bit on the first sample
+	_txSamplePhase = _sampleRate;
+#endif
 
 	// Enable the transmitter hardware
-	writePtt(HIGH);
+	writePtt(true);
 
 	_mode = RHModeTx;
     }
@@ -488,6 +533,11 @@ bool RH_ASK::available()
     if (_mode == RHModeTx)
 	return false;
     setModeRx();
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    // Dont overwrite a message that has not been collected yet
+    if (!_rxBufValid)
+	pollSampleSource();
+#endif
     if (_rxBufFull)
     {
 	validateRxBuf();
@@ -533,22 +583,22 @@ bool RH_ASK::send(const uint8_t* data, uint8_t len)
     if (!waitCAD()) 
 	return false;  // Check channel activity
 
+    // The CRC covers the byte count, headers and user data
+    uint8_t header[RH_ASK_HEADER_LEN + 1] = { count, _txHeaderTo, _txHeaderFrom, _txHeaderId, _txHeaderFlags };
+    crc = RHcrc_ccitt_buf(crc, header, sizeof(header));
+    crc = RHcrc_ccitt_buf(crc, data, len);
+
     // Encode the message length
-    crc = RHcrc_ccitt_update(crc, count);
     p[index++] = symbols[count >> 4];
     p[index++] = symbols[count & 0xf];
 
     // Encode the headers
-    crc = RHcrc_ccitt_update(crc, _txHeaderTo);
     p[index++] = symbols[_txHeaderTo >> 4];
     p[index++] = symbols[_txHeaderTo & 0xf];
-    crc = RHcrc_ccitt_update(crc, _txHeaderFrom);
     p[index++] = symbols[_txHeaderFrom >> 4];
     p[index++] = symbols[_txHeaderFrom & 0xf];
-    crc = RHcrc_ccitt_update(crc, _txHeaderId);
     p[index++] = symbols[_txHeaderId >> 4];
     p[index++] = symbols[_txHeaderId & 0xf];
-    crc = RHcrc_ccitt_update(crc, _txHeaderFlags);
     p[index++] = symbols[_txHeaderFlags >> 4];
     p[index++] = symbols[_txHeaderFlags & 0xf];
 
@@ -556,7 +606,6 @@ bool RH_ASK::send(const uint8_t* data, uint8_t len)
     // 2 6-bit symbols, high nybble first, low nybble second
     for (i = 0; i < len; i++)
     {
-	crc = RHcrc_ccitt_update(crc, data[i]);
 	p[index++] = symbols[data[i] >> 4];
 	p[index++] = symbols[data[i] & 0xf];
     }
@@ -585,6 +634,8 @@ bool RH_INTERRUPT_ATTR RH_ASK::readRx()
     bool value;
 #if (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8)
     value = ((RH_ASK_RX_PORT & (1<<RH_ASK_RX_PIN)) ? 1 : 0);
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    value = 0; // No pins in the simulator
 #else
     value = digitalRead(_rxPin);
 #endif
@@ -594,10 +645,15 @@ bool RH_INTERRUPT_ATTR RH_ASK::readRx()
 // Write the TX output pin, taking into account platform type.
 void RH_INTERRUPT_ATTR RH_ASK::writeTx(bool value)
 {
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    _txLevel = value;
+#endif
 #if (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8)
     ((value) ? (RH_ASK_TX_PORT |= (1<<RH_ASK_TX_PIN)) : (RH_ASK_TX_PORT &= ~(1<<RH_ASK_TX_PIN)));
 #elif (RH_PLATFORM == RH_PLATFORM_ATTINY_MEGA)
     digitalWrite(_txPin, (PinStatus)value);
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    // No pins in the simulator
 #else
     digitalWrite(_txPin, value);
 #endif
@@ -614,6 +670,8 @@ void RH_INTERRUPT_ATTR RH_ASK::writePtt(bool value)
  #endif
 #elif (RH_PLATFORM == RH_PLATFORM_ATTINY_MEGA)
     digitalWrite(_txPin, (PinStatus)(value ^ _pttInverted));
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    (void)value; // No pins in the simulator
 #else
     digitalWrite(_pttPin, value ^ _pttInverted);
 #endif
@@ -740,12 +798,15 @@ ISR(TCB1_INT_vect)
 #endif
 
 // Convert a 6 bit encoded symbol into its 4 bit decoded equivalent
-uint8_t RH_INTERRUPT_ATTR RH_ASK::symbol_6to4(uint8_t symbol)
+// Returns RH_ASK_INVALID_SYMBOL if it is not a valid symbol
+// Shared by RH_ASK and RH_ASKMultiReceiver
+static uint8_t RH_INTERRUPT_ATTR decode_symbol(uint8_t symbol)
 {
+#ifdef RH_ASK_SYMBOL_SEARCH
     uint8_t i;
     uint8_t count;
     
-    // Linear search :-( Could have a 64 byte reverse lookup table?
+    // Linear search
     // There is a little speedup here courtesy Ralph Doncaster:
     // The shortcut works because bit 5 of the symbol is 1 for the last 8
     // symbols, and it is 0 for the first 8.
@@ -753,7 +814,32 @@ uint8_t RH_INTERRUPT_ATTR RH_ASK::symbol_6to4(uint8_t symbol)
     for (i = (symbol>>2) & 8, count=8; count-- ; i++)
 	if (symbol == symbols[i]) return i;
 
-    return 0; // Not found
+    return RH_ASK_INVALID_SYMBOL; // Not found
+#else
+    return RH_ASK_READ_SYMBOL(symbol & 0x3f);
+#endif
+}
+
+// Convert 12 received bits (2 6 bit symbols, the 6 lsbits being the high nybble) into the decoded octet
+// Returns -1 if either symbol is invalid
+static int16_t RH_INTERRUPT_ATTR decode_byte(uint16_t bits)
+{
+    uint8_t hi = decode_symbol(bits & 0x3f);
+    uint8_t lo = decode_symbol((bits >> 6) & 0x3f);
+    if ((hi | lo) > 0x0f) // RH_ASK_INVALID_SYMBOL
+	return -1;
+    return (hi << 4) | lo;
+}
+
+uint8_t RH_INTERRUPT_ATTR RH_ASK::symbol_6to4(uint8_t symbol)
+{
+    uint8_t nybble = decode_symbol(symbol);
+    return nybble == RH_ASK_INVALID_SYMBOL ? 0 : nybble;
+}
+
+int16_t RH_INTERRUPT_ATTR RH_ASK::symbol_12to8(uint16_t bits)
+{
+    return decode_byte(bits);
 }
 
 // Check whether the latest received message is complete and uncorrupted
@@ -763,8 +849,7 @@ void RH_ASK::validateRxBuf()
 {
     uint16_t crc = 0xffff;
     // The CRC covers the byte count, headers and user data
-    for (uint8_t i = 0; i < _rxBufLen; i++)
-	crc = RHcrc_ccitt_update(crc, _rxBuf[i]);
+    crc = RHcrc_ccitt_buf(crc, _rxBuf, _rxBufLen);
     if (crc != 0xf0b8) // CRC when buffer and expected CRC are CRC'd
     {
 	// Reject and drop the message
@@ -789,8 +874,11 @@ void RH_ASK::validateRxBuf()
 
 void RH_INTERRUPT_ATTR RH_ASK::receiveTimer()
 {
-    bool rxSample = readRx();
+    receiveSample(readRx());
+}
 
+void RH_INTERRUPT_ATTR RH_ASK::receiveSample(bool rxSample)
+{
     // Integrate each sample
     if (rxSample)
 	_rxIntegrator++;
@@ -832,9 +920,15 @@ void RH_INTERRUPT_ATTR RH_ASK::receiveTimer()
 		// Have 12 bits of encoded message == 1 byte encoded
 		// Decode as 2 lots of 6 bits into 2 lots of 4 bits
 		// The 6 lsbits are the high nybble
-		uint8_t this_byte = 
-		    (symbol_6to4(_rxBits & 0x3f)) << 4 
-		    | symbol_6to4(_rxBits >> 6);
+		int16_t decoded = decode_byte(_rxBits);
+		if (decoded < 0)
+		{
+		    // Not a valid symbol, so the message is corrupt. Drop it now
+		    _rxActive = false;
+		    _rxBad++;
+		    return;
+		}
+		uint8_t this_byte = decoded;
 
 		// The first decoded byte is the byte count of the following message
 		// the count includes the byte count and the 2 trailing FCS bytes
@@ -912,4 +1006,307 @@ void RH_INTERRUPT_ATTR RH_ASK::handleTimerInterrupt()
         transmitTimer(); // Transmitting
 }
 
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+void RH_ASK::setSampleSource(RHASKSampleSource* source, uint32_t sampleRate)
+{
+    _sampleSource = source;
+    _sampleRate = sampleRate ? sampleRate : (uint32_t)_speed * RH_ASK_RX_SAMPLES_PER_BIT;
+    _rxSamplePhase = 0;
+    _rxSampleCount = 0;
+    _rxSampleHigh = 0;
+    _sampleBufLen = 0;
+    _sampleBufIndex = 0;
+}
+
+uint32_t RH_ASK::receiveSamples(const uint8_t* samples, uint32_t len)
+{
+    // The timer interrupt would sample RH_ASK_RX_SAMPLES_PER_BIT times per bit
+    uint32_t tickRate = (uint32_t)_speed * RH_ASK_RX_SAMPLES_PER_BIT;
+    uint32_t i;
+
+    for (i = 0; i < len && _mode == RHModeRx; i++)
+    {
+	if (samples[i] >= _sampleThreshold)
+	    _rxSampleHigh++;
+	_rxSampleCount++;
+	_rxSamplePhase += tickRate;
+	if (_rxSamplePhase >= _sampleRate)
+	{
+	    // End of this tick. Its value is the majority of the samples in it
+	    _rxSamplePhase -= _sampleRate;
+	    receiveSample(((_rxSampleHigh * 2) > _rxSampleCount) ^ _rxInverted);
+	    _rxSampleHigh = 0;
+	    _rxSampleCount = 0;
+	}
+    }
+    return i;
+}
+
+uint32_t RH_ASK::transmitSamples(uint8_t* samples, uint32_t len)
+{
+    uint32_t tickRate = (uint32_t)_speed * RH_ASK_RX_SAMPLES_PER_BIT;
+    uint32_t i;
+
+    for (i = 0; i < len && _mode == RHModeTx; i++)
+    {
+	_txSamplePhase += tickRate;
+	if (_txSamplePhase >= _sampleRate)
+	{
+	    _txSamplePhase -= _sampleRate;
+	    transmitTimer(); // May finish the transmission
+	}
+	samples[i] = _txLevel ? 0xff : 0x00;
+    }
+    return i;
+}
+
+void RH_ASK::pollSampleSource()
+{
+    if (!_sampleSource)
+	return;
+    while (_mode == RHModeRx)
+    {
+	if (_sampleBufIndex >= _sampleBufLen)
+	{
+	    // Need some more samples
+	    int32_t result = _sampleSource->read(_sampleBuf, sizeof(_sampleBuf));
+	    if (result <= 0)
+		return; // None available yet, or the end of the stream
+	    _sampleBufLen = result;
+	    _sampleBufIndex = 0;
+	}
+	_sampleBufIndex += receiveSamples(_sampleBuf + _sampleBufIndex, _sampleBufLen - _sampleBufIndex);
+    }
+}
+
+bool RH_ASK::waitPacketSent()
+{
+    // No timer interrupt to send the message, so do it now
+    uint8_t buf[1024];
+    bool ret = true;
+    while (_mode == RHModeTx)
+    {
+	uint32_t len = transmitSamples(buf, sizeof(buf));
+	if (_sampleSource && _sampleSource->write(buf, len) < 0)
+	    ret = false;
+    }
+    return ret;
+}
+#endif
+
+RH_ASKMultiReceiver::RH_ASKMultiReceiver(uint8_t channels)
+    :
+    _channels(channels > RH_ASK_MULTI_MAX_CHANNELS ? RH_ASK_MULTI_MAX_CHANNELS : channels),
+    _thisAddress(RH_BROADCAST_ADDRESS),
+    _promiscuous(false),
+    _rxActive(0),
+    _rxBufFull(0),
+    _rxBufValid(0),
+    _rxHeaderTo(RH_BROADCAST_ADDRESS),
+    _rxHeaderFrom(RH_BROADCAST_ADDRESS),
+    _rxHeaderId(0),
+    _rxHeaderFlags(0)
+{
+    memset(_rxPllRamp, 0, sizeof(_rxPllRamp));
+    memset(_rxIntegrator, 0, sizeof(_rxIntegrator));
+    memset(_rxLastSample, 0, sizeof(_rxLastSample));
+    memset(_rxBits, 0, sizeof(_rxBits));
+    memset(_rxBitCount, 0, sizeof(_rxBitCount));
+    memset(_rxCount, 0, sizeof(_rxCount));
+    memset(_rxBufLen, 0, sizeof(_rxBufLen));
+    memset(_rxGood, 0, sizeof(_rxGood));
+    memset(_rxBad, 0, sizeof(_rxBad));
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    _sampleSource = NULL;
+    _sampleBufLen = 0;
+    _sampleBufIndex = 0;
+#endif
+}
+
+void RH_INTERRUPT_ATTR RH_ASKMultiReceiver::receiveTick(uint8_t samples)
+{
+    uint8_t c;
+
+    // Integrate and advance the PLL of every channel. Same as RH_ASK::receiveSample() 
+    // but for all channels at once, with no branches the compiler cant convert to selects
+    for (c = 0; c < _channels; c++)
+    {
+	uint8_t rxSample = (samples >> c) & 1;
+	_rxIntegrator[c] += rxSample;
+	uint8_t inc = (rxSample != _rxLastSample[c])
+	    ? ((_rxPllRamp[c] < RH_ASK_RAMP_TRANSITION) ? RH_ASK_RAMP_INC_RETARD : RH_ASK_RAMP_INC_ADVANCE)
+	    : RH_ASK_RAMP_INC;
+	_rxLastSample[c] = rxSample;
+	_rxPllRamp[c] += inc;
+    }
+    // Only 1 in 8 samples is the end of a bit
+    for (c = 0; c < _channels; c++)
+	if (_rxPllRamp[c] >= RH_ASK_RX_RAMP_LEN)
+	    decodeBit(c);
+}
+
+void RH_INTERRUPT_ATTR RH_ASKMultiReceiver::decodeBit(uint8_t c)
+{
+    uint8_t mask = 1 << c;
+
+    // Add this to the 12th bit of _rxBits, LSB first
+    _rxBits[c] >>= 1;
+    if (_rxIntegrator[c] >= 5)
+	_rxBits[c] |= 0x800;
+    _rxPllRamp[c] -= RH_ASK_RX_RAMP_LEN;
+    _rxIntegrator[c] = 0;
+
+    if (_rxBufFull & mask || _rxBufValid & mask)
+	return; // Still have a message to be collected, ignore this channel
+
+    if (_rxActive & mask)
+    {
+	if (++_rxBitCount[c] >= 12)
+	{
+	    // Have 12 bits of encoded message == 1 byte encoded
+	    // The 6 lsbits are the high nybble
+	    int16_t decoded = decode_byte(_rxBits[c]);
+	    if (decoded < 0)
+	    {
+		// Not a valid symbol, drop the message
+		_rxActive &= ~mask;
+		_rxBad[c]++;
+		return;
+	    }
+	    uint8_t this_byte = decoded;
+	    if (_rxBufLen[c] == 0)
+	    {
+		// The first byte is the byte count, see RH_ASK::receiveSample()
+		_rxCount[c] = this_byte;
+		if (_rxCount[c] < 7 || _rxCount[c] > RH_ASK_MAX_PAYLOAD_LEN)
+		{
+		    // Stupid message length, drop the whole thing
+		    _rxActive &= ~mask;
+		    _rxBad[c]++;
+		    return;
+		}
+	    }
+	    _rxBuf[c][_rxBufLen[c]++] = this_byte;
+	    if (_rxBufLen[c] >= _rxCount[c])
+	    {
+		// Got all the bytes now
+		_rxActive &= ~mask;
+		_rxBufFull |= mask;
+	    }
+	    _rxBitCount[c] = 0;
+	}
+    }
+    else if (_rxBits[c] == RH_ASK_START_SYMBOL)
+    {
+	// Have start symbol, start collecting message
+	_rxActive |= mask;
+	_rxBitCount[c] = 0;
+	_rxBufLen[c] = 0;
+    }
+}
+
+uint32_t RH_ASKMultiReceiver::receiveSamples(const uint8_t* samples, uint32_t len)
+{
+    uint32_t i;
+    uint8_t full = _rxBufFull;
+
+    for (i = 0; i < len; i++)
+    {
+	receiveTick(samples[i]);
+	if (_rxBufFull != full)
+	    return i + 1; // A new message
+    }
+    return i;
+}
+
+void RH_ASKMultiReceiver::validateRxBuf(uint8_t c)
+{
+    uint16_t crc = 0xffff;
+    crc = RHcrc_ccitt_buf(crc, _rxBuf[c], _rxBufLen[c]);
+    if (crc != 0xf0b8) // CRC when buffer and expected CRC are CRC'd
+    {
+	_rxBad[c]++;
+	return;
+    }
+    if (_promiscuous ||
+	_rxBuf[c][1] == _thisAddress ||
+	_rxBuf[c][1] == RH_BROADCAST_ADDRESS)
+    {
+	_rxGood[c]++;
+	ATOMIC_BLOCK_START;
+	_rxBufValid |= (1 << c);
+	ATOMIC_BLOCK_END;
+    }
+}
+
+uint8_t RH_ASKMultiReceiver::available()
+{
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    // Demodulate samples until there is a new message
+    while (_sampleSource && !_rxBufFull)
+    {
+	if (_sampleBufIndex >= _sampleBufLen)
+	{
+	    int32_t result = _sampleSource->read(_sampleBuf, sizeof(_sampleBuf));
+	    if (result <= 0)
+		break; // None available yet, or the end of the stream
+	    _sampleBufLen = result;
+	    _sampleBufIndex = 0;
+	}
+	_sampleBufIndex += receiveSamples(_sampleBuf + _sampleBufIndex, _sampleBufLen - _sampleBufIndex);
+    }
+#endif
+    return validateRxBufs();
+}
+
+uint8_t RH_ASKMultiReceiver::validateRxBufs()
+{
+    uint8_t c;
+    for (c = 0; c < _channels; c++)
+    {
+	if (_rxBufFull & (1 << c))
+	{
+	    validateRxBuf(c);
+	    ATOMIC_BLOCK_START;
+	    _rxBufFull &= ~(1 << c);
+	    ATOMIC_BLOCK_END;
+	}
+    }
+    return _rxBufValid;
+}
+
+bool RH_ASKMultiReceiver::recv(uint8_t channel, uint8_t* buf, uint8_t* len)
+{
+    // Dont demodulate any more samples here, so the messages reported by available() 
+    // can be collected from each channel in turn
+    if (channel >= _channels || !(validateRxBufs() & (1 << channel)))
+	return false;
+
+    _rxHeaderTo    = _rxBuf[channel][1];
+    _rxHeaderFrom  = _rxBuf[channel][2];
+    _rxHeaderId    = _rxBuf[channel][3];
+    _rxHeaderFlags = _rxBuf[channel][4];
+    if (buf && len)
+    {
+	// Skip the length and 4 headers and drop the trailing 2 bytes of FCS
+	uint8_t message_len = _rxBufLen[channel] - RH_ASK_HEADER_LEN - 3;
+	if (*len > message_len)
+	    *len = message_len;
+	memcpy(buf, _rxBuf[channel] + RH_ASK_HEADER_LEN + 1, *len);
+    }
+    ATOMIC_BLOCK_START;
+    _rxBufValid &= ~(1 << channel);
+    ATOMIC_BLOCK_END;
+    return true;
+}
+
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+void RH_ASKMultiReceiver::setSampleSource(RHASKSampleSource* source)
+{
+    _sampleSource = source;
+    _sampleBufLen = 0;
+    _sampleBufIndex = 0;
+}
+#endif
+
 #endif //_SAMD51__
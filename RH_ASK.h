@@ -8,6 +8,12 @@
 
 #include <RHGenericDriver.h>
 
+#if (RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI)
+// On Linux there is no timer interrupt, but RH_ASK can run from a stream of samples instead
+ #define RH_ASK_HAVE_SAMPLE_STREAM
+ #include <RHASKSampleStream.h>
+#endif
+
 // Maximum message length (including the headers, byte count and FCS) we are willing to support
 // This is pretty arbitrary
 #define RH_ASK_MAX_PAYLOAD_LEN 67
@@ -57,6 +63,24 @@
 /// This is the number of 6 bit nibbles in the preamble
 #define RH_ASK_PREAMBLE_LEN 8
 
+// Received 6 bit symbols are decoded to nybbles with a 64 entry lookup table (in flash on AVR).
+// Define this to use the older linear search of the 16 symbols instead, which saves 64 octets of flash
+// but is much slower
+//#define RH_ASK_SYMBOL_SEARCH
+
+// Value of symbol_6to4 lookups for invalid symbols
+#define RH_ASK_INVALID_SYMBOL 0xff
+
+// Maximum number of channels RH_ASKMultiReceiver can demodulate. Each sample has 1 bit per channel
+#ifndef RH_ASK_MULTI_MAX_CHANNELS
+ #define RH_ASK_MULTI_MAX_CHANNELS 8
+#endif
+
+// Number of samples read from an RHASKSampleSource at a time
+#ifndef RH_ASK_SAMPLE_BUF_LEN
+ #define RH_ASK_SAMPLE_BUF_LEN 4096
+#endif
+
 /////////////////////////////////////////////////////////////////////
 /// \class RH_ASK RH_ASK.h <RH_ASK.h>
 /// \brief Driver to send and receive unaddressed, unreliable datagrams via inexpensive ASK (Amplitude Shift Keying) or 
@@ -259,6 +283,23 @@
 /// of millis() etc but does permit analog outputs. This will affect the accuracy of millis() and time
 /// measurement.
 ///
+/// \par Linux
+///
+/// On Linux (RaspberryPi and the simulator) there is no timer interrupt. Instead, RH_ASK can demodulate
+/// a stream of samples from an RHASKSampleSource, such as a recorded capture, a pipe, or 
+/// a sound card connected to a cheap OOK receiver, and write its modulated output to it. 
+/// The samples can be at any rate of at least 8 times the bit rate, 
+/// and are demodulated a batch at a time whenever available() is called:
+/// \code
+/// RH_ASK driver(2000);
+/// RHASKFileSampleSource source; // Samples from stdin
+/// ...
+/// driver.init();
+/// driver.setSampleSource(&source, 48000); // 8 bit unsigned samples at 48kHz
+/// \endcode
+/// The message is transmitted by waitPacketSent(), which runs the modulator and writes 
+/// all the samples to the sample source. You can also call receiveSamples() and transmitSamples() directly.
+///
 /// \par  STM32 F4 Discovery with Arduino and Arduino_STM32
 /// You can initialise the driver like this:
 /// \code
@@ -333,6 +374,40 @@ public:
     /// \return The current speed in bits per second
     uint16_t        speed() { return _speed;}
 
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    /// Sets the stream of samples to demodulate, and to write modulated samples to, 
+    /// instead of the pins and timer interrupt.
+    /// \param[in] source The sample source, or NULL for none.
+    /// \param[in] sampleRate The number of samples per second in the stream. 
+    /// Must be at least 8 times the speed. If 0, there are exactly 8 samples per bit.
+    void            setSampleSource(RHASKSampleSource* source, uint32_t sampleRate = 0);
+
+    /// Sets the level at and above which a sample is demodulated as a 1. Default is 0x80.
+    /// \param[in] threshold The threshold level
+    void            setSampleThreshold(uint8_t threshold) { _sampleThreshold = threshold;};
+
+    /// Demodulates a batch of samples at the rate set by setSampleSource(). Each group of samples making up 
+    /// one eighth of a bit is reduced to a single 0 or 1 by majority, and fed to the PLL and 
+    /// integrator, as if sampled by the timer interrupt. Stops early when a message has been received, 
+    /// since the receiver goes idle until available() is called again.
+    /// \param[in] samples The samples
+    /// \param[in] len Number of samples
+    /// \return The number of samples consumed.
+    uint32_t        receiveSamples(const uint8_t* samples, uint32_t len);
+
+    /// Modulates the message being transmitted into a batch of samples at the rate set by setSampleSource().
+    /// Each sample is 0x00 or 0xff.
+    /// \param[out] samples Where to put the samples
+    /// \param[in] len Maximum number of samples
+    /// \return The number of samples generated. Less than len if the transmission finished.
+    uint32_t        transmitSamples(uint8_t* samples, uint32_t len);
+
+    /// Runs the modulator until the message (if any) has been transmitted, 
+    /// writing all the samples to the sample source, if any.
+    /// \return true if the samples were written
+    virtual bool    waitPacketSent();
+#endif
+
 #if (RH_PLATFORM == RH_PLATFORM_ESP8266)
     /// ESP8266 timer0 increment value
     uint32_t _timerIncrement;
@@ -355,11 +430,21 @@ protected:
     void            writePtt(bool value);
 
     /// Translates a 6 bit symbol to its 4 bit plaintext equivalent
+    /// \return The nybble, or 0 if the symbol is invalid
     RH_INTERRUPT_ATTR uint8_t         symbol_6to4(uint8_t symbol);
 
+    /// Translates 12 received bits (2 6 bit symbols, the 6 lsbits being the high nybble) 
+    /// to the plaintext octet. The receiver drops the message if either symbol is invalid.
+    /// \return The octet, or -1 if either symbol is invalid
+    RH_INTERRUPT_ATTR int16_t         symbol_12to8(uint16_t bits);
+
     /// The receiver handler function, called a 8 times the bit rate
     void            receiveTimer();
 
+    /// Feeds one sample to the receiver PLL and integrator, and decodes the message as it arrives
+    /// \param[in] rxSample The sample, already corrected for inversion
+    RH_INTERRUPT_ATTR void receiveSample(bool rxSample);
+
     /// The transmitter handler function, called a 8 times the bit rate 
     void            transmitTimer();
 
@@ -440,6 +525,221 @@ protected:
     /// Number of symbols in _txBuf to be sent;
     uint8_t _txBufLen;
 
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    /// Reads and demodulates samples from the sample source until a message is received, 
+    /// or no more are available
+    void            pollSampleSource();
+
+    /// The sample source, if any
+    RHASKSampleSource* _sampleSource;
+
+    /// Samples per second in the sample stream
+    uint32_t        _sampleRate;
+
+    /// Samples at or above this are a 1
+    uint8_t         _sampleThreshold;
+
+    /// Fraction of a tick of the receiver, in units of 1/_sampleRate ticks
+    uint32_t        _rxSamplePhase;
+
+    /// Fraction of a tick of the transmitter, in units of 1/_sampleRate ticks
+    uint32_t        _txSamplePhase;
+
+    /// Number of samples in this receiver tick so far
+    uint16_t        _rxSampleCount;
+
+    /// Number of those that were a 1
+    uint16_t        _rxSampleHigh;
+
+    /// The last level written by writeTx()
+    bool            _txLevel;
+
+    /// Samples read from the sample source but not yet demodulated
+    uint8_t         _sampleBuf[RH_ASK_SAMPLE_BUF_LEN];
+
+    /// Number of samples in _sampleBuf
+    uint32_t        _sampleBufLen;
+
+    /// Index of the next sample in _sampleBuf to demodulate
+    uint32_t        _sampleBufIndex;
+#endif
+
+};
+
+/////////////////////////////////////////////////////////////////////
+/// \class RH_ASKMultiReceiver RH_ASK.h <RH_ASK.h>
+/// \brief Receives messages from up to 8 ASK/OOK receivers at once, with one demodulator.
+///
+/// Each RH_ASK instance demodulates a single receiver pin from its own timer interrupt. This class
+/// demodulates up to RH_ASK_MULTI_MAX_CHANNELS (8) receivers together, such as receivers on 
+/// different frequencies, in the same way and with the same message format as RH_ASK.
+/// Each sample is a bit mask with one bit per channel (bit 0 for channel 0, etc), as you get by
+/// reading a whole port of pins at once, and there must be 8 samples per bit, as for RH_ASK.
+/// The state of the PLL and integrator for all the channels is kept in arrays, so each sample updates 
+/// all the channels in a tight loop, and only the channels at the end of a bit do any more work.
+///
+/// On microcontrollers, call receiveTick() from your own timer interrupt, 8 times per bit.
+/// On Linux, give it a batch of samples at a time with receiveSamples(), or set an RHASKSampleSource 
+/// where each octet is one sample of all the channels, and it will be read by available().
+///
+/// This class only receives. Messages are accepted if they are addressed to this address or broadcast,
+/// as with the drivers.
+class RH_ASKMultiReceiver
+{
+public:
+    /// Constructor.
+    /// \param[in] channels The number of channels to demodulate, from 1 to RH_ASK_MULTI_MAX_CHANNELS
+    RH_ASKMultiReceiver(uint8_t channels = RH_ASK_MULTI_MAX_CHANNELS);
+
+    /// Returns the number of channels being demodulated
+    /// \return The number of channels
+    uint8_t         channels() { return _channels;}
+
+    /// Demodulates one sample of all the channels. Call this 8 times per bit.
+    /// \param[in] samples Bit mask of the samples, one bit per channel
+    RH_INTERRUPT_ATTR void receiveTick(uint8_t samples);
+
+    /// Demodulates a batch of samples, 8 per bit. Stops early when a message has been received on a channel
+    /// that has no uncollected message.
+    /// \param[in] samples The samples, each a bit mask with one bit per channel
+    /// \param[in] len Number of samples
+    /// \return The number of samples consumed
+    uint32_t        receiveSamples(const uint8_t* samples, uint32_t len);
+
+    /// Tests whether new messages are available on any channels, checking any newly received messages.
+    /// \return A bit mask of the channels that have a new, complete, error-free message for recv()
+    uint8_t         available();
+
+    /// If there is a valid message available on the channel, copy it to buf and return true,
+    /// and the headers of the message are available from headerTo() etc.
+    /// Unlike available(), does not demodulate any samples from the sample source.
+    /// \param[in] channel The channel number
+    /// \param[in] buf Location to copy the received message
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \return true if a valid message was copied to buf
+    bool            recv(uint8_t channel, uint8_t* buf, uint8_t* len);
+
+    /// Sets the address of this node. Messages to other addresses are ignored unless promiscuous.
+    /// \param[in] thisAddress The address of this node
+    void            setThisAddress(uint8_t thisAddress) { _thisAddress = thisAddress;};
+
+    /// Tells the receiver to accept messages with any TO address
+    /// \param[in] promiscuous true to accept all messages
+    void            setPromiscuous(bool promiscuous) { _promiscuous = promiscuous;};
+
+    /// Returns the TO header of the last message received by recv()
+    uint8_t         headerTo() { return _rxHeaderTo;};
+
+    /// Returns the FROM header of the last message received by recv()
+    uint8_t         headerFrom() { return _rxHeaderFrom;};
+
+    /// Returns the ID header of the last message received by recv()
+    uint8_t         headerId() { return _rxHeaderId;};
+
+    /// Returns the FLAGS header of the last message received by recv()
+    uint8_t         headerFlags() { return _rxHeaderFlags;};
+
+    /// Returns the count of good messages received on the channel
+    /// \param[in] channel The channel number
+    uint16_t        rxGood(uint8_t channel) { return _rxGood[channel];};
+
+    /// Returns the count of bad messages (bad length or CRC) received on the channel
+    /// \param[in] channel The channel number
+    uint16_t        rxBad(uint8_t channel) { return _rxBad[channel];};
+
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    /// Sets the stream of samples to demodulate in available(). Each octet is one sample of all the
+    /// channels, 8 per bit.
+    /// \param[in] source The sample source, or NULL for none.
+    void            setSampleSource(RHASKSampleSource* source);
+#endif
+
+protected:
+    /// Handles the end of a bit period on a channel: shifts in the bit and decodes the message
+    /// \param[in] channel The channel number
+    RH_INTERRUPT_ATTR void decodeBit(uint8_t channel);
+
+    /// Checks the CRC and address of the latest message received on a channel
+    /// \param[in] channel The channel number
+    void            validateRxBuf(uint8_t channel);
+
+    /// Checks all the newly received messages
+    /// \return A bit mask of the channels with valid messages
+    uint8_t         validateRxBufs();
+
+    /// Number of channels
+    uint8_t         _channels;
+
+    /// This node address
+    uint8_t         _thisAddress;
+
+    /// Accept messages to any address
+    bool            _promiscuous;
+
+    /// Per channel PLL ramps, as RH_ASK::_rxPllRamp
+    uint8_t         _rxPllRamp[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel integrators, as RH_ASK::_rxIntegrator
+    uint8_t         _rxIntegrator[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel last samples
+    uint8_t         _rxLastSample[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel last 12 bits received
+    uint16_t        _rxBits[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel number of bits of the current symbol pair received
+    uint8_t         _rxBitCount[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel expected message length
+    uint8_t         _rxCount[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel message length received so far
+    uint8_t         _rxBufLen[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel message buffers
+    uint8_t         _rxBuf[RH_ASK_MULTI_MAX_CHANNELS][RH_ASK_MAX_PAYLOAD_LEN];
+
+    /// Per channel counts of good messages
+    uint16_t        _rxGood[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Per channel counts of bad messages
+    uint16_t        _rxBad[RH_ASK_MULTI_MAX_CHANNELS];
+
+    /// Bit mask of channels that have seen the start symbol and are receiving a message
+    volatile uint8_t _rxActive;
+
+    /// Bit mask of channels whose buffer is full but not validated
+    volatile uint8_t _rxBufFull;
+
+    /// Bit mask of channels whose buffer is full and valid
+    volatile uint8_t _rxBufValid;
+
+    /// TO header of the last message received by recv()
+    uint8_t         _rxHeaderTo;
+
+    /// FROM header of the last message received by recv()
+    uint8_t         _rxHeaderFrom;
+
+    /// ID header of the last message received by recv()
+    uint8_t         _rxHeaderId;
+
+    /// FLAGS header of the last message received by recv()
+    uint8_t         _rxHeaderFlags;
+
+#ifdef RH_ASK_HAVE_SAMPLE_STREAM
+    /// The sample source, if any
+    RHASKSampleSource* _sampleSource;
+
+    /// Samples read from the sample source but not yet demodulated
+    uint8_t         _sampleBuf[RH_ASK_SAMPLE_BUF_LEN];
+
+    /// Number of samples in _sampleBuf
+    uint32_t        _sampleBufLen;
+
+    /// Index of the next sample in _sampleBuf to demodulate
+    uint32_t        _sampleBufIndex;
+#endif
 };
 
 /// @example ask_reliable_datagram_client.pde
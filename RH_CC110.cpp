@@ -446,26 +446,13 @@ bool RH_CC110::setFrequency(float centre)
 // Sets registers from a canned modem configuration structure
 void RH_CC110::setModemRegisters(const ModemConfig* config)
 {
-    spiWriteRegister(RH_CC110_REG_0B_FSCTRL1,  config->reg_0b);
-    spiWriteRegister(RH_CC110_REG_0C_FSCTRL0,  config->reg_0c);
-    spiWriteRegister(RH_CC110_REG_10_MDMCFG4,  config->reg_10);
-    spiWriteRegister(RH_CC110_REG_11_MDMCFG3,  config->reg_11);
-    spiWriteRegister(RH_CC110_REG_12_MDMCFG2,  config->reg_12);
-    spiWriteRegister(RH_CC110_REG_15_DEVIATN,  config->reg_15);
-    spiWriteRegister(RH_CC110_REG_19_FOCCFG,   config->reg_19);
-    spiWriteRegister(RH_CC110_REG_1A_BSCFG,    config->reg_1a);
-    spiWriteRegister(RH_CC110_REG_1B_AGCCTRL2, config->reg_1b);
-    spiWriteRegister(RH_CC110_REG_1C_AGCCTRL1, config->reg_1c);
-    spiWriteRegister(RH_CC110_REG_1D_AGCCTRL0, config->reg_1d);
-    spiWriteRegister(RH_CC110_REG_21_FREND1,   config->reg_21);
-    spiWriteRegister(RH_CC110_REG_22_FREND0,   config->reg_22);
-    spiWriteRegister(RH_CC110_REG_23_FSCAL3,   config->reg_23);
-    spiWriteRegister(RH_CC110_REG_24_FSCAL2,   config->reg_24);
-    spiWriteRegister(RH_CC110_REG_25_FSCAL1,   config->reg_25);
-    spiWriteRegister(RH_CC110_REG_26_FSCAL0,   config->reg_26);
-    spiWriteRegister(RH_CC110_REG_2C_TEST2,    config->reg_2c);
-    spiWriteRegister(RH_CC110_REG_2D_TEST1,    config->reg_2d);
-    spiWriteRegister(RH_CC110_REG_2E_TEST0,    config->reg_2e);
+    // Each run of consecutive registers in ModemConfig is written in one burst
+    spiBurstWriteRegister(RH_CC110_REG_0B_FSCTRL1,  &config->reg_0b, 2);
+    spiBurstWriteRegister(RH_CC110_REG_10_MDMCFG4,  &config->reg_10, 3);
+    spiWriteRegister(RH_CC110_REG_15_DEVIATN,        config->reg_15);
+    spiBurstWriteRegister(RH_CC110_REG_19_FOCCFG,   &config->reg_19, 5);
+    spiBurstWriteRegister(RH_CC110_REG_21_FREND1,   &config->reg_21, 6);
+    spiBurstWriteRegister(RH_CC110_REG_2C_TEST2,    &config->reg_2c, 3);
 }
 
 // Set one of the canned Modem configs
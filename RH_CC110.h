@@ -597,6 +597,8 @@ public:
     ///
     /// Defines values for various configuration fields and registers to 
     /// achieve a desired modulation speed and frequency deviation.
+    /// The fields are in register address order, and setModemRegisters() writes each run
+    /// of consecutive registers in a single SPI burst.
     typedef struct
     {
 	uint8_t reg_0b;    ///< RH_CC110_REG_0B_FSCTRL1
@@ -7,14 +7,34 @@
 #ifdef RH_HAVE_SERIAL // No serial
 
 #include <RH_E32.h>
-#include <Stream.h>
-
-RH_E32::RH_E32(Stream *s, uint8_t m0_pin, uint8_t m1_pin, uint8_t aux_pin)
+#if (RH_PLATFORM == RH_PLATFORM_RASPI) || (RH_PLATFORM == RH_PLATFORM_UNIX)
+ #include <RHutil/HardwareSerial.h>
+#else
+ #include <Stream.h>
+#endif
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+ // No pins in the simulator: M0 and M1 are not driven, and AUX always reads high, as if the module is idle
+ #define pinMode(pin, mode)
+ #define digitalWrite(pin, value)
+ #define digitalRead(pin) true
+#endif
+
+// Interrupt vectors for the AUX pins of 3 instances of RH_E32
+RH_E32* RH_E32::_deviceForInterrupt[RH_E32_NUM_INTERRUPTS] = {0, 0, 0};
+uint8_t RH_E32::_interruptCount = 0; // Index into _deviceForInterrupt for next device
+
+RH_E32::RH_E32(RH_E32_SERIAL *s, uint8_t m0_pin, uint8_t m1_pin, uint8_t aux_pin)
   :
   _s(s),
   _m0_pin(m0_pin),
   _m1_pin(m1_pin),
-  _aux_pin(aux_pin)
+  _aux_pin(aux_pin),
+  _bufLen(0),
+  _rxBufValid(false),
+  _lastRxTime(0),
+  _myInterruptIndex(0xff), // Not allocated yet
+  _auxHigh(false)
 {
   // Prevent glitches at startup
   pinMode(_aux_pin, INPUT);
@@ -28,7 +48,11 @@ bool RH_E32::init()
 {
   // When a message is available, Aux will go low 5 msec before the first character is output
   // So if we ever wait more than this period of time after Aux low, can conclude there will be no data
-  _s->setTimeout(10);
+#if (RH_PLATFORM != RH_PLATFORM_RASPI) && (RH_PLATFORM != RH_PLATFORM_UNIX)
+  _s->setTimeout(RH_E32_SERIAL_TIMEOUT);
+#endif
+
+  attachAuxInterrupt();
 
   // Wait until the module is connected
   waitAuxHigh();
@@ -68,7 +92,7 @@ bool RH_E32::readParameters(Parameters& params)
   setOperatingMode(ModeSleep);
   uint8_t readParamsCommand[] = { RH_E32_COMMAND_READ_PARAMS, RH_E32_COMMAND_READ_PARAMS, RH_E32_COMMAND_READ_PARAMS };
   _s->write(readParamsCommand, sizeof(readParamsCommand));
-  size_t result = _s->readBytes((char*)&params, sizeof(params)); // default 1 sec timeout
+  size_t result = readSerial((uint8_t*)&params, sizeof(params));
   setOperatingMode(ModeNormal);
   return (result == sizeof(Parameters));
 }
@@ -83,7 +107,7 @@ bool RH_E32::writeParameters(Parameters& params, bool save)
     return false;
   
   // Now we expect to get the same data back
-  result = _s->readBytes((char*)&params, sizeof(params));
+  result = readSerial((uint8_t*)&params, sizeof(params));
   if (result != sizeof(params))
     return false;
   //    printBuffer("additional read", (uint8_t*)&params, sizeof(params));
@@ -130,7 +154,7 @@ bool RH_E32::getVersion()
   uint8_t readVersionCommand[] = { RH_E32_COMMAND_READ_VERSION, RH_E32_COMMAND_READ_VERSION, RH_E32_COMMAND_READ_VERSION };
   _s->write(readVersionCommand, sizeof(readVersionCommand));
   uint8_t version[4];
-  size_t result = _s->readBytes((char *)version, sizeof(version)); // default 1 sec timeout
+  size_t result = readSerial(version, sizeof(version));
   setOperatingMode(ModeNormal);
   if (result == 4)
     {
@@ -154,17 +178,114 @@ bool RH_E32::getVersion()
   return true;
 }
 
+void RH_E32::attachAuxInterrupt()
+{
+#ifndef RH_E32_AUX_POLL
+  if (_myInterruptIndex != 0xff)
+    return; // Already attached
+  int interruptNumber = digitalPinToInterrupt(_aux_pin);
+  if (interruptNumber == NOT_AN_INTERRUPT)
+    return; // Poll the pin instead
+#ifdef RH_ATTACHINTERRUPT_TAKES_PIN_NUMBER
+  interruptNumber = _aux_pin;
+#endif
+  if (_interruptCount >= RH_E32_NUM_INTERRUPTS)
+    return; // Too many devices, not enough interrupt vectors, poll the pin instead
+  _myInterruptIndex = _interruptCount++;
+  _deviceForInterrupt[_myInterruptIndex] = this;
+  _auxHigh = digitalRead(_aux_pin);
+  if (_myInterruptIndex == 0)
+    attachInterrupt(interruptNumber, isr0, CHANGE);
+  else if (_myInterruptIndex == 1)
+    attachInterrupt(interruptNumber, isr1, CHANGE);
+  else
+    attachInterrupt(interruptNumber, isr2, CHANGE);
+  _auxHigh = digitalRead(_aux_pin); // In case it changed while attaching
+#endif
+}
+
+size_t RH_E32::readSerial(uint8_t* buf, size_t len)
+{
+#if (RH_PLATFORM == RH_PLATFORM_RASPI) || (RH_PLATFORM == RH_PLATFORM_UNIX)
+  // Copy straight out of the HardwareSerial receive buffer, sleeping in poll() while it is empty
+  size_t result = 0;
+  while (result < len)
+    {
+      const uint8_t* data;
+      size_t count = _s->readBuffer(&data);
+      if (!count)
+	{
+	  if (!_s->waitAvailableTimeout(RH_E32_SERIAL_TIMEOUT))
+	    break;
+	  continue;
+	}
+      if (count > len - result)
+	count = len - result;
+      memcpy(buf + result, data, count);
+      _s->consume(count);
+      result += count;
+    }
+  return result;
+#else
+  return _s->readBytes((char *)buf, len);
+#endif
+}
+
+void RH_INTERRUPT_ATTR RH_E32::handleAuxInterrupt()
+{
+  _auxHigh = digitalRead(_aux_pin);
+  // AUX goes high when the transmit buffer is empty
+  if (_auxHigh && _mode == RHModeTx)
+    _mode = RHModeRx;
+}
+
+// These are low level functions that call the interrupt handler for the correct
+// instance of RH_E32.
+// 3 interrupts allows us to have 3 different devices
+void RH_INTERRUPT_ATTR RH_E32::isr0()
+{
+  if (_deviceForInterrupt[0])
+    _deviceForInterrupt[0]->handleAuxInterrupt();
+}
+void RH_INTERRUPT_ATTR RH_E32::isr1()
+{
+  if (_deviceForInterrupt[1])
+    _deviceForInterrupt[1]->handleAuxInterrupt();
+}
+void RH_INTERRUPT_ATTR RH_E32::isr2()
+{
+  if (_deviceForInterrupt[2])
+    _deviceForInterrupt[2]->handleAuxInterrupt();
+}
+
 void RH_E32::waitAuxHigh()
 {
   // REVISIT: timeout needed?
-  while (digitalRead(_aux_pin) == false)
-    ;
+  if (auxInterrupt())
+    {
+      // The interrupt handler tells us when it changes
+      while (!_auxHigh)
+	YIELD;
+    }
+  else
+    {
+      while (digitalRead(_aux_pin) == false)
+	YIELD;
+    }
 }
 
 void RH_E32::waitAuxLow()
 {
-  while (digitalRead(_aux_pin) == true)
-    ;
+  if (auxInterrupt())
+    {
+      while (_auxHigh)
+	YIELD;
+    }
+  else
+    {
+      while (digitalRead(_aux_pin) == true)
+	YIELD;
+    }
 }
 
 // Check whether the latest received message is complete and uncorrupted
@@ -203,38 +324,39 @@ bool RH_E32::available()
 	if (_mode == RHModeTx)
 	  return false;
 
-	if (!_s->available())
-	  return false;
-
-	// Suck up all the characters we can
-	uint8_t data;
-	while (_s->readBytes((char *)&data, 1) == 1) // Not read timeout
-	  {
-	    _buf[_bufLen++] = data;
-	  }
-	// Now assess what we have
-	if (_bufLen < RH_E32_HEADER_LEN)
-	  {
-	    //	    Serial.println("Incomplete header");
-	    return false;
-	  }
-	else if (_bufLen < _buf[0])
+	// Discard any partial message if the rest of it has not arrived in time
+	if (_bufLen && (millis() - _lastRxTime) > RH_E32_FRAME_GAP_TIMEOUT)
 	  {
 	    //	    Serial.println("Incomplete message");
-	    return false;
-	  }
-	else if (   _bufLen > _buf[0]
-		 || _bufLen > RH_E32_MAX_PAYLOAD_LEN)
-	  {
-	    //	    Serial.println("Overrun");
 	    clearRxBuf();
 	    _rxBad++;
-	    return false;
 	  }
 
-	// Else it a partial or complete message, test it
-	//	printBuffer("read success", _buf, _bufLen);
-	validateRxBuf(); 
+	// Read all the octets available in as few calls as possible, but not past the end of
+	// the current message, which is given by its first octet
+	int count;
+	while (!_rxBufValid && (count = _s->available()) > 0)
+	  {
+	    int wanted = _bufLen ? _buf[0] - _bufLen : 1;
+	    if (count > wanted)
+	      count = wanted;
+	    _bufLen += readSerial(_buf + _bufLen, count);
+	    _lastRxTime = millis();
+	    if (_bufLen == 1 && (_buf[0] < RH_E32_HEADER_LEN || _buf[0] > RH_E32_MAX_PAYLOAD_LEN))
+	      {
+		//	    Serial.println("Bad length");
+		clearRxBuf();
+		_rxBad++;
+	      }
+	    else if (_bufLen && _bufLen == _buf[0])
+	      {
+		// Complete message, test it
+		//	printBuffer("read success", _buf, _bufLen);
+		validateRxBuf();
+		if (!_rxBufValid)
+		  clearRxBuf(); // Not for us
+	      }
+	  }
     }
     return _rxBufValid;
 }
@@ -271,8 +393,12 @@ bool RH_E32::send(const uint8_t* data, uint8_t len)
   // REVISIT: do we really have to do this? perhaps just write it after writing the header?
   memcpy(_buf+RH_E32_HEADER_LEN, data, len);
   
-  _s->write(_buf, len + RH_E32_HEADER_LEN);
+  // AUX will go low while the message is being sent. Enter TX mode first, so
+  // the interrupt handler cannot miss the end of transmission
+  _auxHigh = false;
   setMode(RHModeTx);
+  _s->write(_buf, len + RH_E32_HEADER_LEN);
+  _bufLen = 0; // The buffer now has no received data
   _txGood++;
   // Aux will return high when the TX buffer is empty
   
@@ -287,7 +413,16 @@ uint8_t RH_E32::maxMessageLength()
 bool RH_E32::waitPacketSent()
 {
   if (_mode == RHModeTx)
-    waitAuxHigh();
+    {
+      if (auxInterrupt())
+	{
+	  // The AUX interrupt handler ends TX mode
+	  while (_mode == RHModeTx)
+	    YIELD;
+	}
+      else
+	waitAuxHigh();
+    }
   setMode(RHModeRx);
   return true;
 }
@@ -32,6 +32,29 @@
 // This is the maximum RadioHead user message length that can be supported by this module. Limited by
 #define RH_E32_MAX_MESSAGE_LEN (RH_E32_MAX_PAYLOAD_LEN-RH_E32_HEADER_LEN)
 
+// The longest gap in milliseconds between received octets of the same message. If the rest of a message
+// has not arrived this long after the last octet, the partial message is discarded
+#ifndef RH_E32_FRAME_GAP_TIMEOUT
+#define RH_E32_FRAME_GAP_TIMEOUT 50
+#endif
+
+// This is the maximum number of RH_E32 instances that can use an interrupt on the AUX pin
+#define RH_E32_NUM_INTERRUPTS 3
+
+// The longest wait in milliseconds for the next octet of a reply from the module
+#define RH_E32_SERIAL_TIMEOUT 10
+
+// On Raspberry Pi and Linux the serial port is an RHutil/HardwareSerial, which is not an Arduino Stream,
+// and there are no pin interrupts, so the AUX pin is always polled
+#if (RH_PLATFORM == RH_PLATFORM_RASPI) || (RH_PLATFORM == RH_PLATFORM_UNIX)
+ #define RH_E32_SERIAL HardwareSerial
+ #ifndef RH_E32_AUX_POLL
+  #define RH_E32_AUX_POLL
+ #endif
+#else
+ #define RH_E32_SERIAL Stream
+#endif
+
 // Commands to alter module behaviour
 #define RH_E32_COMMAND_WRITE_PARAMS_SAVE         0xC0
 #define RH_E32_COMMAND_READ_PARAMS               0xC1
@@ -169,6 +192,35 @@
 /// \endcode
 /// Other connection schems are possible provided the approporiate constructors are used for SoftwareSerial and RH_E32
 ///
+/// \par Raspberry Pi and Linux
+///
+/// On Raspberry Pi and Linux, pass a pointer to an RHutil/HardwareSerial for the UART
+/// (there is no default), and use the GPIO numbers of the pins connected to M0, M1 and AUX:
+/// \code
+/// HardwareSerial uart("/dev/serial0");
+/// RH_E32 driver(&uart, 23, 24, 25);
+/// ...
+/// uart.begin(9600);
+/// driver.init();
+/// \endcode
+/// Received octets are copied straight out of the HardwareSerial receive buffer with readBuffer(), and replies
+/// from the module are waited for with waitAvailableTimeout(), so no CPU is spent spinning on the UART.
+/// There are no pin interrupts, so the AUX pin is polled with digitalRead().
+/// Also compile RHutil/HardwareSerial.cpp into your program.
+///
+/// \par Receiving and the AUX pin
+///
+/// available() reads all the octets waiting in the serial port with as few calls as possible,
+/// up to the end of the current message (the first octet of each message is its length), so
+/// any following message stays in the serial port buffer. If the rest of a message does not arrive within
+/// RH_E32_FRAME_GAP_TIMEOUT milliseconds, the partial message is discarded and counted by rxBad(), so
+/// the receiver recovers from lost octets.
+///
+/// If the AUX pin is interrupt capable (see digitalPinToInterrupt()), RH_E32 attaches an interrupt to it
+/// and treats its edges as events: the rising edge at the end of a transmission returns the driver
+/// to receive mode, so waitPacketSent() does not need to read the pin repeatedly. Otherwise, or if
+/// RH_E32_AUX_POLL is defined, or if more than RH_E32_NUM_INTERRUPTS instances are in use, the AUX pin is polled as before.
+///
 /// \par Memory
 ///
 /// The RH_RF95 driver requires non-trivial amounts of memory. The sample
@@ -219,7 +271,7 @@
 /// permitted power level for unlicensed users in the ISM bands in most countries. Be sure you comply with your local
 /// regulations. Be a good neighbour and use the lowest power and fastest speed that you can.
 ///
-class Stream;
+class RH_E32_SERIAL;
 class RH_E32 : public RHGenericDriver
 {
  public:
@@ -275,11 +327,16 @@ class RH_E32 : public RHGenericDriver
     /// Contructor. You can have multiple instances, but each instance must have its own
     /// serial connection, M0 M1 and AUX connections. Initialises the mode of the referenced pins
     /// Does NOT set the baud rate of the serial connection to the radio.
-    /// \param[in] s Reference to the SoftwareSerial or HardwareSerial port used to connect to the radio
+    /// \param[in] s Reference to the SoftwareSerial or HardwareSerial port used to connect to the radio.
+    /// On Raspberry Pi and Linux, an RHutil/HardwareSerial, which must be given.
     /// \param[in] m0_pin Pin number of the Arduino pin that connects to the radio M0 input
     /// \param[in] m1_pin Pin number of the Arduino pin that connects to the radio M1 input
     /// \param[in] aux_pin Pin number of the Arduino pin that connects to the radio AUX output
-    RH_E32(Stream *s=&Serial, uint8_t m0_pin = 4, uint8_t m1_pin = 5, uint8_t aux_pin = 8);
+#if (RH_PLATFORM == RH_PLATFORM_RASPI) || (RH_PLATFORM == RH_PLATFORM_UNIX)
+    RH_E32(RH_E32_SERIAL *s, uint8_t m0_pin = 4, uint8_t m1_pin = 5, uint8_t aux_pin = 8);
+#else
+    RH_E32(RH_E32_SERIAL *s=&Serial, uint8_t m0_pin = 4, uint8_t m1_pin = 5, uint8_t aux_pin = 8);
+#endif
 
     /// Initialise the Driver transport hardware and software.
     /// Make sure the Driver is properly, including setting the serial port baud rate and parity to that
@@ -330,6 +387,10 @@ class RH_E32 : public RHGenericDriver
     /// Returns true if successful
     bool waitPacketSent();
 
+    /// Tells whether the AUX pin is being monitored by an interrupt, rather than polled.
+    /// \return true if an interrupt was attached to the AUX pin by init()
+    bool auxInterrupt() { return _myInterruptIndex != 0xff; }
+
     /// Sets the on-air data rate to be used by the transmitter and receiver
     /// \param[in] rate A valid data rate from the DataRate enum
     /// \return true if successful
@@ -422,9 +483,40 @@ protected:
     /// For internal use only
     void clearRxBuf();
 
+    /// Attaches an interrupt handler to the AUX pin, if possible.
+    /// For internal use only
+    void attachAuxInterrupt();
+
+    /// Reads octets from the serial port, waiting up to RH_E32_SERIAL_TIMEOUT milliseconds for each one.
+    /// For internal use only
+    /// \param[in] buf Location to copy the octets to
+    /// \param[in] len Number of octets wanted
+    /// \return The number of octets read, less than len on timeout
+    size_t readSerial(uint8_t* buf, size_t len);
+
+    /// Called by the interrupt handler when the AUX pin changes.
+    /// Ends a transmission when AUX goes high.
+    /// For internal use only
+    void handleAuxInterrupt();
+
+    /// Low level interrupt service routine for device connected to interrupt 0
+    static void isr0();
+
+    /// Low level interrupt service routine for device connected to interrupt 1
+    static void isr1();
+
+    /// Low level interrupt service routine for device connected to interrupt 2
+    static void isr2();
+
+    /// Array of instances connected to interrupts 0, 1 and 2
+    static RH_E32*      _deviceForInterrupt[];
+
+    /// Index of next interrupt number to use in _deviceForInterrupt
+    static uint8_t      _interruptCount;
+
 private:
     /// Serial stream (hardware or software serial)
-    Stream*     _s;
+    RH_E32_SERIAL* _s;
 
     /// Pin number connected to M0
     uint8_t     _m0_pin;
@@ -444,6 +536,15 @@ private:
     /// True when there is a valid message in the buffer
     bool                _rxBufValid;
 
+    /// Time in milliseconds the last octet was received
+    unsigned long       _lastRxTime;
+
+    /// The index into _deviceForInterrupt[] for this device, or 0xff if the AUX pin is polled
+    uint8_t             _myInterruptIndex;
+
+    /// The state of the AUX pin, kept up to date by the interrupt handler
+    volatile bool       _auxHigh;
+
 };
 
 /// @example e32_client.pde
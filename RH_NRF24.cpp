@@ -12,6 +12,15 @@ RH_NRF24::RH_NRF24(uint8_t chipEnablePin, uint8_t slaveSelectPin, RHGenericSPI&
 {
     _configuration = RH_NRF24_EN_CRC | RH_NRF24_CRCO; // Default: 2 byte CRC enabled
     _chipEnablePin = chipEnablePin;
+    memset(_networkAddress, 0xe7, sizeof(_networkAddress)); // The chip default
+    _addressLen = sizeof(_networkAddress);
+    _autoAck = false;
+    _rxPipes = RH_NRF24_ERX_P0 | RH_NRF24_ERX_P1;
+    _txAddressValid = false;
+    _lastPipe = 0;
+    _ackPayloadsQueued = 0;
+    _ackBufValid = false;
+    _burstQueued = _burstSent = _burstFailed = 0;
 }
 
 bool RH_NRF24::init()
@@ -45,6 +54,11 @@ bool RH_NRF24::init()
 
     clearRxBuf();
 
+    // No hardware acknowledgement until setAutoAck(), irrespective of what a previous app did
+    _autoAck = false;
+    spiWriteRegister(RH_NRF24_REG_03_SETUP_AW, _addressLen-2);
+    writePipeAddresses();
+
     // Make sure we are powered down
     setModeIdle();
 
@@ -112,13 +126,148 @@ bool RH_NRF24::setNetworkAddress(uint8_t* address, uint8_t len)
     if (len < 3 || len > 5)
 	return false;
 
-    // Set both TX_ADDR and RX_ADDR_P0 for auto-ack with Enhanced shockwave
+    memcpy(_networkAddress, address, len);
+    _addressLen = len;
     spiWriteRegister(RH_NRF24_REG_03_SETUP_AW, len-2);	// Mapping [3..5] = [1..3]
-    spiBurstWriteRegister(RH_NRF24_REG_0A_RX_ADDR_P0, address, len);
-    spiBurstWriteRegister(RH_NRF24_REG_10_TX_ADDR, address, len);
+    writePipeAddresses();
     return true;
 }
 
+void RH_NRF24::writePipeAddresses()
+{
+    if (_autoAck)
+    {
+	// The RadioHead address replaces the least significant octet of the network address.
+	// Pipes 2 to 5 share the other octets with pipe 1
+	uint8_t address[sizeof(_networkAddress)];
+	memcpy(address, _networkAddress, _addressLen);
+	address[0] = _thisAddress;
+	spiBurstWriteRegister(RH_NRF24_REG_0B_RX_ADDR_P1, address, _addressLen);
+	spiWriteRegister(RH_NRF24_REG_0C_RX_ADDR_P2, RH_BROADCAST_ADDRESS);
+	// Pipe 0 is only enabled while transmitting, see setTxAddress()
+	_rxPipes = (_rxPipes & ~RH_NRF24_ERX_P0) | RH_NRF24_ERX_P1 | RH_NRF24_ERX_P2;
+	_txAddressValid = false;
+    }
+    else
+    {
+	// Set both TX_ADDR and RX_ADDR_P0 to the network address
+	spiBurstWriteRegister(RH_NRF24_REG_0A_RX_ADDR_P0, _networkAddress, _addressLen);
+	spiBurstWriteRegister(RH_NRF24_REG_10_TX_ADDR, _networkAddress, _addressLen);
+	_rxPipes = RH_NRF24_ERX_P0 | RH_NRF24_ERX_P1;
+    }
+    spiWriteRegister(RH_NRF24_REG_02_EN_RXADDR, _rxPipes);
+}
+
+void RH_NRF24::setTxAddress(uint8_t to, bool ack)
+{
+    if (!_txAddressValid || to != _txAddressTo)
+    {
+	uint8_t address[sizeof(_networkAddress)];
+	memcpy(address, _networkAddress, _addressLen);
+	address[0] = to;
+	spiBurstWriteRegister(RH_NRF24_REG_10_TX_ADDR, address, _addressLen);
+	// The ACK comes back to the same address on pipe 0
+	spiBurstWriteRegister(RH_NRF24_REG_0A_RX_ADDR_P0, address, _addressLen);
+	_txAddressTo = to;
+	_txAddressValid = true;
+    }
+    spiWriteRegister(RH_NRF24_REG_02_EN_RXADDR, ack ? (_rxPipes | RH_NRF24_ERX_P0) : _rxPipes);
+}
+
+bool RH_NRF24::setAutoAck(bool enable, uint8_t retries, uint16_t retryDelay)
+{
+    if (retries > 15 || retryDelay < 250 || retryDelay > 4000)
+	return false;
+
+    setModeIdle();
+    if (enable)
+    {
+	// Enable dynamic payload length, payload-with-ack and noack (for broadcasts)
+	spiWriteRegister(RH_NRF24_REG_1D_FEATURE, RH_NRF24_EN_DPL | RH_NRF24_EN_ACK_PAY | RH_NRF24_EN_DYN_ACK);
+	spiWriteRegister(RH_NRF24_REG_01_EN_AA, RH_NRF24_ENAA_ALL);
+	spiWriteRegister(RH_NRF24_REG_04_SETUP_RETR, ((((retryDelay / 250) - 1) << 4) & RH_NRF24_ARD) | retries);
+    }
+    else
+    {
+	spiWriteRegister(RH_NRF24_REG_1D_FEATURE, RH_NRF24_EN_DPL | RH_NRF24_EN_DYN_ACK);
+	flushTx(); // Discard any ACK payloads
+	_ackPayloadsQueued = 0;
+    }
+    _autoAck = enable;
+    writePipeAddresses();
+    return true;
+}
+
+bool RH_NRF24::hardwareAcknowledge()
+{
+    return _autoAck;
+}
+
+void RH_NRF24::setThisAddress(uint8_t thisAddress)
+{
+    RHNRFSPIDriver::setThisAddress(thisAddress);
+    if (_autoAck)
+	writePipeAddresses();
+}
+
+bool RH_NRF24::setPipeAddress(uint8_t pipe, uint8_t address)
+{
+    if (!_autoAck || pipe <= RH_NRF24_PIPE_BROADCAST || pipe >= RH_NRF24_NUM_PIPES)
+	return false;
+    setModeIdle();
+    spiWriteRegister(RH_NRF24_REG_0A_RX_ADDR_P0 + pipe, address);
+    _rxPipes |= (1 << pipe);
+    spiWriteRegister(RH_NRF24_REG_02_EN_RXADDR, _rxPipes);
+    return true;
+}
+
+bool RH_NRF24::disablePipe(uint8_t pipe)
+{
+    if (pipe <= RH_NRF24_PIPE_BROADCAST || pipe >= RH_NRF24_NUM_PIPES)
+	return false;
+    setModeIdle();
+    _rxPipes &= ~(1 << pipe);
+    spiWriteRegister(RH_NRF24_REG_02_EN_RXADDR, _rxPipes);
+    return true;
+}
+
+uint8_t RH_NRF24::lastPipe()
+{
+    return _lastPipe;
+}
+
+bool RH_NRF24::setAckPayload(uint8_t pipe, const uint8_t* data, uint8_t len)
+{
+    if (!_autoAck || pipe >= RH_NRF24_NUM_PIPES || len > RH_NRF24_MAX_PAYLOAD_LEN)
+	return false;
+    if (statusRead() & RH_NRF24_STATUS_TX_FULL)
+	return false;
+    spiBurstWrite(RH_NRF24_COMMAND_W_ACK_PAYLOAD(pipe), data, len);
+    _ackPayloadsQueued++;
+    return true;
+}
+
+bool RH_NRF24::recvAckPayload(uint8_t* buf, uint8_t* len)
+{
+    if (!_ackBufValid)
+	return false;
+    if (buf && len)
+    {
+	if (*len > _ackBufLen)
+	    *len = _ackBufLen;
+	memcpy(buf, _ackBuf, *len);
+    }
+    _ackBufValid = false;
+    return true;
+}
+
+void RH_NRF24::readAckPayload(uint8_t len)
+{
+    spiBurstRead(RH_NRF24_COMMAND_R_RX_PAYLOAD, _ackBuf, len);
+    _ackBufLen = len;
+    _ackBufValid = true;
+}
+
 bool RH_NRF24::setRF(DataRate data_rate, TransmitPower power)
 {
     uint8_t value = (power << 1) & RH_NRF24_PWR;
@@ -164,6 +313,8 @@ void RH_NRF24::setModeRx()
 {
     if (_mode != RHModeRx)
     {
+	if (_autoAck)
+	    spiWriteRegister(RH_NRF24_REG_02_EN_RXADDR, _rxPipes); // Not pipe 0, see setTxAddress()
 	spiWriteRegister(RH_NRF24_REG_00_CONFIG, _configuration | RH_NRF24_PWR_UP | RH_NRF24_PRIM_RX);
 	digitalWrite(_chipEnablePin, HIGH);
 	_mode = RHModeRx;
@@ -193,19 +344,169 @@ bool RH_NRF24::send(const uint8_t* data, uint8_t len)
     if (!waitCAD()) 
 	return false;  // Check channel activity
 
+    writeTxPayload(data, len);
+    _burstQueued = _burstSent = _burstFailed = 0; // Not part of a burst
+    setModeTx();
+    // Radio will return to Standby II mode after transmission is complete
+    _txGood++;
+    return true;
+}
+
+void RH_NRF24::writeTxPayload(const uint8_t* data, uint8_t len)
+{
     // Set up the headers
     _buf[0] = _txHeaderTo;
     _buf[1] = _txHeaderFrom;
     _buf[2] = _txHeaderId;
     _buf[3] = _txHeaderFlags;
     memcpy(_buf+RH_NRF24_HEADER_LEN, data, len);
-    spiBurstWrite(RH_NRF24_COMMAND_W_TX_PAYLOAD_NOACK, _buf, len + RH_NRF24_HEADER_LEN);
+    uint8_t command = RH_NRF24_COMMAND_W_TX_PAYLOAD_NOACK;
+    if (_autoAck)
+    {
+	// Queued ACK payloads would be sent as data
+	if (_ackPayloadsQueued)
+	{
+	    flushTx();
+	    _ackPayloadsQueued = 0;
+	}
+	_ackBufValid = false;
+	// Never ACK broadcasts
+	bool ack = _txHeaderTo != RH_BROADCAST_ADDRESS;
+	setTxAddress(_txHeaderTo, ack);
+	if (ack)
+	    command = RH_NRF24_COMMAND_W_TX_PAYLOAD;
+    }
+    spiBurstWrite(command, _buf, len + RH_NRF24_HEADER_LEN);
+}
+
+bool RH_NRF24::sendBurst(const uint8_t* data, uint8_t len)
+{
+    if (len > RH_NRF24_MAX_MESSAGE_LEN)
+	return false;
+
+    if (_mode != RHModeTx)
+    {
+	// Starting a new burst
+	if (!waitCAD()) 
+	    return false;  // Check channel activity
+	_burstQueued = _burstSent = _burstFailed = 0;
+    }
+    else if (_burstQueued == _burstSent && (statusRead() & RH_NRF24_TX_DS))
+    {
+	// The last message was from send(), and is done
+	spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_TX_DS);
+    }
+
+    // In auto-ack mode, the messages in the TX FIFO go to TX_ADDR when they are transmitted,
+    // so a message to a different node has to wait until they have all gone
+    bool newAddress = _autoAck && _txAddressValid && _txHeaderTo != _txAddressTo;
+    uint32_t timeout = burstTimeout();
+    uint32_t start = millis();
+    while ((pollBurst() & RH_NRF24_STATUS_TX_FULL) ||
+	   (newAddress && !(spiReadRegister(RH_NRF24_REG_17_FIFO_STATUS) & RH_NRF24_TX_EMPTY)))
+    {
+	if (((uint32_t)millis() - start) > timeout)
+	{
+	    // Should never happen: the radio stopped transmitting. Why?
+	    abandonBurst();
+	    return false;
+	}
+	YIELD;
+    }
+
+    writeTxPayload(data, len);
+    _burstQueued++;
+    // The first message puts us into TX mode. CE stays high, so the radio keeps sending
+    // as long as there is something in the TX FIFO
     setModeTx();
-    // Radio will return to Standby II mode after transmission is complete
     _txGood++;
     return true;
 }
 
+uint8_t RH_NRF24::pollBurst()
+{
+    uint8_t status = statusRead();
+    if (status & RH_NRF24_TX_DS)
+    {
+	// Another message sent. Caution: if 2 were sent since the last poll, we only see one here.
+	// waitBurstSent() makes the count right again
+	spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_TX_DS);
+	if (_burstSent < _burstQueued)
+	    _burstSent++;
+    }
+    if (status & RH_NRF24_MAX_RT)
+    {
+	// No ACK for the message at the head of the FIFO. There is no way to drop just that one,
+	// so all the unsent messages fail
+	abandonBurst();
+	spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_MAX_RT);
+	status &= ~RH_NRF24_STATUS_TX_FULL;
+    }
+    return status;
+}
+
+void RH_NRF24::abandonBurst()
+{
+    flushTx();
+    _burstFailed += _burstQueued - _burstSent;
+    _burstQueued = _burstSent;
+}
+
+uint32_t RH_NRF24::burstTimeout()
+{
+    // Longest possible message at the current data rate, plus the PLL settling time, in microseconds
+    uint8_t rfSetup = spiReadRegister(RH_NRF24_REG_06_RF_SETUP);
+    uint32_t bitsPerMs = (rfSetup & RH_NRF24_RF_DR_LOW) ? 250 : ((rfSetup & RH_NRF24_RF_DR_HIGH) ? 2000 : 1000);
+    uint32_t txTime = 130 + ((1 + 5 + RH_NRF24_MAX_PAYLOAD_LEN + 2) * 8 + 9) * 1000 / bitsPerMs;
+    if (_autoAck)
+    {
+	// Every retry waits ARD for the ACK
+	uint8_t setupRetr = spiReadRegister(RH_NRF24_REG_04_SETUP_RETR);
+	uint32_t ard = (((setupRetr & RH_NRF24_ARD) >> 4) + 1) * 250;
+	txTime = (txTime + ard) * ((setupRetr & RH_NRF24_ARC) + 1);
+    }
+    // Plus some slack for polling
+    return txTime * RH_NRF24_TX_FIFO_DEPTH / 1000 + 10;
+}
+
+bool RH_NRF24::waitBurstSent()
+{
+    // If we are not currently in transmit mode, there is no burst to wait for
+    if (_mode != RHModeTx)
+	return false;
+
+    uint32_t timeout = burstTimeout();
+    uint32_t start = millis();
+    while (!(spiReadRegister(RH_NRF24_REG_17_FIFO_STATUS) & RH_NRF24_TX_EMPTY))
+    {
+	pollBurst();
+	if (((uint32_t)millis() - start) > timeout)
+	{
+	    // Should never happen: the radio stopped transmitting. Why?
+	    // Whatever is still in the FIFO is not going anywhere
+	    abandonBurst();
+	    break;
+	}
+	YIELD;
+    }
+    pollBurst(); // Catch a MAX_RT for the last message
+    // The FIFO is empty, so everything that did not fail has been sent
+    _burstSent = _burstQueued;
+    setModeIdle();
+    spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_TX_DS | RH_NRF24_MAX_RT);
+    return _burstFailed == 0;
+}
+
+uint16_t RH_NRF24::burstSent()
+{
+    return _burstSent;
+}
+
+uint16_t RH_NRF24::burstFailed()
+{
+    return _burstFailed;
+}
+
 bool RH_NRF24::waitPacketSent()
 {
     // If we are not currently in transmit mode, there is no packet to wait for
@@ -214,7 +515,7 @@ bool RH_NRF24::waitPacketSent()
 
     // Wait for either the Data Sent or Max ReTries flag, signalling the 
     // end of transmission
-    // We dont actually use auto-ack, so prob dont expect to see RH_NRF24_MAX_RT
+    // Unless auto-ack is enabled, dont expect to see RH_NRF24_MAX_RT
     uint8_t status;
     uint32_t start = millis();
     while (!((status = statusRead()) & (RH_NRF24_TX_DS | RH_NRF24_MAX_RT)))
@@ -227,6 +528,18 @@ bool RH_NRF24::waitPacketSent()
     // Must clear RH_NRF24_MAX_RT if it is set, else no further comm
     if (status & RH_NRF24_MAX_RT)
 	flushTx();
+    // The ACK may have carried a payload, which arrives on pipe 0
+    if (   _autoAck
+	&& (status & RH_NRF24_TX_DS)
+	&& (status & RH_NRF24_RX_P_NO) == (RH_NRF24_PIPE_TX << 1))
+    {
+	uint8_t len = spiRead(RH_NRF24_COMMAND_R_RX_PL_WID);
+	if (len > RH_NRF24_MAX_PAYLOAD_LEN)
+	    flushRx();
+	else
+	    readAckPayload(len);
+	spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_RX_DR);
+    }
     setModeIdle();
     spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_TX_DS | RH_NRF24_MAX_RT);
     // Return true if data sent, false if MAX_RT
@@ -284,7 +597,8 @@ void RH_NRF24::validateRxBuf()
     _rxHeaderFlags = _buf[3];
     if (_promiscuous ||
 	_rxHeaderTo == _thisAddress ||
-	_rxHeaderTo == RH_BROADCAST_ADDRESS)
+	_rxHeaderTo == RH_BROADCAST_ADDRESS ||
+	(_autoAck && _lastPipe > RH_NRF24_PIPE_BROADCAST)) // Addresses set with setPipeAddress()
     {
 	_rxGood++;
 	_rxBufValid = true;
@@ -298,24 +612,37 @@ bool RH_NRF24::available()
 	if (_mode == RHModeTx)
 	    return false;
 	setModeRx();
-	if (spiReadRegister(RH_NRF24_REG_17_FIFO_STATUS) & RH_NRF24_RX_EMPTY)
-	    return false;
-	// Manual says that messages > 32 octets should be discarded
-	uint8_t len = spiRead(RH_NRF24_COMMAND_R_RX_PL_WID);
-	if (len > 32)
+	// The RX FIFO holds up to 3 messages. Keep reading until we find one for us or its empty.
+	// The pipe number at the head of the FIFO comes with every STATUS, so no need to read FIFO_STATUS
+	uint8_t status;
+	while (   !_rxBufValid
+	       && ((status = statusRead()) & RH_NRF24_RX_P_NO) != RH_NRF24_RX_P_NO_EMPTY)
 	{
-	    flushRx();
-	    clearRxBuf();
-	    setModeIdle();
-	    return false;
+	    // Clear read interrupt
+	    spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_RX_DR);
+	    // Manual says that messages > 32 octets should be discarded
+	    uint8_t len = spiRead(RH_NRF24_COMMAND_R_RX_PL_WID);
+	    if (len > 32)
+	    {
+		flushRx();
+		clearRxBuf();
+		setModeIdle();
+		return false;
+	    }
+	    uint8_t pipe = (status & RH_NRF24_RX_P_NO) >> 1;
+	    if (_autoAck && pipe == RH_NRF24_PIPE_TX)
+	    {
+		// A late ACK payload
+		readAckPayload(len);
+		continue;
+	    }
+	    // Get the message into the RX buffer, so we can inspect the headers
+	    spiBurstRead(RH_NRF24_COMMAND_R_RX_PAYLOAD, _buf, len);
+	    _bufLen = len;
+	    _lastPipe = pipe;
+	    // 140 microsecs (32 octet payload)
+	    validateRxBuf(); 
 	}
-	// Clear read interrupt
-	spiWriteRegister(RH_NRF24_REG_07_STATUS, RH_NRF24_RX_DR);
-	// Get the message into the RX buffer, so we can inspect the headers
-	spiBurstRead(RH_NRF24_COMMAND_R_RX_PAYLOAD, _buf, len);
-	_bufLen = len;
-	// 140 microsecs (32 octet payload)
-	validateRxBuf(); 
 	if (_rxBufValid)
 	    setModeIdle(); // Got one
     }
@@ -22,6 +22,15 @@
 // the supported message lengths in the nRF24
 #define RH_NRF24_MAX_MESSAGE_LEN (RH_NRF24_MAX_PAYLOAD_LEN-RH_NRF24_HEADER_LEN)
 
+// The number of messages the transmitter FIFO can hold
+#define RH_NRF24_TX_FIFO_DEPTH 3
+
+// The pipes used in auto-ack mode, see RH_NRF24::setAutoAck()
+#define RH_NRF24_PIPE_TX                                   0 // ACKs for messages we send
+#define RH_NRF24_PIPE_THIS                                 1 // Messages to this node
+#define RH_NRF24_PIPE_BROADCAST                            2 // Messages to RH_BROADCAST_ADDRESS
+#define RH_NRF24_NUM_PIPES                                 6
+
 // SPI Command names
 #define RH_NRF24_COMMAND_R_REGISTER                        0x00
 #define RH_NRF24_COMMAND_W_REGISTER                        0x20
@@ -83,6 +92,7 @@
 #define RH_NRF24_ENAA_P2                                   0x04
 #define RH_NRF24_ENAA_P1                                   0x02
 #define RH_NRF24_ENAA_P0                                   0x01
+#define RH_NRF24_ENAA_ALL                                  0x3f
 
 // #define RH_NRF24_REG_02_EN_RXADDR                          0x02
 #define RH_NRF24_ERX_P5                                    0x20
@@ -121,6 +131,7 @@
 #define RH_NRF24_TX_DS                                     0x20
 #define RH_NRF24_MAX_RT                                    0x10
 #define RH_NRF24_RX_P_NO                                   0x0e
+#define RH_NRF24_RX_P_NO_EMPTY                             0x0e
 #define RH_NRF24_STATUS_TX_FULL                            0x01
 
 // #define RH_NRF24_REG_08_OBSERVE_TX                         0x08
@@ -182,10 +193,9 @@
 /// Several nRF24L01 modules can be connected to an Arduino, permitting the construction of translators
 /// and frequency changers, etc.
 ///
-/// The nRF24 transceiver is configured to use Enhanced Shockburst with no acknowledgement and no retransmits.
+/// By default, the nRF24 transceiver is configured to use Enhanced Shockburst with no acknowledgement and no retransmits.
 /// TX_ADDR and RX_ADDR_P0 are set to the network address. If you need the low level auto-acknowledgement
-/// feature supported by this chip, you can use our original NRF24 library 
-/// at http://www.airspayce.com/mikem/arduino/NRF24
+/// feature supported by this chip, see setAutoAck() below.
 ///
 /// Naturally, for any 2 radios to communicate that must be configured to use the same frequency and 
 /// data rate, and with identical network addresses.
@@ -390,6 +400,28 @@
 /// RHReliableDatagram manager(driver, CLIENT_ADDRESS);
 /// \endcode
 ///
+/// \par Hardware acknowledgement
+///
+/// After init(), you can call setAutoAck(true) to have the nRF24 hardware acknowledge and retransmit
+/// messages to a single node (Enhanced ShockBurst auto-acknowledgement). The RadioHead node address then
+/// becomes part of the over-the-air address, so the radio itself filters messages by their TO address:
+/// the least significant byte of the network address is replaced by the RadioHead address.
+/// The pipes are used like this:
+/// - Pipe 0: receives the ACKs (and any ACK payloads) for messages this node sends. 
+/// It is only enabled while transmitting
+/// - Pipe 1: messages to this node (see setThisAddress())
+/// - Pipe 2: messages to RH_BROADCAST_ADDRESS, which are never acknowledged
+/// - Pipes 3 to 5: messages to other addresses you set with setPipeAddress(), 
+/// for example for a gateway that serves several addresses.
+///
+/// In this mode, waitPacketSent() only returns true if the message was acknowledged by the receiving radio,
+/// and RHReliableDatagram (and the managers based on it) use the hardware acknowledgements instead of
+/// sending their own ACK messages, so reliable delivery takes a single packet and ACK in each direction.
+/// All the nodes must use the same mode. Promiscuous mode can only see messages to addresses that have a pipe.
+///
+/// A receiving node can preload data to be returned to the sender in the next ACK on a pipe with setAckPayload(),
+/// and the sender can get it with recvAckPayload() after waitPacketSent().
+///
 /// \par Example programs
 ///
 /// Several example programs are provided.
@@ -530,6 +562,57 @@ public:
     /// \return true on success, false if len is not in the range 3-5 inclusive.
     bool setNetworkAddress(uint8_t* address, uint8_t len);
 
+    /// Enables or disables hardware acknowledgement and retransmission (Enhanced ShockBurst auto-ack)
+    /// of messages to a single node. See "Hardware acknowledgement" above for how the pipes are used.
+    /// Must be called after init(). The default is disabled.
+    /// \param[in] enable true to enable hardware acknowledgement
+    /// \param[in] retries The number of times the radio will retransmit an unacknowledged message, 0 to 15
+    /// \param[in] retryDelay Time to wait for an ACK before retransmitting, in microseconds, 250 to 4000 in steps of 250.
+    /// At 250kbps with ACK payloads longer than 8 octets, this must be 1500 or more.
+    /// \return true on success, false if retries or retryDelay are out of range
+    bool setAutoAck(bool enable, uint8_t retries = 15, uint16_t retryDelay = 1500);
+
+    /// Tells whether the radio hardware is acknowledging messages, see setAutoAck()
+    /// \return true if hardware acknowledgement is enabled
+    virtual bool hardwareAcknowledge();
+
+    /// Sets the address of this node. If hardware acknowledgement is enabled,
+    /// this also sets the pipe 1 receive address
+    /// \param[in] thisAddress The address of this node.
+    virtual void setThisAddress(uint8_t thisAddress);
+
+    /// Receive messages sent to another RadioHead address as well, when hardware acknowledgement 
+    /// is enabled. They are acknowledged in the same way as messages to this node. 
+    /// \param[in] pipe The pipe to use, 3 to 5
+    /// \param[in] address The RadioHead address to receive messages for
+    /// \return true on success, false if hardware acknowledgement is not enabled or pipe is not valid.
+    bool setPipeAddress(uint8_t pipe, uint8_t address);
+
+    /// Stop receiving messages on a pipe previously set up with setPipeAddress()
+    /// \param[in] pipe The pipe to disable, 3 to 5
+    /// \return true on success
+    bool disablePipe(uint8_t pipe);
+
+    /// Returns the pipe the last message returned by available() or recv() was received on.
+    /// \return The pipe number, 0 to 5
+    uint8_t lastPipe();
+
+    /// Queues data to be returned to the next sender on a pipe in its ACK, when hardware acknowledgement
+    /// is enabled. Up to 3 ACK payloads can be queued. Caution: they share the transmitter FIFO, so
+    /// any queued ACK payloads are discarded when this node sends a message.
+    /// \param[in] pipe The pipe the ACK payload is for, usually RH_NRF24_PIPE_THIS
+    /// \param[in] data The data to send
+    /// \param[in] len Number of octets in data, up to RH_NRF24_MAX_PAYLOAD_LEN
+    /// \return true if the payload was queued
+    bool setAckPayload(uint8_t pipe, const uint8_t* data, uint8_t len);
+
+    /// If the ACK to the last message sent by this node carried an ACK payload, copy it to buf.
+    /// Call after waitPacketSent().
+    /// \param[in] buf Location to copy the ACK payload
+    /// \param[in,out] len Pointer to available space in buf. Set to the actual number of octets copied.
+    /// \return true if an ACK payload was copied to buf
+    bool recvAckPayload(uint8_t* buf, uint8_t* len);
+
     /// Sets the data rate and transmitter power to use. Note that the nRF24 and the RFM73 have different
     /// available power levels, and for convenience, 2 different sets of values are available in the 
     /// RH_NRF24::TransmitPower enum. The ones with the RFM73 only have meaning on the RFM73 and compatible
@@ -560,6 +643,37 @@ public:
     /// successfully transmitted).
     bool send(const uint8_t* data, uint8_t len);
 
+    /// Sends a message as part of a burst of messages, keeping the 3 deep TX FIFO topped up
+    /// so the radio can send them back to back without returning to idle in between.
+    /// Blocks only while the TX FIFO is full.
+    /// The first message of a burst starts the transmitter, and it keeps going as long as more messages
+    /// are sent with sendBurst(). Call waitBurstSent() at the end of the burst.
+    /// If auto-ack is enabled (see setAutoAck()), messages to a different node wait until all the messages before them
+    /// have been sent, and if one of them is not acknowledged, the ones still in the TX FIFO are discarded 
+    /// and counted by burstFailed().
+    /// \param [in] data Data bytes to send.
+    /// \param [in] len Number of data bytes to send
+    /// \return true if the message was queued for transmission. false if the message is too long, the channel is busy,
+    /// or the radio stopped transmitting (in which case the messages in the TX FIFO are discarded and counted by burstFailed())
+    bool sendBurst(const uint8_t* data, uint8_t len);
+
+    /// Blocks until all the messages sent with sendBurst() have been transmitted, and returns the radio to idle.
+    /// If the TX FIFO does not empty in the longest time it could take with the current data rate, retry count
+    /// and retry delay, the messages still in it are discarded and counted by burstFailed().
+    /// \return true if all the messages in the burst were sent (and acknowledged, if auto-ack is enabled)
+    bool waitBurstSent();
+
+    /// Returns the number of messages in the current (or last) burst that have been transmitted 
+    /// (and acknowledged, if auto-ack is enabled). Before waitBurstSent() this may be a little behind, 
+    /// since the radio cannot count completions by itself.
+    /// \return the number of messages sent
+    uint16_t burstSent();
+
+    /// Returns the number of messages in the current (or last) burst that were discarded because 
+    /// a message was not acknowledged.
+    /// \return the number of messages that failed
+    uint16_t burstFailed();
+
     /// Blocks until the current message (if any) 
     /// has been transmitted
     /// \return true on success, false if the chip is not in transmit mode or other transmit failure
@@ -619,6 +733,36 @@ protected:
     /// Clear our local receive buffer
     void clearRxBuf();
 
+    /// Sets the pipe 1 and 2 receive addresses (or the network address if hardware acknowledgement
+    /// is not enabled) and enables the receive pipes
+    void writePipeAddresses();
+
+    /// Sets the transmit address for a message to a RadioHead address, when hardware acknowledgement is enabled
+    /// \param[in] to The RadioHead address the message is for
+    /// \param[in] ack true if the message is to be acknowledged
+    void setTxAddress(uint8_t to, bool ack);
+
+    /// Loads a message into the TX FIFO
+    /// \param [in] data Data bytes to send.
+    /// \param [in] len Number of data bytes to send
+    void writeTxPayload(const uint8_t* data, uint8_t len);
+
+    /// Checks the progress of a burst, counting messages sent and failed
+    /// \return the current STATUS
+    uint8_t pollBurst();
+
+    /// Discards the messages in the TX FIFO and counts those not yet sent as failed
+    void abandonBurst();
+
+    /// Calculates the longest time the TX FIFO could take to empty, with the current data rate
+    /// and (if auto-ack is enabled) retry count and delay. All sending has certainly stopped after this
+    /// \return the time in milliseconds
+    uint32_t burstTimeout();
+
+    /// Reads the ACK payload at the head of the RX FIFO into the ACK payload buffer
+    /// \param[in] len The length of the ACK payload
+    void readAckPayload(uint8_t len);
+
 private:
     /// This idle mode chip configuration
     uint8_t             _configuration;
@@ -634,8 +778,52 @@ private:
 
     /// True when there is a valid message in the buffer
     bool                _rxBufValid;
+
+    /// The network address
+    uint8_t             _networkAddress[5];
+
+    /// Number of octets in _networkAddress
+    uint8_t             _addressLen;
+
+    /// True if hardware acknowledgement is enabled
+    bool                _autoAck;
+
+    /// The receive pipes enabled when receiving, RH_NRF24_ERX_P*
+    uint8_t             _rxPipes;
+
+    /// The RadioHead address in TX_ADDR and RX_ADDR_P0
+    uint8_t             _txAddressTo;
+
+    /// True if _txAddressTo is the one in the radio
+    bool                _txAddressValid;
+
+    /// Pipe number of the last received message
+    uint8_t             _lastPipe;
+
+    /// Number of ACK payloads in the TX FIFO
+    uint8_t             _ackPayloadsQueued;
+
+    /// Number of octets in the ACK payload buffer
+    uint8_t             _ackBufLen;
+
+    /// The last received ACK payload
+    uint8_t             _ackBuf[RH_NRF24_MAX_PAYLOAD_LEN];
+
+    /// True when there is a valid ACK payload in _ackBuf
+    bool                _ackBufValid;
+
+    /// Number of messages loaded into the TX FIFO by sendBurst() in this burst
+    uint16_t            _burstQueued;
+
+    /// Number of messages in this burst that have been sent
+    uint16_t            _burstSent;
+
+    /// Number of messages in this burst that were discarded after a MAX_RT
+    uint16_t            _burstFailed;
 };
 
+/// @example nrf24_burst_client.pde
+/// @example nrf24_burst_server.pde
 /// @example nrf24_client.pde
 /// @example nrf24_server.pde
 /// @example nrf24_encrypted_client.pde
@@ -126,12 +126,12 @@ bool RH_RF22::init()
     while (!(spiRead(RH_RF22_REG_04_INTERRUPT_STATUS2) & RH_RF22_ICHIPRDY))
     ;
 
-    // When real IRQ is not used e.g. in Raspberry PI, then we need to enable only the most critical/relevant interrupt flags
-    // Otherwise, when reading one time per pooling loop the REG_03_INTERRUPT_STATUS1 not all relevant flags might be set!
-    // Alternatively (or additionally), the EZMAC register can be read to get some of the same flags
+    // When real IRQ is not used e.g. in Raspberry PI, the interrupt status registers are polled
+    // by handleInterrupt(). The enabled status flags stay set until they are read, so we enable the same
+    // ones as the interrupt driven mode, including the FIFO thresholds for messages larger than the FIFO
 #ifdef RH_RF22_IRQLESS
-    spiWrite(RH_RF22_REG_05_INTERRUPT_ENABLE1, RH_RF22_ENPKSENT | RH_RF22_ENPKVALID ); // | RH_RF22_ENCRCERROR);
-    spiWrite(RH_RF22_REG_06_INTERRUPT_ENABLE2, RH_RF22_ENPREAVAL); // | RH_RF22_ENSWDET);
+    spiWrite(RH_RF22_REG_05_INTERRUPT_ENABLE1, RH_RF22_ENTXFFAEM | RH_RF22_ENRXFFAFULL | RH_RF22_ENPKSENT | RH_RF22_ENPKVALID | RH_RF22_ENCRCERROR | RH_RF22_ENFFERR);
+    spiWrite(RH_RF22_REG_06_INTERRUPT_ENABLE2, RH_RF22_ENPREAVAL);
 #endif
 
 
@@ -217,8 +217,8 @@ bool RH_RF22::init()
     return true;
 }
 
-#ifndef RH_RF22_IRQLESS
 // C++ level interrupt handler for this instance
+// When RH_RF22_IRQLESS is defined, this is called to poll the interrupt status instead
 void RH_RF22::handleInterrupt()
 {
     uint8_t _lastInterruptFlags[2];
@@ -270,6 +270,7 @@ void RH_RF22::handleInterrupt()
         readNextFragment();
 //	Serial.println("IRXFFAFULL");
     }
+#ifndef RH_RF22_IRQLESS
     if (_lastInterruptFlags[0] & RH_RF22_IEXT)
     {
         // This is not enabled by the base code, but users may want to enable it
@@ -282,6 +283,7 @@ void RH_RF22::handleInterrupt()
         handleWakeupTimerInterrupt();
 //	Serial.println("IWUT"); 
     }
+#endif
     if (_lastInterruptFlags[0] & RH_RF22_IPKSENT)
     {
 //	Serial.println("IPKSENT"); 
@@ -293,6 +295,9 @@ void RH_RF22::handleInterrupt()
     }
     if (_lastInterruptFlags[0] & RH_RF22_IPKVALID)
     {
+#ifdef RH_RF22_IRQLESS
+        setModeIdle();
+#endif
         readFifo();
     }
     if (_lastInterruptFlags[0] & RH_RF22_ICRCERROR)
@@ -307,13 +312,23 @@ void RH_RF22::handleInterrupt()
     if (_lastInterruptFlags[1] & RH_RF22_IPREAVAL)
     {
 //	Serial.println("IPREAVAL"); 
+#ifdef RH_RF22_IRQLESS
+        _lastRssi = (int8_t)( -120 + ( (spiRead(RH_RF22_REG_26_RSSI) - 15) * 3/5 ) );
+        _lastPreambleTime = millis();
+        // When polling, the start of the message may already be in the Rx FIFO, so dont reset it
+        if (!(_lastInterruptFlags[0] & (RH_RF22_IRXFFAFULL | RH_RF22_IPKVALID)))
+            clearRxBuf();
+#else
         _lastRssi = (int8_t)(-120 + ((spiRead(RH_RF22_REG_26_RSSI) / 2)));
         _lastPreambleTime = millis();
         resetRxFifo();
         clearRxBuf();
+#endif
     }
 }
 
+#ifndef RH_RF22_IRQLESS
+
 #if RH_PLATFORM == RH_PLATFORM_ESP8266
 void RH_RF22::loopIsr()
 {
@@ -382,7 +397,11 @@ void RH_RF22::readFifo()
     // Get any remaining unread octets, based on the expected length
     // First make sure we dont overflow the buffer in the case of a stupid length
     // or partial bad receives
-    if (len >  RH_RF22_MAX_MESSAGE_LEN ||
+    // (len is a uint8_t, so it can only exceed a user configured smaller maximum)
+    if (
+#if RH_RF22_MAX_MESSAGE_LEN < 255
+        len >  RH_RF22_MAX_MESSAGE_LEN ||
+#endif
         len < _bufLen)
     {
         _rxBad++;
@@ -408,8 +427,12 @@ void RH_RF22::readFifo()
         _rxBufValid = true;
         //printf(" - RXBUF VALID 0x%02X => 0x%02X - ", _rxHeaderFrom, _rxHeaderTo);
     }
-    //else
-    //    printf(" - RXBUF IGNOR 0x%02X => 0x%02X - ", _rxHeaderFrom, _rxHeaderTo);
+    else
+    {
+        // Not for us. Discard any fragments already read
+        //printf(" - RXBUF IGNOR 0x%02X => 0x%02X - ", _rxHeaderFrom, _rxHeaderTo);
+        clearRxBuf();
+    }
 }
 
 
@@ -636,83 +659,11 @@ bool RH_RF22::available()
     if (_mode == RHModeTx)
         return false;
 
+    // As we have not enabled IRQ, we need to check internal IRQ register of device
+    // handleInterrupt() reads each fragment of a large message from the FIFO as it arrives, 
+    // and the rest of it when the whole message has been received
     if (_mode == RHModeRx)
-    {
-        // As we have not enabled IRQ, we need to check internal IRQ register of device
-        // Read the interrupt flags, which then clears the enabled interrupt bits/flags
-        // This code acts partly as an 'interrupt handler'
-        uint8_t _lastInterruptFlags[2];
-        spiBurstRead(RH_RF22_REG_03_INTERRUPT_STATUS1, _lastInterruptFlags, 2);
-
-        // Read RSSI
-        if (_lastInterruptFlags[1] & RH_RF22_IPREAVAL)
-        {
-            _lastRssi = (int8_t)( -120 + ( (spiRead(RH_RF22_REG_26_RSSI) - 15) * 3/5 ) );
-            _lastPreambleTime = millis();
-            //printf(" - RSSI %ddBm - ", _lastRssi);
-        }
-
-        // Save msg in our buffer _buf with length _bufLen
-        if (_lastInterruptFlags[0] & RH_RF22_IPKVALID)
-        {
-            setModeIdle();
-            readFifo();
-        }
-
-#if 0
-        // DEVELOPER TESTING ONLY
-        // The corresponding interrup flags need to be enabled in init()
-
-        // Read EZMAC status
-        uint8_t _ezmacStatus = ezmacStatusRead();
-        printf("EZMAC= %02x\n", _ezmacStatus);
-
-        printf("STATUS1= %02x\nSTATUS2= %02x\n", _lastInterruptFlags[0], _lastInterruptFlags[1]);
-
-        // Read RSSI
-        if (_lastInterruptFlags[1] & RH_RF22_IPREAVAL)
-        {
-            _lastRssi = (int8_t)(-120 + ((spiRead(RH_RF22_REG_26_RSSI) / 2)));
-            _lastPreambleTime = millis();
-            //clearRxBuf();
-            //resetRxFifo();
-            printf(" - PRE VALID %ddBm - ", _lastRssi);
-        }
-
-        // Check SYNC
-        if(!(_lastInterruptFlags[1] & RH_RF22_ISWDET))
-        {
-            _rxBad++;
-            clearRxBuf();
-            resetRxFifo();
-            _mode = RHModeIdle;
-            setModeRx(); // Keep trying
-            printf(" - SYNC ERROR - ");
-        } else
-           printf(" - SYNC OK - ");
-
-        if (_lastInterruptFlags[0] & RH_RF22_IRXFFAFULL)
-        {
-            // Caution, any delay here may cause a FF overflow
-            // Read some data from the Rx FIFO
-            readNextFragment();
-        }
-
-        // Check CRC
-        if (_lastInterruptFlags[0] & RH_RF22_ICRCERROR)
-        {
-            _rxBad++;
-            clearRxBuf();
-            resetRxFifo();
-            _mode = RHModeIdle;
-            setModeRx(); // Keep trying
-            printf(" - CRC ERROR - ");
-        } else
-           printf(" - CRC OK - ");
-#endif
-
-
-    }
+        handleInterrupt();
 #endif
 #if RH_PLATFORM == RH_PLATFORM_ESP8266
 	loopIsr();
@@ -784,7 +735,7 @@ void RH_RF22::clearTxBuf()
 
 void RH_RF22::startTransmit()
 {
-    sendNextFragment(); // Actually the first fragment
+    sendNextFragment(RH_RF22_FIFO_SIZE - 1); // Actually the first fragment, into the empty FIFO
     spiWrite(RH_RF22_REG_3E_PACKET_LENGTH, _bufLen); // Total length that will be sent
     setModeTx(); // Start the transmitter, turns off the receiver
 }
@@ -845,12 +796,18 @@ bool RH_RF22::waitPacketSent()
     if (_mode != RHModeTx)
         return false;
 
-    // Wait until the packet has been transmitted
-    // Read the interrupt flags which clears the interrupt
+    // Wait until the packet has been transmitted, polling the interrupt flags.
+    // handleInterrupt() refills the Tx FIFO when it is almost empty, and sets the mode to idle
+    // when the packet has been sent. The timeout is long enough to send a full FIFO at the slowest
+    // modem configurations, and restarts each time a fragment is loaded
     unsigned long starttime = millis();
-    while (!(spiRead(RH_RF22_REG_03_INTERRUPT_STATUS1) & RH_RF22_IPKSENT))
+    while (_mode == RHModeTx)
     {
-        if ((millis() - starttime) > 100)
+        uint8_t sentIndex = _txBufSentIndex;
+        handleInterrupt();
+        if (_txBufSentIndex != sentIndex)
+            starttime = millis();
+        else if ((millis() - starttime) > 500)
         {
             ret=false;
             break;
@@ -858,10 +815,6 @@ bool RH_RF22::waitPacketSent()
         YIELD;
     }
 
-    // A transmitter message has been fully sent
-    if (ret)
-        _txGood++;
-
     clearTxBuf();
     setModeIdle(); // Does not clear FIFO!
     return ret;
@@ -888,16 +841,17 @@ bool RH_RF22::appendTxBuf(const uint8_t* data, uint8_t len)
     return true;
 }
 
-// Assumption: there is currently <= RH_RF22_TXFFAEM_THRESHOLD bytes in the Tx FIFO
-void RH_RF22::sendNextFragment()
+// Assumption: there is currently room for at least room bytes in the Tx FIFO
+// By default room assumes there are <= RH_RF22_TXFFAEM_THRESHOLD bytes in the Tx FIFO
+void RH_RF22::sendNextFragment(uint8_t room)
 {
     if (_txBufSentIndex < _bufLen)
     {
         // Some left to send?
         uint8_t len = _bufLen - _txBufSentIndex;
         // But dont send too much
-        if (len > (RH_RF22_FIFO_SIZE - RH_RF22_TXFFAEM_THRESHOLD - 1))
-            len = (RH_RF22_FIFO_SIZE - RH_RF22_TXFFAEM_THRESHOLD - 1);
+        if (len > room)
+            len = room;
         spiBurstWrite(RH_RF22_REG_7F_FIFO_ACCESS, _buf + _txBufSentIndex, len);
         //printBuffer("frag:", _buf  + _txBufSentIndex, len);
         _txBufSentIndex += len;
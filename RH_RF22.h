@@ -33,20 +33,26 @@
 // This is the maximum message length that can be supported by this library. Limited by
 // the single message length octet in the header.
 // Yes, 255 is correct even though the FIFO size in the RF22 is only
-// 64 octets. We use interrupts to refill the Tx FIFO during transmission and to empty the
-// Rx FIFO during reception
+// 64 octets. We use interrupts (or polling with RH_RF22_IRQLESS) to refill the Tx FIFO 
+// during transmission and to empty the Rx FIFO during reception
 // Can be pre-defined to a smaller size (to save SRAM) prior to including this header
 #ifndef RH_RF22_MAX_MESSAGE_LEN
-//#define RH_RF22_MAX_MESSAGE_LEN 255
-#define RH_RF22_MAX_MESSAGE_LEN 50
+#define RH_RF22_MAX_MESSAGE_LEN 255
 #endif
 
 // Max number of octets the RF22 Rx and Tx FIFOs can hold
 #define RH_RF22_FIFO_SIZE 64
 
+#ifdef RH_RF22_IRQLESS
+// Without interrupts the FIFOs are only serviced when polled, so put the thresholds in the middle
+// of the FIFO. That allows 32 octet times between polls before the FIFO underflows or overflows
+#define RH_RF22_TXFFAEM_THRESHOLD 32
+#define RH_RF22_RXFFAFULL_THRESHOLD 32
+#else
 // These values we set for FIFO thresholds (4, 55) are actually the same as the POR values
 #define RH_RF22_TXFFAEM_THRESHOLD 4
 #define RH_RF22_RXFFAFULL_THRESHOLD 55
+#endif
 
 // Number of registers to be passed to setModemConfig(). Obsolete.
 #define RH_RF22_NUM_MODEM_CONFIG_REGS 18
@@ -799,7 +805,12 @@
 /// Use cli() to disable interrupts and sei() to reenable them.
 ///
 /// NOTE: Interrupt handling on Raspberry PI is available via the BCM2835 and the RadioHead interrupt handler cannot be used!
-/// The RH_RF22_IRQLESS is used to disable the RadioHead interrupts handling.
+/// The RH_RF22_IRQLESS is used to disable the RadioHead interrupts handling. Instead the interrupt status 
+/// registers are polled by available() and waitPacketSent(), which do all the work of the interrupt handler, 
+/// including streaming messages larger than the 64 octet FIFO. In that case the FIFO thresholds are
+/// moved to the middle of the FIFO, and you must call available() at least once every 32 octet times
+/// (about 27ms at 9.6kbps, 2ms at 125kbps) while a message is being received, else the Rx FIFO will overflow and 
+/// the message will be lost. Short messages (up to 60 octets) are not affected by polling latency.
 ///
 /// \par SPI Interface
 ///
@@ -1227,10 +1238,9 @@ public:
     /// Starts the receiver and checks whether a received message is available.
     /// This can be called multiple times in a timeout loop
     /// When RH_RF22_IRQLESS is defined this needs to be called multiple in polling loop!
-    /// When RH_RF22_IRQLESS is defined, then:
-    /// - read first the RH_RF22_REG_03_INTERRUPT_STATUS1 and check RH_RF22_IPKVALID
-    /// - if RH_RF22_IPKVALID is set then read the FIFO data with readFifo()
-    /// - set the _lastRssi and _lastPreambleTime
+    /// When RH_RF22_IRQLESS is defined, then it polls the interrupt status registers with handleInterrupt(),
+    /// which reads each fragment of the message from the FIFO as it arrives, 
+    /// and sets the _lastRssi and _lastPreambleTime
     /// \return true if a complete, valid message has been received and is able to be retrieved by
     /// recv()
     bool        available();
@@ -1364,11 +1374,10 @@ public:
 
 protected:
     /// This is a low level function to handle the interrupts for one instance of RH_RF22.
-    /// Called automatically by isr*()
+    /// Called automatically by isr*(), or when RH_RF22_IRQLESS is defined, by available() and waitPacketSent()
+    /// to poll the interrupt status.
     /// Should not need to be called.
-#ifndef RH_RF22_IRQLESS
     void           handleInterrupt();
-#endif
 
     /// Low level function to read the FIFO and put the received data into the receive buffer
     /// Should not need to be called by user code.
@@ -1398,7 +1407,9 @@ protected:
     /// Internal function to load the next fragment of
     /// the current message into the transmitter FIFO
     /// Internal use only
-    void           sendNextFragment();
+    /// \param[in] room The number of octets that can be loaded into the Tx FIFO. Defaults to
+    /// the room there is when the FIFO is almost empty
+    void           sendNextFragment(uint8_t room = RH_RF22_FIFO_SIZE - RH_RF22_TXFFAEM_THRESHOLD - 1);
 
     ///  function to copy the next fragment from
     /// the receiver FIF) into the receiver buffer
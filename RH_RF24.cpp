@@ -34,6 +34,7 @@ RH_RF24::RH_RF24(uint8_t slaveSelectPin, uint8_t interruptPin, uint8_t sdnPin, R
     _sdnPin = sdnPin;
     _idleMode = RH_RF24_DEVICE_STATE_READY;
     _myInterruptIndex = 0xff; // Not allocated yet
+    _ctsPending = false;
 }
 
 void RH_RF24::setIdleMode(uint8_t idleMode)
@@ -77,7 +78,8 @@ bool RH_RF24::init()
     // Here we use a configuration generated by the Silicon Labs Wireless Development Suite
     // #included above
     // We override a few things later that we ned to be sure of.
-    configure(RF24_CONFIGURATION_DATA);
+    if (!configure(RF24_CONFIGURATION_DATA))
+	return false;
 
     // Add by Adrien van den Bossche <vandenbo@univ-tlse2.fr> for Teensy
     // ARM M4 requires the below. else pin interrupt doesn't work properly.
@@ -108,13 +110,34 @@ bool RH_RF24::init()
     else
 	return false; // Too many devices, not enough interrupt vectors
 
+    return configureDefaults();
+}
+
+bool RH_RF24::setConfiguration(const uint8_t* config)
+{
+    // The modem must not be transmitting or receiving while it is reconfigured
+    setModeIdle();
+    if (!configure(config, false))
+	return false;
+    // The new configuration may have changed things we depend on
+    return configureDefaults();
+}
+
+bool RH_RF24::configureDefaults()
+{
     // Ensure we get the interrupts we need, irrespective of whats in the radio_config
     uint8_t int_ctl[] = {RH_RF24_MODEM_INT_STATUS_EN | RH_RF24_PH_INT_STATUS_EN, 0xff, 0xff, 0x00 };
     set_properties(RH_RF24_PROPERTY_INT_CTL_ENABLE, int_ctl, sizeof(int_ctl));
 
-    // RSSI Latching should be configured in MODEM_RSSI_CONTROL in radio_config
+    // Set up the Fast Response Registers so the interrupt handler can get everything it needs
+    // in one SPI transaction without waiting for CTS
+    uint8_t frr_ctl[] = { RH_RF24_FRR_MODE_PACKET_HANDLER_INTERRUPT_PENDING,
+			  RH_RF24_FRR_MODE_MODEM_INTERRUPT_PENDING,
+			  RH_RF24_FRR_MODE_LATCHED_RSSI,
+			  RH_RF24_FRR_MODE_CHIP_INTERRUPT_PENDING };
+    set_properties(RH_RF24_PROPERTY_FRR_CTL_A_MODE, frr_ctl, sizeof(frr_ctl));
 
-    // PKT_TX_THRESHOLD and PKT_RX_THRESHOLD should be set to about 0x30 in radio_config
+    // RSSI Latching should be configured in MODEM_RSSI_CONTROL in radio_config
 
     // Configure important RH_RF24 registers
     // Here we set up the standard packet format for use by the RH_RF24 library:
@@ -128,19 +151,20 @@ bool RH_RF24::init()
     uint8_t pkt_config1[] = { 0x00 };
     set_properties(RH_RF24_PROPERTY_PKT_CONFIG1, pkt_config1, sizeof(pkt_config1));
 
-    uint8_t pkt_len[] = { 0x02, 0x01, 0x00 };
+    // Consecutive properties are batched, up to 12 per command:
+    // PKT_LEN, PKT_LEN_FIELD_SOURCE, PKT_LEN_ADJUST, PKT_TX_THRESHOLD, PKT_RX_THRESHOLD, then field 1
+    uint8_t pkt_len[] = { 0x02, 0x01, 0x00, RH_RF24_TX_FIFO_THRESHOLD, RH_RF24_RX_FIFO_THRESHOLD,
+			  0x00, 0x01, 0x00, RH_RF24_FIELD_CONFIG_CRC_START | RH_RF24_FIELD_CONFIG_SEND_CRC | RH_RF24_FIELD_CONFIG_CHECK_CRC | RH_RF24_FIELD_CONFIG_CRC_ENABLE };
     set_properties(RH_RF24_PROPERTY_PKT_LEN, pkt_len, sizeof(pkt_len));
 
-    uint8_t pkt_field1[] = { 0x00, 0x01, 0x00, RH_RF24_FIELD_CONFIG_CRC_START | RH_RF24_FIELD_CONFIG_SEND_CRC | RH_RF24_FIELD_CONFIG_CHECK_CRC | RH_RF24_FIELD_CONFIG_CRC_ENABLE };
-    set_properties(RH_RF24_PROPERTY_PKT_FIELD_1_LENGTH_12_8, pkt_field1, sizeof(pkt_field1));
-
-    uint8_t pkt_field2[] = { 0x00, sizeof(_buf), 0x00, RH_RF24_FIELD_CONFIG_CRC_START | RH_RF24_FIELD_CONFIG_SEND_CRC | RH_RF24_FIELD_CONFIG_CHECK_CRC | RH_RF24_FIELD_CONFIG_CRC_ENABLE };
+    // Field 2, and clear fields 3 and 4 so they are never used, irrespective of the radio_config
+    uint8_t pkt_field2[] = { 0x00, sizeof(_buf), 0x00, RH_RF24_FIELD_CONFIG_CRC_START | RH_RF24_FIELD_CONFIG_SEND_CRC | RH_RF24_FIELD_CONFIG_CHECK_CRC | RH_RF24_FIELD_CONFIG_CRC_ENABLE,
+			     0x00, 0x00, 0x00, 0x00,
+			     0x00, 0x00, 0x00, 0x00 };
     set_properties(RH_RF24_PROPERTY_PKT_FIELD_2_LENGTH_12_8, pkt_field2, sizeof(pkt_field2));
 
-    // Clear all other fields so they are never used, irrespective of the radio_config
+    // And field 5
     uint8_t pkt_fieldn[] = { 0x00, 0x00, 0x00, 0x00 };
-    set_properties(RH_RF24_PROPERTY_PKT_FIELD_3_LENGTH_12_8, pkt_fieldn, sizeof(pkt_fieldn));
-    set_properties(RH_RF24_PROPERTY_PKT_FIELD_4_LENGTH_12_8, pkt_fieldn, sizeof(pkt_fieldn));
     set_properties(RH_RF24_PROPERTY_PKT_FIELD_5_LENGTH_12_8, pkt_fieldn, sizeof(pkt_fieldn));
 
     // The following can be changed later by the user if necessary.
@@ -161,15 +185,23 @@ bool RH_RF24::init()
 // C++ level interrupt handler for this instance
 void RH_RF24::handleInterrupt()
 {
-    uint8_t status[8];
-    command(RH_RF24_CMD_GET_INT_STATUS, NULL, 0, status, sizeof(status));
+    // Get the pending interrupts (and the latched RSSI) from the Fast Response Registers
+    // without waiting for CTS
+    uint8_t frr[4];
+    frr_read_all(frr);
+    uint8_t ph_pend = frr[RH_RF24_FRR_PH_PEND];
+    uint8_t modem_pend = frr[RH_RF24_FRR_MODEM_PEND];
+
+    // Clear only the interrupts we are about to handle, so any that arrive meanwhile stay pending.
+    // There is no reply we need, so dont wait for CTS: FIFO access below does not need it
+    uint8_t clear[] = { (uint8_t)~ph_pend, (uint8_t)~modem_pend, (uint8_t)~frr[RH_RF24_FRR_CHIP_PEND] };
+    command_nowait(RH_RF24_CMD_GET_INT_STATUS, clear, sizeof(clear));
 
     // Decode and handle the interrupt bits we are interested in
-//    if (status[0] & RH_RF24_INT_STATUS_CHIP_INT_STATUS)
-    if (status[0] & RH_RF24_INT_STATUS_MODEM_INT_STATUS)
+    if (modem_pend)
     {
-//	if (status[4] & RH_RF24_INT_STATUS_INVALID_PREAMBLE)
-	if (status[4] & RH_RF24_INT_STATUS_INVALID_SYNC)
+//	if (modem_pend & RH_RF24_INT_STATUS_INVALID_PREAMBLE)
+	if (modem_pend & RH_RF24_INT_STATUS_INVALID_SYNC)
 	{
 	    // After INVALID_SYNC, sometimes the radio gets into a silly state and subsequently reports it for every packet
 	    // Need to reset the radio and clear the RX FIFO, cause sometimes theres junk there too
@@ -178,9 +210,9 @@ void RH_RF24::handleInterrupt()
 	    clearBuffer();
 	}
     }
-    if (status[0] & RH_RF24_INT_STATUS_PH_INT_STATUS)
+    if (ph_pend)
     {
-	if (status[2] & RH_RF24_INT_STATUS_CRC_ERROR)
+	if (ph_pend & RH_RF24_INT_STATUS_CRC_ERROR)
 	{
 	    // CRC Error
 	    // Radio automatically went to _idleMode
@@ -190,7 +222,7 @@ void RH_RF24::handleInterrupt()
 	    clearRxFifo();
 	    clearBuffer();
 	}
-	if (status[2] & RH_RF24_INT_STATUS_PACKET_SENT)
+	if (ph_pend & RH_RF24_INT_STATUS_PACKET_SENT)
 	{
 	    _txGood++; 
 	    // Transmission does not automatically clear the tx buffer.
@@ -199,31 +231,29 @@ void RH_RF24::handleInterrupt()
 	    _mode = RHModeIdle;
 	    clearBuffer();
 	}
-	if (status[2] & RH_RF24_INT_STATUS_PACKET_RX)
+	if (ph_pend & RH_RF24_INT_STATUS_PACKET_RX)
 	{
 	    // A complete message has been received with good CRC
 	    // Get the RSSI, configured to latch at sync detect in radio_config
-	    uint8_t modem_status[6];
-	    command(RH_RF24_CMD_GET_MODEM_STATUS, NULL, 0, modem_status, sizeof(modem_status));
-	    _lastRssi = modem_status[3];
+	    _lastRssi = frr[RH_RF24_FRR_LATCHED_RSSI];
 	    _lastPreambleTime = millis();
 	    
-	    // Save it in our buffer
+	    // Save the rest of it in our buffer. Only now do we need to ask how much there is
 	    readNextFragment();
 	    // And see if we have a valid message
 	    validateRxBuf();
 	    // Radio will have transitioned automatically to the _idleMode
 	    _mode = RHModeIdle;
 	}
-	if (status[2] & RH_RF24_INT_STATUS_TX_FIFO_ALMOST_EMPTY)
+	if (ph_pend & RH_RF24_INT_STATUS_TX_FIFO_ALMOST_EMPTY)
 	{
 	    // TX FIFO almost empty, maybe send another chunk, if there is one
-	    sendNextFragment();
+	    sendNextFragment(RH_RF24_FIFO_SIZE - RH_RF24_TX_FIFO_THRESHOLD);
 	}
-	if (status[2] & RH_RF24_INT_STATUS_RX_FIFO_ALMOST_FULL)
+	if ((ph_pend & RH_RF24_INT_STATUS_RX_FIFO_ALMOST_FULL) && !(ph_pend & RH_RF24_INT_STATUS_PACKET_RX))
 	{
-	    // Some more data to read, get it
-	    readNextFragment();
+	    // Some more data to read, get it. If the packet is complete, it was all read above
+	    readNextFragment(RH_RF24_RX_FIFO_THRESHOLD);
 	}
     }
 }
@@ -359,30 +389,38 @@ bool RH_RF24::writeTxFifo(uint8_t *data, uint8_t len)
     return true;
 }
 
-void RH_RF24::sendNextFragment()
+void RH_RF24::sendNextFragment(uint8_t room)
 {
     if (_txBufSentIndex < _bufLen)
     {
 	// Some left to send?
 	uint8_t len = _bufLen - _txBufSentIndex;
 	// But dont send too much, see how much room is left
-	uint8_t fifo_info[2];
-	command(RH_RF24_CMD_FIFO_INFO, NULL, 0, fifo_info, sizeof(fifo_info));
-	// fifo_info[1] is space left in TX FIFO
-	if (len > fifo_info[1])
-	    len = fifo_info[1];
+	if (!room)
+	{
+	    uint8_t fifo_info[2];
+	    command(RH_RF24_CMD_FIFO_INFO, NULL, 0, fifo_info, sizeof(fifo_info));
+	    // fifo_info[1] is space left in TX FIFO
+	    room = fifo_info[1];
+	}
+	if (len > room)
+	    len = room;
 
 	writeTxFifo(_buf + _txBufSentIndex, len);
 	_txBufSentIndex += len;
     }
 }
 
-void RH_RF24::readNextFragment()
+void RH_RF24::readNextFragment(uint8_t count)
 {
-    // Get the packet length from the RX FIFO length
-    uint8_t fifo_info[1];
-    command(RH_RF24_CMD_FIFO_INFO, NULL, 0, fifo_info, sizeof(fifo_info));
-    uint8_t fifo_len = fifo_info[0]; 
+    uint8_t fifo_len = count;
+    if (!fifo_len)
+    {
+	// Get the packet length from the RX FIFO length
+	uint8_t fifo_info[1];
+	command(RH_RF24_CMD_FIFO_INFO, NULL, 0, fifo_info, sizeof(fifo_info));
+	fifo_len = fifo_info[0]; 
+    }
 
     // Check for overflow
     if ((_bufLen + fifo_len) > sizeof(_buf))
@@ -627,9 +665,13 @@ void RH_RF24::setTxPower(uint8_t power)
 // Caution: There was a bug in A1 hardware that will not handle 1 byte commands. 
 bool RH_RF24::command(uint8_t cmd, const uint8_t* write_buf, uint8_t write_len, uint8_t* read_buf, uint8_t read_len)
 {
-    bool   done = false;
+    bool   done;
 
     ATOMIC_BLOCK_START;
+    // The chip may still be busy with a command sent by command_nowait()
+    if (_ctsPending)
+	wait_cts();
+
     // First send the command
     digitalWrite(_slaveSelectPin, LOW);
     _spi.transfer(cmd);
@@ -646,6 +688,33 @@ bool RH_RF24::command(uint8_t cmd, const uint8_t* write_buf, uint8_t write_len,
     // And finalise the command
     digitalWrite(_slaveSelectPin, HIGH);
 
+    done = wait_cts(read_buf, read_len);
+    ATOMIC_BLOCK_END;
+    return done; // False if too many attempts at CTS
+}
+
+void RH_RF24::command_nowait(uint8_t cmd, const uint8_t* write_buf, uint8_t write_len)
+{
+    ATOMIC_BLOCK_START;
+    if (_ctsPending)
+	wait_cts();
+
+    digitalWrite(_slaveSelectPin, LOW);
+    _spi.transfer(cmd);
+    while (write_len--)
+	_spi.transfer(*write_buf++);
+    // Sigh, the RFM26 at least has problems if we deselect too quickly :-(
+    // Innocuous timewaster:
+    digitalWrite(_slaveSelectPin, LOW);
+    digitalWrite(_slaveSelectPin, HIGH);
+    _ctsPending = true;
+    ATOMIC_BLOCK_END;
+}
+
+bool RH_RF24::wait_cts(uint8_t* read_buf, uint8_t read_len)
+{
+    bool   done = false;
+
     uint16_t count; // Number of times we have tried to get CTS
     for (count = 0; !done && count < RH_RF24_CTS_RETRIES; count++)
     {
@@ -669,13 +738,14 @@ bool RH_RF24::command(uint8_t cmd, const uint8_t* write_buf, uint8_t write_len,
 	// Finalise the read
 	digitalWrite(_slaveSelectPin, HIGH);
     }
-    ATOMIC_BLOCK_END;
+    _ctsPending = false;
     return done; // False if too many attempts at CTS
 }
 
-bool RH_RF24::configure(const uint8_t* commands)
+bool RH_RF24::configure(const uint8_t* commands, bool powerUp)
 {
     // Command strings are constructed in radio_config_Si4460.h 
+    // or by tools/rf24ConfigCompiler.pl
     // Each command starts with a count of the bytes in that command:
     // <bytecount> <command> <bytecount-2 bytes of args/data>
     uint8_t next_cmd_len;
@@ -683,11 +753,18 @@ bool RH_RF24::configure(const uint8_t* commands)
     while (memcpy_P(&next_cmd_len, commands, 1), next_cmd_len > 0)
     {
 	uint8_t buf[20]; // As least big as the biggest permitted command/property list of 15
+	if (next_cmd_len > sizeof(buf))
+	    return false; // Corrupt configuration
 	memcpy_P(buf, commands+1, next_cmd_len);
-	command(buf[0], buf+1, next_cmd_len - 1);
 	commands += (next_cmd_len + 1);
+	if (buf[0] == RH_RF24_CMD_POWER_UP && !powerUp)
+	    continue;
+	// Dont wait for CTS after each command: the next one is fetched while the radio is busy
+	if (_ctsPending && !wait_cts())
+	    return false;
+	command_nowait(buf[0], buf+1, next_cmd_len - 1);
     }
-    return true;
+    return !_ctsPending || wait_cts();
 }
 
 void RH_RF24::power_on_reset()
@@ -767,11 +844,14 @@ uint8_t RH_RF24::frr_read(uint8_t reg)
 {
     uint8_t ret;
 
+    // The FRRs are read with different commands, not consecutive ones
+    static const uint8_t frr_cmd[] = { RH_RF24_CMD_FAST_RESPONSE_A, RH_RF24_CMD_FAST_RESPONSE_B,
+				       RH_RF24_CMD_FAST_RESPONSE_C, RH_RF24_CMD_FAST_RESPONSE_D };
     // Do not wait for CTS
     ATOMIC_BLOCK_START;
     // First send the command
     digitalWrite(_slaveSelectPin, LOW);
-    _spi.transfer(RH_RF24_PROPERTY_FRR_CTL_A_MODE + reg);
+    _spi.transfer(frr_cmd[reg & 0x3]);
     // Get the fast response
     ret = _spi.transfer(0);
     digitalWrite(_slaveSelectPin, HIGH);
@@ -779,6 +859,19 @@ uint8_t RH_RF24::frr_read(uint8_t reg)
     return ret;
 }
 
+void RH_RF24::frr_read_all(uint8_t* values)
+{
+    // Do not wait for CTS
+    ATOMIC_BLOCK_START;
+    // Reading on from FRR A gets B, C and D too
+    digitalWrite(_slaveSelectPin, LOW);
+    _spi.transfer(RH_RF24_CMD_FAST_RESPONSE_A);
+    for (uint8_t i = 0; i < 4; i++)
+	values[i] = _spi.transfer(0);
+    digitalWrite(_slaveSelectPin, HIGH);
+    ATOMIC_BLOCK_END;
+}
+
 // List of command replies to be printed by prinRegisters()
 PROGMEM static const RH_RF24::CommandInfo commands[] =
 {
@@ -45,6 +45,22 @@
 // Max number of times we will try to read CTS from the radio
 #define RH_RF24_CTS_RETRIES 2500
 
+// Size of each of the TX and RX FIFOs
+#define RH_RF24_FIFO_SIZE 64
+
+// PKT_TX_THRESHOLD and PKT_RX_THRESHOLD. The TX FIFO almost empty interrupt means at most
+// RH_RF24_TX_FIFO_THRESHOLD octets are still in the TX FIFO, and RX FIFO almost full means at least
+// RH_RF24_RX_FIFO_THRESHOLD octets are waiting, so the interrupt handler can move that many
+// without asking the radio with RH_RF24_CMD_FIFO_INFO
+#define RH_RF24_TX_FIFO_THRESHOLD 0x30
+#define RH_RF24_RX_FIFO_THRESHOLD 0x30
+
+// What we configure each Fast Response Register to hold
+#define RH_RF24_FRR_PH_PEND      0 // FRR A: packet handler interrupts pending
+#define RH_RF24_FRR_MODEM_PEND   1 // FRR B: modem interrupts pending
+#define RH_RF24_FRR_LATCHED_RSSI 2 // FRR C: RSSI latched at sync detect
+#define RH_RF24_FRR_CHIP_PEND    3 // FRR D: chip interrupts pending
+
 // RF24/RF26 API commands from table 10
 // also Si446X API DESCRIPTIONS table 1
 #define RH_RF24_CMD_NOP                        0x00
@@ -631,6 +647,22 @@
 /// - Edit RH_RF24.cpp to use this new header file
 /// - Recompile RH_RF24
 /// 
+/// If you need to switch between several radio configurations at run time (for example between data rates
+/// on a gateway), compile each WDS radio configuration header file with tools/rf24ConfigCompiler.pl 
+/// and \#include the generated headers in your sketch. Then call setConfiguration() with the
+/// one you want:
+/// \code
+/// tools/rf24ConfigCompiler.pl RF24configs/radio_config_Si4464_30_434_2GFSK_10_20.h > rf24_fast.h
+/// \endcode
+/// \code
+/// #include "rf24_fast.h"
+/// ...
+/// rf24.setConfiguration(rf24_config_Si4464_30_434_2GFSK_10_20);
+/// \endcode
+/// The tool merges the property settings into as few commands as possible, and leaves out the properties 
+/// RH_RF24 sets itself. With -d base_config.h it only includes the settings that differ from the base configuration,
+/// which is usually much smaller and faster to load, but can only be loaded over the base configuration.
+///
 /// \par RSSI
 ///
 /// The RSSI (Received Signal Strength Indicator) is measured and latched after the message sync bytes are received.
@@ -891,6 +923,20 @@ public:
     ///         setting the new frequency succeeded.
     bool        setFrequency(float centre, float afcPullInRange = 0.05);
 
+    /// Switches the radio to a different configuration at run time, without recompiling.
+    /// The configuration is a list of commands in the format produced by tools/rf24ConfigCompiler.pl
+    /// from a WDS radio configuration header file. Any POWER_UP command in it is skipped.
+    /// Afterwards the packet format, sync words, preamble length, CRC polynomial and transmitter power
+    /// are set to the same defaults as init(), so if you changed any of those, set them again.
+    /// The radio is left idle.
+    /// If the configuration was compiled with -d, it only contains the differences from a base configuration,
+    /// and the radio must already be using that base configuration.
+    /// Caution: the crystal frequency used by setFrequency() is still the one from the radio configuration
+    /// header file \#included by RH_RF24.cpp.
+    /// \param[in] config The configuration commands. On AVR this must be in PROGMEM.
+    /// \return true if the configuration was loaded successfully
+    bool        setConfiguration(const uint8_t* config);
+
     /// OBSOLETE, do not use.
     /// To get different modulation schemes, you must generate a new radio config file
     /// as described in this documentation.
@@ -1044,6 +1090,11 @@ public:
     /// \return the value read from the specified Fast Read Response register.
     uint8_t        frr_read(uint8_t reg);
 
+    /// Reads all 4 Fast Read Response registers in one SPI transaction, without waiting for CTS.
+    /// RH_RF24 configures them as described by RH_RF24_FRR_*
+    /// \param[out] values Location to store the 4 values, FRR A first
+    void           frr_read_all(uint8_t* values);
+
     /// Sets the radio into low-power sleep mode.
     /// If successful, the transport will stay in sleep mode until woken by 
     /// changing mode it idle, transmit or receive (eg by calling send(), recv(), available() etc)
@@ -1073,11 +1124,27 @@ protected:
 
     /// Loads the next part of the currently transmitting message 
     /// into the chips TX buffer
-    void           sendNextFragment();
+    /// \param[in] room Number of octets known to be free in the TX FIFO, or 0 to ask the radio
+    void           sendNextFragment(uint8_t room = 0);
 
     /// Copies the next part of the currenrtly received message from the chips RX FIFO to the 
     /// receive buffer
-    void           readNextFragment();
+    /// \param[in] count Number of octets known to be waiting in the RX FIFO, or 0 to ask the radio
+    void           readNextFragment(uint8_t count = 0);
+
+    /// Sends a command to the chip without waiting for CTS or reading any reply.
+    /// The next command() waits for CTS before it sends its own command. FIFO and FRR access
+    /// does not need CTS, so can be done straight afterwards.
+    /// \param[in] cmd The command number. One of RH_RF24_CMD_*
+    /// \param[in] write_buf Pointer to write_len bytes of command input bytes to send
+    /// \param[in] write_len The number of bytes to send from write_buf
+    void           command_nowait(uint8_t cmd, const uint8_t* write_buf, uint8_t write_len);
+
+    /// Waits for CTS from the chip, and then reads any reply to the last command
+    /// \param[out] read_buf Pointer to read_len bytes of storage for the reply, or NULL
+    /// \param[in] read_len The number of bytes to read from the reply stream
+    /// \return true if CTS was received
+    bool           wait_cts(uint8_t* read_buf = 0, uint8_t read_len = 0);
 
     /// Loads data into the chips TX FIFO
     /// \param[in] data Array of data bytes to be loaded
@@ -1096,8 +1163,14 @@ protected:
     /// Sets registers, commands and properties
     /// in the ratio according to the data in the commands array
     /// \param[in] commands Array of data containing radio commands in the format provided by radio_config_Si4460.h
+    /// \param[in] powerUp false to skip any RH_RF24_CMD_POWER_UP command in commands
     /// \return true if successful
-    bool           configure(const uint8_t* commands);
+    bool           configure(const uint8_t* commands, bool powerUp = true);
+
+    /// Sets the properties the RH_RF24 driver depends on, irrespective of the radio configuration,
+    /// and the default packet format, sync words etc.
+    /// \return true if successful
+    bool           configureDefaults();
 
     /// Clears all pending interrutps in the radio chip.
     bool           cmd_clear_all_interrupts();
@@ -1153,6 +1226,9 @@ private:
     /// Time in millis since the last preamble was received (and the last time the RSSI was measured)
     uint32_t            _lastPreambleTime;
 
+    /// True if a command was sent by command_nowait() and CTS has not been seen since
+    volatile bool       _ctsPending;
+
 };
 
 /// @example rf24_client.pde
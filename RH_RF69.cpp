@@ -47,6 +47,7 @@ PROGMEM static const RH_RF69::ModemConfig MODEM_CONFIG_TABLE[] =
     { CONFIG_FSK,  0x01, 0x00, 0x08, 0x00, 0xe1, 0xe1, CONFIG_WHITE}, // FSK_Rb125Fd125
     { CONFIG_FSK,  0x00, 0x80, 0x10, 0x00, 0xe0, 0xe0, CONFIG_WHITE}, // FSK_Rb250Fd250
     { CONFIG_FSK,  0x02, 0x40, 0x03, 0x33, 0x42, 0x42, CONFIG_WHITE}, // FSK_Rb55555Fd50 
+    { CONFIG_FSK,  0x02, 0x40, 0x03, 0x33, 0x42, 0x42, CONFIG_NOWHITE}, // FSK_MOTEINO
 
     //  02,        03,   04,   05,   06,   19,   1a,  37
     // GFSK (BT=1.0), No Manchester, whitening, CRC, no address filtering
@@ -474,7 +475,7 @@ void RH_RF69::setModemRegisters(const ModemConfig* config)
 // Returns true if its a valid choice
 bool RH_RF69::setModemConfig(ModemConfigChoice index)
 {
-    if (index > (signed int)(sizeof(MODEM_CONFIG_TABLE) / sizeof(ModemConfig)))
+    if (index >= (signed int)(sizeof(MODEM_CONFIG_TABLE) / sizeof(ModemConfig)))
         return false;
 
     ModemConfig cfg;
@@ -505,6 +506,14 @@ void RH_RF69::setSyncWords(const uint8_t* syncWords, uint8_t len)
     spiWrite(RH_RF69_REG_2E_SYNCCONFIG, syncconfig);
 }
 
+bool RH_RF69::setHardwareEncryption(const uint8_t* key, uint8_t len)
+{
+    if (key && len != 16)
+	return false;
+    setEncryptionKey((uint8_t*)key);
+    return true;
+}
+
 void RH_RF69::setEncryptionKey(uint8_t* key)
 {
     if (key)
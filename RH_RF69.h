@@ -179,6 +179,16 @@
 #define RH_RF69_PALEVEL_PA2ON                               0x20
 #define RH_RF69_PALEVEL_OUTPUTPOWER                         0x1f
 
+// RH_RF69_REG_19_RXBW and RH_RF69_REG_1A_AFCBW
+#define RH_RF69_RXBW_DCCFREQ                                0xe0
+#define RH_RF69_RXBW_DCCFREQ_DEFAULT                        0x40
+#define RH_RF69_RXBW_DCCFREQ_LOWEST                         0xe0
+#define RH_RF69_RXBW_MANT                                   0x18
+#define RH_RF69_RXBW_MANT_16                                0x00
+#define RH_RF69_RXBW_MANT_20                                0x08
+#define RH_RF69_RXBW_MANT_24                                0x10
+#define RH_RF69_RXBW_EXP                                    0x07
+
 // RH_RF69_REG_23_RSSICONFIG
 #define RH_RF69_RSSICONFIG_RSSIDONE                         0x02
 #define RH_RF69_RSSICONFIG_RSSISTART                        0x01
@@ -333,6 +343,62 @@
 // Define this to include Serial printing in diagnostic routines
 #define RH_RF69_HAVE_SERIAL
 
+// Modem configuration generator, see "Custom modem configurations" below.
+// True if the modulation type in a RH_RF69_REG_02_DATAMODUL value is OOK
+#define RH_RF69_IS_OOK(datamodul) \
+    (((datamodul) & RH_RF69_DATAMODUL_MODULATIONTYPE) == RH_RF69_DATAMODUL_MODULATIONTYPE_OOK)
+
+// Channel filter bandwidth in Hz for a mantissa (16, 20 or 24) and exponent (0 to 7). OOK filters are half as wide
+#define RH_RF69_RXBW_HZ(mant, exp, ook) ((32000000UL >> ((exp) + 2 + ((ook) ? 1 : 0))) / (mant))
+
+// RH_RF69_RXBW_MANT and RH_RF69_RXBW_EXP bits for the narrowest channel filter at least bw Hz wide,
+// or 0xff if there is none
+#define RH_RF69_RXBW_STEP(bw, ook, exp, wider) \
+    ((bw) <= RH_RF69_RXBW_HZ(24, exp, ook) ? (RH_RF69_RXBW_MANT_24 | (exp)) : \
+     (bw) <= RH_RF69_RXBW_HZ(20, exp, ook) ? (RH_RF69_RXBW_MANT_20 | (exp)) : \
+     (bw) <= RH_RF69_RXBW_HZ(16, exp, ook) ? (RH_RF69_RXBW_MANT_16 | (exp)) : (wider))
+#define RH_RF69_RXBW_BITS(bw, ook) \
+    RH_RF69_RXBW_STEP(bw, ook, 7, RH_RF69_RXBW_STEP(bw, ook, 6, RH_RF69_RXBW_STEP(bw, ook, 5, \
+    RH_RF69_RXBW_STEP(bw, ook, 4, RH_RF69_RXBW_STEP(bw, ook, 3, RH_RF69_RXBW_STEP(bw, ook, 2, \
+    RH_RF69_RXBW_STEP(bw, ook, 1, RH_RF69_RXBW_STEP(bw, ook, 0, 0xff))))))))
+
+// Register values for a bit rate and frequency deviation in Hz
+#define RH_RF69_BITRATE_REG(bitrate) ((32000000UL + (bitrate) / 2) / (bitrate))
+#define RH_RF69_FDEV_REG(fdev)       (((uint32_t)(fdev) * 2048UL + 62500UL) / 125000UL)
+
+// True if the bit rate, deviation and receiver bandwidth in Hz are within the datasheet limits for the modulation.
+// For FSK and GFSK, the modulation index must be 0.5 to 10 and the signal must fit in the channel filter
+#define RH_RF69_CONFIG_VALID(datamodul, bitrate, fdev, rxbw) \
+    (RH_RF69_IS_OOK(datamodul) \
+     ? ((bitrate) >= 1200 && (bitrate) <= 32768) \
+     : (   (bitrate) >= 1200 && (bitrate) <= 300000 \
+	&& (fdev) >= 600 && (fdev) + (bitrate) / 2 <= 500000 \
+	&& 4UL * (fdev) >= (bitrate) && (fdev) <= 5UL * (bitrate) \
+	&& (rxbw) >= (fdev) + (bitrate) / 2))
+
+// Initialiser for an RH_RF69::ModemConfig with every choice explicit: a RH_RF69_REG_02_DATAMODUL value, the bit rate,
+// frequency deviation, receiver bandwidth and AFC bandwidth in Hz, the RH_RF69_RXBW_DCCFREQ bits for both bandwidth
+// registers and a RH_RF69_REG_37_PACKETCONFIG1 value. Only checks that the bandwidths are available, so it can also
+// express configurations outside the datasheet limits, as some of the canned ones are.
+#define RH_RF69_MODEM_CONFIG_FULL(datamodul, bitrate, fdev, rxbw, afcbw, dcc, packetconfig1) \
+    { (uint8_t)((datamodul) \
+		+ RH_CONFIG_CHECK(RH_RF69_RXBW_BITS(rxbw, RH_RF69_IS_OOK(datamodul)) != 0xff) \
+		+ RH_CONFIG_CHECK(RH_RF69_RXBW_BITS(afcbw, RH_RF69_IS_OOK(datamodul)) != 0xff)), \
+      (uint8_t)(RH_RF69_BITRATE_REG(bitrate) >> 8), \
+      (uint8_t)(RH_RF69_BITRATE_REG(bitrate) & 0xff), \
+      (uint8_t)(RH_RF69_FDEV_REG(fdev) >> 8), \
+      (uint8_t)(RH_RF69_FDEV_REG(fdev) & 0xff), \
+      (uint8_t)((dcc) | RH_RF69_RXBW_BITS(rxbw, RH_RF69_IS_OOK(datamodul))), \
+      (uint8_t)((dcc) | RH_RF69_RXBW_BITS(afcbw, RH_RF69_IS_OOK(datamodul))), \
+      (uint8_t)(packetconfig1) }
+
+// Initialiser for an RH_RF69::ModemConfig, from a RH_RF69_REG_02_DATAMODUL value, the bit rate, frequency deviation
+// and receiver (and AFC) bandwidth in Hz and a RH_RF69_REG_37_PACKETCONFIG1 value. Invalid values fail to compile.
+// The DC canceller cutoff is the lowest, as in most of the canned configurations.
+#define RH_RF69_MODEM_CONFIG(datamodul, bitrate, fdev, rxbw, packetconfig1) \
+    RH_RF69_MODEM_CONFIG_FULL(datamodul, bitrate, fdev, rxbw, rxbw, RH_RF69_RXBW_DCCFREQ_LOWEST, \
+			      (packetconfig1) + RH_CONFIG_CHECK(RH_RF69_CONFIG_VALID(datamodul, bitrate, fdev, rxbw)))
+
 
 /////////////////////////////////////////////////////////////////////
 /// \class RH_RF69 RH_RF69.h <RH_RF69.h>
@@ -627,6 +693,8 @@
 ///
 /// This driver support the on-chip AES encryption provided by the RF69.
 /// You can enable encryption by calling setEncryptionKey() after init() has been called.
+/// If you use RHEncryptedDriver with an AES128 cipher and call RHEncryptedDriver::setHardwareAes(true),
+/// RHEncryptedDriver::setKey() enables the on-chip encryption for you, instead of encrypting in software.
 /// If both transmitter and receiver have been configured with the same AES key,
 /// then the receiver will recover the unencrypted message sent by the receiver.
 /// However, you should note that there is no way for RF69 nor for the RadioHead
@@ -744,6 +812,30 @@
 /// Caution: although the RFM69 appears to have a PC antenna on board, you will get much better power and range even 
 /// with just a 1/4 wave wire antenna.
 ///
+/// \par Custom modem configurations
+///
+/// If none of the ModemConfigChoice configurations suit, the RH_RF69_MODEM_CONFIG macro calculates
+/// the register values of a ModemConfig from the modulation, bit rate, frequency deviation and receiver bandwidth.
+/// It is evaluated by the compiler, so the table costs no more than raw register values, and combinations outside
+/// the datasheet limits (bit rate, modulation index from 0.5 to 10, signal wider than the receiver bandwidth) fail to compile.
+/// The narrowest channel filter at least as wide as the requested receiver bandwidth is chosen, the
+/// AFC bandwidth is set to the same, and the DC canceller cutoff is set to the lowest (RH_RF69_RXBW_DCCFREQ_LOWEST),
+/// as in most of the canned configurations. Eg, for GFSK at 100kbps with 50kHz deviation, whitening and CRCs:
+/// \code
+/// static const RH_RF69::ModemConfig fastConfig = RH_RF69_MODEM_CONFIG(
+///     RH_RF69_DATAMODUL_DATAMODE_PACKET | RH_RF69_DATAMODUL_MODULATIONTYPE_FSK | RH_RF69_DATAMODUL_MODULATIONSHAPING_FSK_BT1_0,
+///     100000, 50000, 125000,
+///     RH_RF69_PACKETCONFIG1_PACKETFORMAT_VARIABLE | RH_RF69_PACKETCONFIG1_DCFREE_WHITENING | RH_RF69_PACKETCONFIG1_CRC_ON);
+/// driver.setModemRegisters(&fastConfig);
+/// \endcode
+/// RH_RF69_MODEM_CONFIG_FULL also takes a separate AFC bandwidth and the DC canceller cutoff, and does not check
+/// the datasheet limits. Some of the canned configurations need it: FSK_Rb9_6Fd19_2 to FSK_Rb57_6Fd120 (and the
+/// GFSK equivalents) use receiver bandwidths narrower than their signals, FSK_Rb55555Fd50, FSK_MOTEINO and GFSK_Rb55555Fd50
+/// use RH_RF69_RXBW_DCCFREQ_DEFAULT, GFSK_Rb2Fd5 has a narrower AFC bandwidth, and OOK_Rb1Bw1 is below the
+/// minimum OOK bit rate. tools/modemConfigCheck checks at compile time that the generators reproduce
+/// every canned configuration.
+/// setModemRegisters() writes the configuration in 3 SPI transactions.
+///
 /// \par Performance
 ///
 /// Some simple speed performance tests have been conducted.
@@ -1013,6 +1105,13 @@ public:
     /// encryption is disabled, which is the default.
     void           setEncryptionKey(uint8_t* key = NULL);
 
+    /// Enables or disables the on-chip AES encryption, as for setEncryptionKey(). Used by RHEncryptedDriver
+    /// to hand encryption of messages to the radio.
+    /// \param[in] key The 16 octet AES key to use, or NULL to disable encryption
+    /// \param[in] len Length of key. Must be 16 unless key is NULL.
+    /// \return true if encryption was enabled (or disabled)
+    virtual bool   setHardwareEncryption(const uint8_t* key, uint8_t len);
+
     /// Returns the time in millis since the most recent preamble was received, and when the most recent
     /// RSSI measurement was made.
     uint32_t getLastPreambleTime();
@@ -37,6 +37,17 @@ RH_RF95::RH_RF95(uint8_t slaveSelectPin, uint8_t interruptPin, RHGenericSPI& spi
 #endif
     _enableCRC = true;
     _useRFO = false;
+    _frequency = 0;
+    _numDutyCycleBands = 0;
+    _numScanChannels = 0;
+    _scanIndex = 0;
+    _rxScanChannel = 0;
+    _scanning = false;
+    _scanBusy = false;
+    _numHopChannels = 0;
+    _hopPeriod = 0;
+    _hopInterrupt = false;
+    _hopDioMapping = 0;
 }
 
 bool RH_RF95::init()
@@ -169,6 +180,10 @@ void RH_RF95::handleInterrupt()
     // spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags
     spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags
 
+    // Time for the next frequency, maybe at the same time as another event
+    if (irq_flags & RH_RF95_FHSS_CHANGE_CHANNEL)
+	handleHop();
+
     // error if:
     // timeout
     // bad CRC
@@ -181,6 +196,8 @@ void RH_RF95::handleInterrupt()
 //	Serial.println("E");
 	_rxBad++;
         clearRxBuf();
+	if (_scanBusy)
+	    scanNext(); // The receiver has stopped, keep scanning
     }
     // It is possible to get RX_DONE and CRC_ERROR and VALID_HEADER all at once
     // so this must be an else
@@ -218,7 +235,12 @@ void RH_RF95::handleInterrupt()
 	// We have received a message.
 	validateRxBuf();
 	if (_rxBufValid)
+	{
+	    _rxScanChannel = _scanIndex;
 	    setModeIdle(); // Got one
+	}
+	else if (_scanBusy)
+	    scanNext(); // Not for us, keep scanning
     }
     else if (_mode == RHModeTx && irq_flags & RH_RF95_TX_DONE)
     {
@@ -230,12 +252,19 @@ void RH_RF95::handleInterrupt()
     {
 //	Serial.println("C");
         _cad = irq_flags & RH_RF95_CAD_DETECTED;
-        setModeIdle();
+	if (_scanBusy)
+	    scanCadDone(_cad);
+	else
+	    setModeIdle();
     }
     else
     {
 //	Serial.println("?");
     }
+
+    // Each message starts on the first hop frequency
+    if (irq_flags & (RH_RF95_RX_DONE | RH_RF95_TX_DONE | RH_RF95_RX_TIMEOUT))
+	hopReset();
 	
     // Sigh: on some processors, for some unknown reason, doing this only once does not actually
     // clear the radio's interrupt flag. So we do it twice. Why?
@@ -289,7 +318,18 @@ bool RH_RF95::available()
 #ifdef RH_RF95_IRQLESS
     // Read the interrupt register
     uint8_t irq_flags = spiRead(RH_RF95_REG_12_IRQ_FLAGS);
-    if (_mode == RHModeRx && irq_flags & RH_RF95_RX_DONE)
+    if (irq_flags & RH_RF95_FHSS_CHANGE_CHANNEL)
+	handleHop();
+    if (_scanBusy && _mode == RHModeRx && irq_flags & (RH_RF95_RX_TIMEOUT | RH_RF95_PAYLOAD_CRC_ERROR))
+    {
+	// Nothing (good) received on this channel, keep scanning
+	spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags
+	if (irq_flags & RH_RF95_PAYLOAD_CRC_ERROR)
+	    _rxBad++;
+	scanNext();
+	return false;
+    }
+    else if (_mode == RHModeRx && irq_flags & RH_RF95_RX_DONE)
     {
     // Have received a packet
     uint8_t len = spiRead(RH_RF95_REG_13_RX_NB_BYTES);
@@ -305,23 +345,59 @@ bool RH_RF95::available()
     // weakest receiveable signals are reported RSSI at about -66
     _lastRssi = spiRead(RH_RF95_REG_1A_PKT_RSSI_VALUE) - 137;
 
+    hopReset();
+
     // We have received a message.
     validateRxBuf();
     if (_rxBufValid)
+    {
+        _rxScanChannel = _scanIndex;
         setModeIdle(); // Got one
     }
+    else if (_scanBusy)
+    {
+        scanNext(); // Not for us, keep scanning
+        return false;
+    }
+    }
     else if (_mode == RHModeCad && irq_flags & RH_RF95_CAD_DONE)
     {
         _cad = irq_flags & RH_RF95_CAD_DETECTED;
+        if (_scanBusy)
+        {
+            spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags before the next CAD or RX
+            scanCadDone(_cad);
+            return false;
+        }
         setModeIdle();
     }
 
     spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags
 
+#else
+    pollHop();
 #endif // defined RH_RF95_IRQLESS
 
     if (_mode == RHModeTx)
 	return false;
+    if (_scanning)
+    {
+	if (!_rxBufValid)
+	{
+	    if (!_scanBusy)
+		scanNext(); // Start or resume scanning
+#ifndef RH_RF95_IRQLESS
+	    else if (_mode == RHModeRx && (spiRead(RH_RF95_REG_12_IRQ_FLAGS) & RH_RF95_RX_TIMEOUT))
+	    {
+		// The RX timeout is not routed to DIO0, so we have to look for it.
+		// The receiver is in standby now, so the interrupt handler cannot be changing channel
+		spiWrite(RH_RF95_REG_12_IRQ_FLAGS, RH_RF95_RX_TIMEOUT);
+		scanNext();
+	    }
+#endif
+	}
+	return _rxBufValid;
+    }
     setModeRx();
     return _rxBufValid; // Will be set by the interrupt handler when a good message is received
 }
@@ -359,9 +435,22 @@ bool RH_RF95::send(const uint8_t* data, uint8_t len)
     waitPacketSent(); // Make sure we dont interrupt an outgoing message
     setModeIdle();
 
+    // Check the regulatory duty cycle limit, if any
+    uint32_t time = 0;
+    DutyCycleBand* band = dutyCycleBand();
+    if (band)
+    {
+	time = airtime(len);
+	if (time > band->budget)
+	    return false; // Try again after dutyCycleWait()
+    }
+
     if (!waitCAD())
 	return false;  // Check channel activity
 
+    if (band)
+	band->budget -= time;
+
     // Position at the beginning of the FIFO
     spiWrite(RH_RF95_REG_0D_FIFO_ADDR_PTR, 0);
     // The headers
@@ -373,6 +462,7 @@ bool RH_RF95::send(const uint8_t* data, uint8_t len)
     spiBurstWrite(RH_RF95_REG_00_FIFO, data, len);
     spiWrite(RH_RF95_REG_22_PAYLOAD_LENGTH, len + RH_RF95_HEADER_LEN);
 
+    hopReset();
     setModeTx(); // Start the transmitter
     // when Tx is done, interruptHandler will fire and radio mode will return to STANDBY
     return true;
@@ -387,17 +477,44 @@ bool RH_RF95::waitPacketSent()
     if (_mode != RHModeTx)
     return false;
 
-    while (!(spiRead(RH_RF95_REG_12_IRQ_FLAGS) & RH_RF95_TX_DONE)){
+    uint8_t irq_flags;
+    while (!((irq_flags = spiRead(RH_RF95_REG_12_IRQ_FLAGS)) & RH_RF95_TX_DONE)){
+      if (irq_flags & RH_RF95_FHSS_CHANGE_CHANNEL)
+	  handleHop();
       YIELD;
     }
 
     // A transmitter message has been fully sent
     _txGood++;
     setModeIdle(); // Clears FIFO
+    hopReset();
+    return true;
+}
+#else
+bool RH_RF95::waitPacketSent()
+{
+    while (_mode == RHModeTx)
+    {
+	pollHop();
+	YIELD; // Wait for any previous transmit to finish
+    }
     return true;
 }
 #endif // defined RH_RF95_IRQLESS
 
+bool RH_RF95::waitPacketSent(uint16_t timeout)
+{
+    unsigned long starttime = millis();
+    while ((millis() - starttime) < timeout)
+    {
+        if (_mode != RHModeTx) // Any previous transmit finished?
+           return true;
+	pollHop();
+	YIELD;
+    }
+    return false;
+}
+
 bool RH_RF95::printRegisters()
 {
 #ifdef RH_HAVE_SERIAL
@@ -427,12 +544,14 @@ bool RH_RF95::setFrequency(float centre)
     spiWrite(RH_RF95_REG_07_FRF_MID, (frf >> 8) & 0xff);
     spiWrite(RH_RF95_REG_08_FRF_LSB, frf & 0xff);
     _usingHFport = (centre >= 779.0);
+    _frequency = centre * 1000.0 + 0.5;
 
     return true;
 }
 
 void RH_RF95::setModeIdle()
 {
+    _scanBusy = false;
     if (_mode != RHModeIdle)
     {
     modeWillChange(RHModeIdle);
@@ -443,6 +562,7 @@ void RH_RF95::setModeIdle()
 
 bool RH_RF95::sleep()
 {
+    _scanBusy = false;
     if (_mode != RHModeSleep)
     {
  	modeWillChange(RHModeSleep);       
@@ -454,22 +574,25 @@ bool RH_RF95::sleep()
 
 void RH_RF95::setModeRx()
 {
+    _scanBusy = false;
     if (_mode != RHModeRx)
     {
 	modeWillChange(RHModeRx);
+	hopReset();
 	spiWrite(RH_RF95_REG_01_OP_MODE, RH_RF95_MODE_RXCONTINUOUS);
-	spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x00); // Interrupt on RxDone
+	spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x00 | _hopDioMapping); // Interrupt on RxDone
 	_mode = RHModeRx;
     }
 }
 
 void RH_RF95::setModeTx()
 {
+    _scanBusy = false;
     if (_mode != RHModeTx)
     {
     modeWillChange(RHModeTx);
 	spiWrite(RH_RF95_REG_01_OP_MODE, RH_RF95_MODE_TX);
-	spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x40); // Interrupt on TxDone
+	spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x40 | _hopDioMapping); // Interrupt on TxDone
 	_mode = RHModeTx;
     }
 }
@@ -521,8 +644,7 @@ void RH_RF95::setTxPower(int8_t power, bool useRFO)
 // Sets registers from a canned modem configuration structure
 void RH_RF95::setModemRegisters(const ModemConfig* config)
 {
-    spiWrite(RH_RF95_REG_1D_MODEM_CONFIG1,       config->reg_1d);
-    spiWrite(RH_RF95_REG_1E_MODEM_CONFIG2,       config->reg_1e);
+    spiBurstWrite(RH_RF95_REG_1D_MODEM_CONFIG1,  &config->reg_1d, 2);
     spiWrite(RH_RF95_REG_26_MODEM_CONFIG3,       config->reg_26);
 }
 
@@ -530,7 +652,7 @@ void RH_RF95::setModemRegisters(const ModemConfig* config)
 // Returns true if its a valid choice
 bool RH_RF95::setModemConfig(ModemConfigChoice index)
 {
-    if (index > (signed int)(sizeof(MODEM_CONFIG_TABLE) / sizeof(ModemConfig)))
+    if (index >= (signed int)(sizeof(MODEM_CONFIG_TABLE) / sizeof(ModemConfig)))
         return false;
 
     ModemConfig cfg;
@@ -549,11 +671,13 @@ void RH_RF95::setPreambleLength(uint16_t bytes)
 bool RH_RF95::isChannelActive()
 {
     // Set mode RHModeCad
+    if (_scanBusy)
+	setModeIdle(); // Our own CAD, not the scanner's
     if (_mode != RHModeCad)
     {
         modeWillChange(RHModeCad);
         spiWrite(RH_RF95_REG_01_OP_MODE, RH_RF95_MODE_CAD);
-        spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x80); // Interrupt on CadDone
+        spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x80 | _hopDioMapping); // Interrupt on CadDone
         _mode = RHModeCad;
     }
 
@@ -650,7 +774,14 @@ int RH_RF95::lastSNR()
    setLowDatarate();
  }
 
-void RH_RF95::setSignalBandwidth(long sbw)
+uint8_t RH_RF95::spreadingFactor()
+{
+    // sf is in bits 7..4
+    return spiRead(RH_RF95_REG_1E_MODEM_CONFIG2) >> 4;
+}
+
+// Returns the bandwidth bits of RH_RF95_REG_1D_MODEM_CONFIG1 for a signal bandwidth in Hz
+static uint8_t bandwidthBits(long sbw)
 {
     uint8_t bw; //register bit pattern
 
@@ -674,6 +805,12 @@ void RH_RF95::setSignalBandwidth(long sbw)
 	bw = RH_RF95_BW_250KHZ;
     else
 	bw =  RH_RF95_BW_500KHZ;
+    return bw;
+}
+
+void RH_RF95::setSignalBandwidth(long sbw)
+{
+    uint8_t bw = bandwidthBits(sbw);
 
     // top 4 bits of reg 1D control bandwidth
     spiWrite(RH_RF95_REG_1D_MODEM_CONFIG1, (spiRead(RH_RF95_REG_1D_MODEM_CONFIG1) & ~RH_RF95_BW) | bw);
@@ -746,3 +883,355 @@ void RH_RF95::setPayloadCRC(bool on)
     _enableCRC = on;
 }
 
+// Bandwidths in Hz, indexed by the bandwidth field of RH_RF95_REG_1D_MODEM_CONFIG1
+PROGMEM static const float BANDWIDTH_TABLE[] =
+{
+    7812.5, 10416.667, 15625, 20833.333, 31250, 41666.667, 62500, 125000, 250000, 500000
+};
+
+uint32_t RH_RF95::airtime(const ModemConfig* config, uint8_t len, uint16_t preambleLength)
+{
+    // See Semtech SX1276 datasheet section 4.1.1.7
+    uint8_t sf = config->reg_1e >> 4;
+    uint8_t bwindex = config->reg_1d >> 4;
+    uint8_t cr = (config->reg_1d & RH_RF95_CODING_RATE) >> 1; // 1 to 4 for 4/5 to 4/8
+    if (sf < 6 || sf > 12 || cr < 1 || cr > 4 || bwindex >= (sizeof(BANDWIDTH_TABLE) / sizeof(float)))
+	return 0;
+    bool ih = config->reg_1d & RH_RF95_IMPLICIT_HEADER_MODE_ON;
+    bool crc = config->reg_1e & RH_RF95_PAYLOAD_CRC_ON;
+    bool de = config->reg_26 & RH_RF95_LOW_DATA_RATE_OPTIMIZE;
+    float bandwidth;
+    memcpy_P(&bandwidth, &BANDWIDTH_TABLE[bwindex], sizeof(float));
+
+    // Number of payload symbols
+    int32_t numerator = 8 * ((int32_t)len + RH_RF95_HEADER_LEN) - 4 * sf + 28 + (crc ? 16 : 0) - (ih ? 20 : 0);
+    int32_t denominator = 4 * (sf - (de ? 2 : 0));
+    int32_t blocks = numerator > 0 ? (numerator + denominator - 1) / denominator : 0;
+    uint32_t payloadSymbols = 8 + blocks * (cr + 4);
+
+    // Total in quarter symbols, since the preamble has 4.25 symbols more than its programmed length
+    float quarterSymbols = 4.0 * preambleLength + 17 + 4 * payloadSymbols;
+    float time = quarterSymbols * (1UL << sf) * 250000.0 / bandwidth; // microseconds
+    return time < 4294967295.0 ? (uint32_t)time : 0xffffffff;
+}
+
+uint32_t RH_RF95::airtime(ModemConfigChoice index, uint8_t len, uint16_t preambleLength)
+{
+    if (index < 0 || index >= (signed int)(sizeof(MODEM_CONFIG_TABLE) / sizeof(ModemConfig)))
+	return 0;
+
+    ModemConfig cfg;
+    memcpy_P(&cfg, &MODEM_CONFIG_TABLE[index], sizeof(RH_RF95::ModemConfig));
+    return airtime(&cfg, len, preambleLength);
+}
+
+uint32_t RH_RF95::airtime(uint8_t len)
+{
+    ModemConfig cfg;
+    cfg.reg_1d = spiRead(RH_RF95_REG_1D_MODEM_CONFIG1);
+    cfg.reg_1e = spiRead(RH_RF95_REG_1E_MODEM_CONFIG2);
+    cfg.reg_26 = spiRead(RH_RF95_REG_26_MODEM_CONFIG3);
+    uint16_t preambleLength = ((uint16_t)spiRead(RH_RF95_REG_20_PREAMBLE_MSB) << 8) | spiRead(RH_RF95_REG_21_PREAMBLE_LSB);
+    return airtime(&cfg, len, preambleLength);
+}
+
+bool RH_RF95::setDutyCycleBand(float minFreq, float maxFreq, uint16_t dutyCycle)
+{
+    uint32_t minKHz = minFreq * 1000.0 + 0.5;
+    uint32_t maxKHz = maxFreq * 1000.0 + 0.5;
+    uint8_t i;
+    for (i = 0; i < _numDutyCycleBands; i++)
+	if (_dutyCycleBands[i].minFreq == minKHz && _dutyCycleBands[i].maxFreq == maxKHz)
+	    break;
+    if (i == _numDutyCycleBands)
+    {
+	// A new sub-band
+	if (_numDutyCycleBands >= RH_RF95_NUM_DUTY_CYCLE_BANDS)
+	    return false;
+	_numDutyCycleBands++;
+	_dutyCycleBands[i].minFreq = minKHz;
+	_dutyCycleBands[i].maxFreq = maxKHz;
+	_dutyCycleBands[i].budget = 0xffffffff; // Clamped to the full budget below
+    }
+    if (dutyCycle > 1000)
+	dutyCycle = 1000;
+    _dutyCycleBands[i].dutyCycle = dutyCycle;
+    uint32_t full = RH_RF95_DUTY_CYCLE_WINDOW * dutyCycle; // microseconds
+    if (_dutyCycleBands[i].budget > full)
+	_dutyCycleBands[i].budget = full;
+    _dutyCycleBands[i].lastUpdate = millis();
+    return true;
+}
+
+void RH_RF95::setDutyCycleBandsEU868()
+{
+    clearDutyCycleBands();
+    setDutyCycleBand(863.0, 868.0, 10);
+    setDutyCycleBand(868.0, 868.6, 10);
+    setDutyCycleBand(868.7, 869.2, 1);
+    setDutyCycleBand(869.4, 869.65, 100);
+    setDutyCycleBand(869.7, 870.0, 10);
+}
+
+void RH_RF95::clearDutyCycleBands()
+{
+    _numDutyCycleBands = 0;
+}
+
+RH_RF95::DutyCycleBand* RH_RF95::dutyCycleBand()
+{
+    for (uint8_t i = 0; i < _numDutyCycleBands; i++)
+    {
+	DutyCycleBand* band = &_dutyCycleBands[i];
+	if (_frequency < band->minFreq || _frequency > band->maxFreq)
+	    continue;
+
+	// Found it. The budget fills at the permitted duty cycle: dutyCycle microseconds
+	// per millisecond, up to the amount permitted in the whole window
+	unsigned long now = millis();
+	unsigned long elapsed = now - band->lastUpdate;
+	uint32_t full = RH_RF95_DUTY_CYCLE_WINDOW * band->dutyCycle;
+	if (elapsed >= RH_RF95_DUTY_CYCLE_WINDOW || full - band->budget <= (uint32_t)elapsed * band->dutyCycle)
+	    band->budget = full;
+	else
+	    band->budget += elapsed * band->dutyCycle;
+	band->lastUpdate = now;
+	return band;
+    }
+    return NULL; // Not limited
+}
+
+uint32_t RH_RF95::dutyCycleBudget()
+{
+    DutyCycleBand* band = dutyCycleBand();
+    return band ? band->budget : 0xffffffff;
+}
+
+unsigned long RH_RF95::dutyCycleWait(uint8_t len)
+{
+    DutyCycleBand* band = dutyCycleBand();
+    if (!band)
+	return 0;
+    uint32_t time = airtime(len);
+    if (time <= band->budget)
+	return 0;
+    if (band->dutyCycle == 0 || time > RH_RF95_DUTY_CYCLE_WINDOW * band->dutyCycle)
+	return 0xffffffff; // Never
+    return (time - band->budget + band->dutyCycle - 1) / band->dutyCycle;
+}
+
+bool RH_RF95::addScanChannel(float centre, uint8_t sf, long bandwidth)
+{
+    if (_numScanChannels >= RH_RF95_MAX_SCAN_CHANNELS)
+	return false;
+    if (sf < 6)
+	sf = 6;
+    else if (sf > 12)
+	sf = 12;
+
+    ScanChannel* channel = &_scanChannels[_numScanChannels++];
+    uint32_t frf = (centre * 1000000.0) / RH_RF95_FSTEP;
+    channel->freq = centre * 1000.0 + 0.5;
+    channel->frf[0] = (frf >> 16) & 0xff;
+    channel->frf[1] = (frf >> 8) & 0xff;
+    channel->frf[2] = frf & 0xff;
+    channel->reg_1d = bandwidthBits(bandwidth);
+    channel->reg_1e = sf << 4;
+    // Low data rate optimisation if the symbol time is over 16ms, as setLowDatarate()
+    float bw;
+    memcpy_P(&bw, &BANDWIDTH_TABLE[channel->reg_1d >> 4], sizeof(float));
+    channel->reg_26 = ((1000.0 * (1UL << sf) / bw) > 16.0) ? RH_RF95_LOW_DATA_RATE_OPTIMIZE : 0;
+    return true;
+}
+
+void RH_RF95::clearScanChannels()
+{
+    stopScan();
+    _numScanChannels = 0;
+}
+
+bool RH_RF95::startScan()
+{
+    if (!_numScanChannels || hopping())
+	return false; // Hopping and scanning both take over the frequency
+    stopScan();
+    setModeIdle();
+
+    // Remember where we are, to come back to
+    _scanHome.freq = _frequency;
+    _scanHome.frf[0] = spiRead(RH_RF95_REG_06_FRF_MSB);
+    _scanHome.frf[1] = spiRead(RH_RF95_REG_07_FRF_MID);
+    _scanHome.frf[2] = spiRead(RH_RF95_REG_08_FRF_LSB);
+    _scanHome.reg_1d = spiRead(RH_RF95_REG_1D_MODEM_CONFIG1);
+    _scanHome.reg_1e = spiRead(RH_RF95_REG_1E_MODEM_CONFIG2);
+    _scanHome.reg_26 = spiRead(RH_RF95_REG_26_MODEM_CONFIG3);
+    _scanHomeSymbTimeout = spiRead(RH_RF95_REG_1F_SYMB_TIMEOUT_LSB);
+
+    // Everything except the bandwidth, spreading factor and low data rate optimisation comes from
+    // the current configuration. The symbol timeout MSBs (bits 1..0 of reg 1E) are 0
+    for (uint8_t i = 0; i < _numScanChannels; i++)
+    {
+	ScanChannel* channel = &_scanChannels[i];
+	channel->reg_1d = (channel->reg_1d & RH_RF95_BW) | (_scanHome.reg_1d & ~RH_RF95_BW);
+	channel->reg_1e = (channel->reg_1e & RH_RF95_SPREADING_FACTOR) | (_scanHome.reg_1e & ~(RH_RF95_SPREADING_FACTOR | 0x03));
+	channel->reg_26 = (channel->reg_26 & RH_RF95_LOW_DATA_RATE_OPTIMIZE) | (_scanHome.reg_26 & ~RH_RF95_LOW_DATA_RATE_OPTIMIZE);
+    }
+    spiWrite(RH_RF95_REG_1F_SYMB_TIMEOUT_LSB, RH_RF95_SCAN_SYMBOL_TIMEOUT);
+
+    _scanIndex = _numScanChannels - 1; // scanNext() starts at the first channel
+    _scanning = true;
+    clearRxBuf();
+    scanNext();
+    return true;
+}
+
+void RH_RF95::stopScan()
+{
+    if (!_scanning)
+	return;
+    _scanning = false;
+    setModeIdle(); // Stops the scanner
+    setScanChannelRegisters(&_scanHome);
+    spiWrite(RH_RF95_REG_1F_SYMB_TIMEOUT_LSB, _scanHomeSymbTimeout);
+}
+
+void RH_RF95::setScanChannelRegisters(const ScanChannel* channel)
+{
+    spiBurstWrite(RH_RF95_REG_06_FRF_MSB, channel->frf, sizeof(channel->frf));
+    spiBurstWrite(RH_RF95_REG_1D_MODEM_CONFIG1, &channel->reg_1d, 2);
+    spiWrite(RH_RF95_REG_26_MODEM_CONFIG3, channel->reg_26);
+    _frequency = channel->freq;
+    _usingHFport = (channel->freq >= 779000);
+}
+
+void RH_RF95::scanNext()
+{
+    // The frequency can only be changed in standby
+    spiWrite(RH_RF95_REG_01_OP_MODE, RH_RF95_MODE_STDBY);
+    _scanIndex = (_scanIndex + 1) % _numScanChannels;
+    setScanChannelRegisters(&_scanChannels[_scanIndex]);
+
+    modeWillChange(RHModeCad);
+    spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x80 | _hopDioMapping); // Interrupt on CadDone
+    spiWrite(RH_RF95_REG_01_OP_MODE, RH_RF95_MODE_CAD);
+    _mode = RHModeCad;
+    _scanBusy = true;
+}
+
+void RH_RF95::scanCadDone(bool detected)
+{
+    if (!detected)
+    {
+	scanNext();
+	return;
+    }
+    // Something is transmitting here: listen for a message, until the symbol timeout
+    modeWillChange(RHModeRx);
+    spiWrite(RH_RF95_REG_40_DIO_MAPPING1, 0x00 | _hopDioMapping); // Interrupt on RxDone
+    spiWrite(RH_RF95_REG_01_OP_MODE, RH_RF95_MODE_RXSINGLE);
+    _mode = RHModeRx;
+}
+
+bool RH_RF95::setHopTable(const float* frequencies, uint8_t len)
+{
+    if (len == 0 || len > RH_RF95_MAX_HOP_CHANNELS || _scanning)
+	return false;
+    // The radio cannot hop between its LF and HF ports
+    bool hf = (frequencies[0] >= 779.0);
+    for (uint8_t i = 1; i < len; i++)
+	if ((frequencies[i] >= 779.0) != hf)
+	    return false;
+    for (uint8_t i = 0; i < len; i++)
+    {
+	// Frf = FRF / FSTEP
+	uint32_t frf = (frequencies[i] * 1000000.0) / RH_RF95_FSTEP;
+	_hopTable[i][0] = (frf >> 16) & 0xff;
+	_hopTable[i][1] = (frf >> 8) & 0xff;
+	_hopTable[i][2] = frf & 0xff;
+    }
+    _numHopChannels = len;
+    _usingHFport = hf;
+    hopReset();
+    return true;
+}
+
+bool RH_RF95::setHopPeriod(uint8_t symbols)
+{
+    if (symbols && _scanning)
+	return false;
+    _hopPeriod = symbols;
+    spiWrite(RH_RF95_REG_24_HOP_PERIOD, symbols);
+    hopReset();
+    return true;
+}
+
+uint8_t RH_RF95::setHopDwellTime(uint16_t ms)
+{
+    uint8_t sf = spiRead(RH_RF95_REG_1E_MODEM_CONFIG2) >> 4;
+    uint8_t bwindex = spiRead(RH_RF95_REG_1D_MODEM_CONFIG1) >> 4;
+    if (bwindex >= (sizeof(BANDWIDTH_TABLE) / sizeof(float)))
+	return 0;
+    float bw;
+    memcpy_P(&bw, &BANDWIDTH_TABLE[bwindex], sizeof(float));
+
+    // Symbol time is 2^SF / BW
+    float symbols = (float)ms * bw / (1000.0 * (1UL << sf));
+    uint8_t period = symbols >= 255 ? 255 : (symbols < 1 ? 1 : (uint8_t)symbols);
+    return setHopPeriod(period) ? period : 0;
+}
+
+bool RH_RF95::setHopInterruptPin(uint8_t pin, uint8_t dio)
+{
+#ifndef RH_RF95_IRQLESS
+    if (_myInterruptIndex == 0xff)
+	return false; // init() has not allocated our interrupt glue yet
+    int interruptNumber = digitalPinToInterrupt(pin);
+    if (interruptNumber == NOT_AN_INTERRUPT)
+	return false;
+#ifdef RH_ATTACHINTERRUPT_TAKES_PIN_NUMBER
+    interruptNumber = pin;
+#endif
+    spiUsingInterrupt(interruptNumber);
+    pinMode(pin, INPUT);
+
+    // FhssChangeChannel is mapping 01 on DIO1 (bits 5..4), and 00 on DIO2 (bits 3..2)
+    _hopDioMapping = (dio == 1) ? 0x10 : 0x00;
+    spiWrite(RH_RF95_REG_40_DIO_MAPPING1, (spiRead(RH_RF95_REG_40_DIO_MAPPING1) & 0xc0) | _hopDioMapping);
+
+    // The same handler services all the radio's interrupts
+    if (_myInterruptIndex == 0)
+	attachInterrupt(interruptNumber, isr0, RISING);
+    else if (_myInterruptIndex == 1)
+	attachInterrupt(interruptNumber, isr1, RISING);
+    else
+	attachInterrupt(interruptNumber, isr2, RISING);
+    _hopInterrupt = true;
+    return true;
+#else
+    (void)pin;
+    (void)dio;
+    return false;
+#endif
+}
+
+void RH_RF95::handleHop()
+{
+    if (!hopping())
+	return;
+    // The radio counts the hops, we supply the frequency for each
+    uint8_t channel = (spiRead(RH_RF95_REG_1C_HOP_CHANNEL) & RH_RF95_FHSS_PRESENT_CHANNEL) % _numHopChannels;
+    spiBurstWrite(RH_RF95_REG_06_FRF_MSB, _hopTable[channel], 3);
+    spiWrite(RH_RF95_REG_12_IRQ_FLAGS, RH_RF95_FHSS_CHANGE_CHANNEL);
+}
+
+void RH_RF95::pollHop()
+{
+    if (hopping() && !_hopInterrupt && (spiRead(RH_RF95_REG_12_IRQ_FLAGS) & RH_RF95_FHSS_CHANGE_CHANNEL))
+	handleHop();
+}
+
+void RH_RF95::hopReset()
+{
+    if (hopping())
+	spiBurstWrite(RH_RF95_REG_06_FRF_MSB, _hopTable[0], 3);
+}
@@ -54,6 +54,33 @@
 // The Frequency Synthesizer step = RH_RF95_FXOSC / 2^^19
 #define RH_RF95_FSTEP  (RH_RF95_FXOSC / 524288)
 
+// The time in milliseconds over which transmitter duty cycle limits are measured.
+// ETSI EN 300 220 uses 1 hour
+#ifndef RH_RF95_DUTY_CYCLE_WINDOW
+ #define RH_RF95_DUTY_CYCLE_WINDOW 3600000UL
+#endif
+
+// The maximum number of frequency sub-bands with their own duty cycle limits
+#ifndef RH_RF95_NUM_DUTY_CYCLE_BANDS
+ #define RH_RF95_NUM_DUTY_CYCLE_BANDS 5
+#endif
+
+// The maximum number of channels in the receive scan list
+#ifndef RH_RF95_MAX_SCAN_CHANNELS
+ #define RH_RF95_MAX_SCAN_CHANNELS 8
+#endif
+
+// The maximum number of frequencies in the frequency hopping table
+#ifndef RH_RF95_MAX_HOP_CHANNELS
+ #define RH_RF95_MAX_HOP_CHANNELS 16
+#endif
+
+// How many symbols the receiver waits for a preamble after CAD detects activity on a scanned channel,
+// before moving on to the next channel
+#ifndef RH_RF95_SCAN_SYMBOL_TIMEOUT
+ #define RH_RF95_SCAN_SYMBOL_TIMEOUT 16
+#endif
+
 
 // Register names (LoRa Mode, from table 85)
 #define RH_RF95_REG_00_FIFO                                0x00
@@ -254,6 +281,34 @@
 #define RH_RF95_PA_DAC_DISABLE                        0x04
 #define RH_RF95_PA_DAC_ENABLE                         0x07
 
+// Modem configuration generator, see "Custom modem configurations" below.
+// RH_RF95_BW_BITS gives the RH_RF95_REG_1D_MODEM_CONFIG1 bandwidth bits for a bandwidth in Hz, or 0xff if it is not one
+// the radio supports
+#define RH_RF95_BW_BITS(bw) \
+    ((bw) ==   7800 ? RH_RF95_BW_7_8KHZ   : (bw) ==  10400 ? RH_RF95_BW_10_4KHZ : \
+     (bw) ==  15600 ? RH_RF95_BW_15_6KHZ  : (bw) ==  20800 ? RH_RF95_BW_20_8KHZ : \
+     (bw) ==  31250 ? RH_RF95_BW_31_25KHZ : (bw) ==  41700 ? RH_RF95_BW_41_7KHZ : \
+     (bw) ==  62500 ? RH_RF95_BW_62_5KHZ  : (bw) == 125000 ? RH_RF95_BW_125KHZ  : \
+     (bw) == 250000 ? RH_RF95_BW_250KHZ   : (bw) == 500000 ? RH_RF95_BW_500KHZ  : 0xff)
+
+// True if a LoRa symbol is longer than 16ms, when the datasheet requires low data rate optimisation
+#define RH_RF95_NEEDS_LDRO(bw, sf) ((1UL << (sf)) * 1000UL > 16UL * (bw))
+
+// Initialiser for an RH_RF95::ModemConfig, from the bandwidth in Hz, coding rate denominator (5 to 8),
+// spreading factor (7 to 12), CRC (true or false) and low data rate optimisation (true or false), with AGC on.
+// Invalid values fail to compile.
+#define RH_RF95_MODEM_CONFIG_LDRO(bw, cr, sf, crc, ldro) \
+    { (uint8_t)((RH_RF95_BW_BITS(bw) | (((cr) - 4) << 1)) \
+		+ RH_CONFIG_CHECK(RH_RF95_BW_BITS(bw) != 0xff) \
+		+ RH_CONFIG_CHECK((cr) >= 5 && (cr) <= 8)), \
+      (uint8_t)((((sf) << 4) | ((crc) ? RH_RF95_PAYLOAD_CRC_ON : 0)) \
+		+ RH_CONFIG_CHECK((sf) >= 7 && (sf) <= 12)), \
+      (uint8_t)(RH_RF95_AGC_AUTO_ON | ((ldro) ? RH_RF95_LOW_DATA_RATE_OPTIMIZE : 0)) }
+
+// As RH_RF95_MODEM_CONFIG_LDRO, with low data rate optimisation when the symbol time exceeds 16ms
+#define RH_RF95_MODEM_CONFIG(bw, cr, sf, crc) \
+    RH_RF95_MODEM_CONFIG_LDRO(bw, cr, sf, crc, RH_RF95_NEEDS_LDRO(bw, sf))
+
 
 /////////////////////////////////////////////////////////////////////
 /// \class RH_RF95 RH_RF95.h <RH_RF95.h>
@@ -518,6 +573,103 @@
 /// Also https://lowpowerlab.com/forum/rf-range-antennas-rfm69-library/lora-library-experiences-range/15/
 /// and http://www.semtech.com/images/datasheet/an120014-xo-guidance-lora-modulation.pdf
 ///
+/// \par Airtime and duty cycle
+///
+/// airtime() calculates the exact time on air of a message with the current modem configuration,
+/// from the formula in the Semtech SX1276 datasheet, taking into account the spreading factor, bandwidth,
+/// coding rate, preamble length, CRC, header mode and low data rate optimisation. The static versions
+/// calculate it for any ModemConfigChoice or ModemConfig, so you can plan transmissions before choosing a
+/// configuration. For example, with the default Bw125Cr45Sf128 and an 8 symbol preamble,
+/// a 10 octet message takes 46336 microseconds.
+///
+/// In many regions the transmitter duty cycle is limited by law. You can describe the sub-bands and their
+/// limits with setDutyCycleBand() (or setDutyCycleBandsEU868() for the ETSI EN 300 220 sub-bands used in Europe).
+/// RH_RF95 then keeps a budget of transmit time for each sub-band, which fills at the permitted duty cycle up to
+/// the amount permitted in RH_RF95_DUTY_CYCLE_WINDOW milliseconds (1 hour by default).
+/// send() charges the airtime of each message against the sub-band of the current frequency,
+/// and returns false without transmitting if the budget does not cover it.
+/// dutyCycleBudget() tells you how much transmit time is left, and dutyCycleWait() how long until a message
+/// of a given length can be sent, so your application can schedule its transmissions within the limits
+/// instead of finding out by failure:
+/// \code
+/// driver.setFrequency(868.1);
+/// driver.setDutyCycleBandsEU868();
+/// ...
+/// unsigned long wait = driver.dutyCycleWait(len);
+/// if (wait == 0)
+///     driver.send(data, len);
+/// else
+///     ; // Do something else for wait milliseconds
+/// \endcode
+/// Frequencies outside all the configured sub-bands are not limited. Budgets start full after init().
+///
+/// \par Channel scanning
+///
+/// The radio can only receive on one frequency, spreading factor and bandwidth at a time.
+/// To cover several, add them with addScanChannel() and call startScan(). The radio then hops from
+/// channel to channel, doing Channel Activity Detection (CAD) on each, which takes about 2 symbols.
+/// It only stops to receive when CAD detects a LoRa preamble. If no message starts within RH_RF95_SCAN_SYMBOL_TIMEOUT
+/// symbols, or the message is not for this node, it moves on. The hopping is done by the interrupt handler,
+/// so it continues while your program is doing other things. available() and recv() work as usual,
+/// and scanChannel() tells you which channel the last message was received on. Transmitters must send preambles
+/// long enough for the whole scan list to be visited (see setPreambleLength()). For example, 4 channels at SF7 and
+/// 125kHz take about 4ms to visit, so a preamble of 8 symbols (8ms) is enough.
+/// \code
+/// driver.addScanChannel(868.1, 7, 125000);
+/// driver.addScanChannel(868.3, 7, 125000);
+/// driver.addScanChannel(868.5, 9, 125000);
+/// driver.startScan();
+/// ...
+/// if (driver.recv(buf, &len))
+///     driver.send(reply, replyLen); // On the channel the message was received on
+/// \endcode
+/// Scanning pauses while you send() (so replies go out on the channel of the message just received) or change
+/// mode, and resumes at the next call to available() or recv(). stopScan() returns the radio to the frequency
+/// and modem configuration it had when startScan() was called. The RX timeout is not routed to the interrupt pin,
+/// so you must call available() often to move on after a false detection.
+///
+/// \par Frequency hopping
+///
+/// The radio can change frequency every few symbols during each message (Frequency Hopping Spread Spectrum, FHSS),
+/// so long messages at slow spreading factors can stay within dwell time limits, such as the 400ms per channel
+/// allowed by the FCC in the US 902-928MHz band. Give the frequencies to hop through
+/// with setHopTable(), then set the number of symbols between hops with setHopPeriod()
+/// (or setHopDwellTime() to have it calculated). Every message then starts on the first frequency in the table,
+/// and moves to the next one each hop period. Transmitter and receiver must use the same table and period.
+/// \code
+/// float channels[] = { 902.3, 904.7, 907.1, 909.5, 911.9, 914.3, 916.7, 919.1 };
+/// driver.setHopTable(channels, 8);
+/// driver.setHopDwellTime(400);
+/// \endcode
+/// The radio asks for the next frequency with its FhssChangeChannel interrupt, which is only available on its
+/// DIO1 or DIO2 pins. If you connect one of them to another interrupt capable pin and call setHopInterruptPin(),
+/// hops are serviced by the interrupt handler. Otherwise they are serviced by waitPacketSent() while transmitting
+/// and by available() while receiving, so you must call available() often (at least once per hop period) while
+/// a message may be arriving. Hopping and channel scanning cannot be used together: startScan() fails while
+/// hopping() is true, and setHopTable(), setHopPeriod() and setHopDwellTime() fail while scanning().
+///
+/// \par Custom modem configurations
+///
+/// If none of the ModemConfigChoice configurations suit, the RH_RF95_MODEM_CONFIG macro calculates
+/// the register values of a ModemConfig from the bandwidth in Hz, the coding rate denominator, the spreading factor
+/// and whether CRCs are used. It is evaluated by the compiler, so the table costs no more than raw register values,
+/// and bandwidths, coding rates and spreading factors the radio does not support fail to compile.
+/// Low data rate optimisation is enabled when the symbol time exceeds 16ms, as the datasheet requires.
+/// SF6 is not supported, since it needs implicit header mode. Eg:
+/// \code
+/// static const RH_RF95::ModemConfig fastConfig = RH_RF95_MODEM_CONFIG(250000, 5, 7, true);
+/// driver.setModemRegisters(&fastConfig);
+/// \endcode
+/// setModemRegisters() writes RH_RF95_REG_1D_MODEM_CONFIG1 and RH_RF95_REG_1E_MODEM_CONFIG2 in a single
+/// SPI burst, so changing configuration is quick.
+///
+/// Caution: the canned Bw31_25Cr48Sf512 and Bw125Cr45Sf2048 configurations have symbol times of 16.4ms,
+/// but leave low data rate optimisation off, and are kept that way for compatibility with existing nodes.
+/// Both ends must agree on it, so RH_RF95_MODEM_CONFIG(31250, 8, 9, true) and RH_RF95_MODEM_CONFIG(125000, 5, 11, true)
+/// do not interoperate with them. To match them, use RH_RF95_MODEM_CONFIG_LDRO(), which takes low data rate
+/// optimisation explicitly. tools/modemConfigCheck checks at compile time that the generators reproduce
+/// every canned configuration.
+///
 /// \par Transmitter Power
 ///
 /// You can control the transmitter power on the RF transceiver
@@ -615,9 +767,9 @@ public:
     {
 	Bw125Cr45Sf128 = 0,	   ///< Bw = 125 kHz, Cr = 4/5, Sf = 128chips/symbol, CRC on. Default medium range
 	Bw500Cr45Sf128,	           ///< Bw = 500 kHz, Cr = 4/5, Sf = 128chips/symbol, CRC on. Fast+short range
-	Bw31_25Cr48Sf512,	   ///< Bw = 31.25 kHz, Cr = 4/8, Sf = 512chips/symbol, CRC on. Slow+long range
+	Bw31_25Cr48Sf512,	   ///< Bw = 31.25 kHz, Cr = 4/8, Sf = 512chips/symbol, CRC on, low data rate optimisation off. Slow+long range
 	Bw125Cr48Sf4096,           ///< Bw = 125 kHz, Cr = 4/8, Sf = 4096chips/symbol, low data rate, CRC on. Slow+long range
-	Bw125Cr45Sf2048,           ///< Bw = 125 kHz, Cr = 4/5, Sf = 2048chips/symbol, CRC on. Slow+long range
+	Bw125Cr45Sf2048,           ///< Bw = 125 kHz, Cr = 4/5, Sf = 2048chips/symbol, CRC on, low data rate optimisation off. Slow+long range
     } ModemConfigChoice;
 
     /// Constructor. You can have multiple instances, but each instance must have its own
@@ -698,11 +850,15 @@ public:
     virtual bool    send(const uint8_t* data, uint8_t len);
 
     /// Blocks until the current message (if any)
-    /// has been transmitted
+    /// has been transmitted. Services frequency hopping while waiting, if there is no hop interrupt pin.
     /// \return true on success, false if the chip is not in transmit mode or other transmit failure
-#ifdef RH_RF95_IRQLESS
     virtual bool   waitPacketSent();
-#endif
+
+    /// Blocks until the current message (if any) has been transmitted, or the timeout expires.
+    /// Services frequency hopping while waiting, if there is no hop interrupt pin.
+    /// \param[in] timeout Maximum time to wait in milliseconds
+    /// \return true if the message was transmitted, false if the timeout expired
+    virtual bool   waitPacketSent(uint16_t timeout);
 
     /// Sets the length of the preamble
     /// in bytes.
@@ -814,6 +970,11 @@ public:
     /// \return nothing
     void     setSpreadingFactor(uint8_t sf);
 
+    /// Returns the current spreading factor, as set by setSpreadingFactor(), setModemConfig()
+    /// or setModemRegisters().
+    /// \return The spreading factor, 6 to 12
+    uint8_t  spreadingFactor();
+
     /// brian.n.norman@gmail.com 9th Nov 2018
     /// Sets the radio signal bandwidth
     /// sbw ranges and resultant settings are as follows:-
@@ -860,6 +1021,115 @@ public:
     /// \param[in] on bool, true enables CRCs in incoming and outgoing packets, false disables them
      void setPayloadCRC(bool on);
 
+    /// Calculates the time on air of a message with the current modem configuration
+    /// and preamble length, using the formula in the Semtech SX1276 datasheet.
+    /// \param[in] len The length of the message in octets, as would be passed to send()
+    /// (the RadioHead headers are added)
+    /// \return The time on air in microseconds
+    uint32_t airtime(uint8_t len);
+
+    /// Calculates the time on air of a message with one of the canned modem configurations.
+    /// \param[in] index The configuration choice
+    /// \param[in] len The length of the message in octets, as would be passed to send()
+    /// \param[in] preambleLength The preamble length in symbols, as passed to setPreambleLength()
+    /// \return The time on air in microseconds, or 0 if index is not a valid choice
+    static uint32_t airtime(ModemConfigChoice index, uint8_t len, uint16_t preambleLength = 8);
+
+    /// Calculates the time on air of a message with any modem configuration.
+    /// \param[in] config The modem configuration register values, as passed to setModemRegisters()
+    /// \param[in] len The length of the message in octets, as would be passed to send()
+    /// \param[in] preambleLength The preamble length in symbols, as passed to setPreambleLength()
+    /// \return The time on air in microseconds, or 0 if the configuration is not valid
+    static uint32_t airtime(const ModemConfig* config, uint8_t len, uint16_t preambleLength = 8);
+
+    /// Sets the transmitter duty cycle limit for a frequency sub-band.
+    /// Thereafter send() will not transmit on frequencies in the sub-band if the limit would be exceeded.
+    /// If the sub-band has already been set, its limit is changed. The budget of a new sub-band starts full.
+    /// \param[in] minFreq The lowest frequency in the sub-band in MHz
+    /// \param[in] maxFreq The highest frequency in the sub-band in MHz
+    /// \param[in] dutyCycle The permitted duty cycle in tenths of a percent (ie 10 is 1%)
+    /// \return true if successful, false if there are already RH_RF95_NUM_DUTY_CYCLE_BANDS sub-bands
+    bool     setDutyCycleBand(float minFreq, float maxFreq, uint16_t dutyCycle);
+
+    /// Sets the duty cycle limits for the ETSI EN 300 220 sub-bands in 863 to 870 MHz,
+    /// as used by LoRaWAN in Europe: 1% in 863.0-868.0 and 868.0-868.6,
+    /// 0.1% in 868.7-869.2, 10% in 869.4-869.65 and 1% in 869.7-870.0
+    /// Replaces any sub-bands previously set.
+    void     setDutyCycleBandsEU868();
+
+    /// Removes all duty cycle limits
+    void     clearDutyCycleBands();
+
+    /// Sets the frequencies to hop through when frequency hopping is enabled by setHopPeriod().
+    /// Every message starts on the first one, instead of the frequency set by setFrequency().
+    /// \param[in] frequencies Array of frequencies in MHz. They must all be below 779.0MHz (the radio's LF port)
+    /// or all at or above it (the HF port).
+    /// \param[in] len Number of frequencies, 1 to RH_RF95_MAX_HOP_CHANNELS
+    /// \return true if successful, false if len is out of range, the frequencies use both ports, or scanning()
+    bool     setHopTable(const float* frequencies, uint8_t len);
+
+    /// Enables or disables frequency hopping.
+    /// \param[in] symbols The number of symbols between hops, or 0 to disable hopping. Has no effect
+    /// unless setHopTable() has been called.
+    /// \return true if successful, false if hopping would be enabled while scanning()
+    bool     setHopPeriod(uint8_t symbols);
+
+    /// Enables frequency hopping with the longest hop period that keeps each hop within a dwell time,
+    /// at the current spreading factor and bandwidth. Call after configuring the modem.
+    /// \param[in] ms The maximum time in milliseconds on each frequency
+    /// \return The hop period set, in symbols, or 0 if it could not be set
+    uint8_t  setHopDwellTime(uint16_t ms);
+
+    /// Tells whether frequency hopping is enabled.
+    /// \return true if there is a hop table and a hop period
+    bool     hopping() { return _numHopChannels && _hopPeriod; }
+
+    /// Sets up an interrupt for the FhssChangeChannel signal from the radio, so hops are serviced
+    /// by the interrupt handler. Call after init(). Not available with RH_RF95_IRQLESS.
+    /// \param[in] pin The interrupt capable pin connected to the radio's DIO1 or DIO2 pin
+    /// \param[in] dio The radio pin it is connected to, 1 or 2. Defaults to 1.
+    /// \return true if successful
+    bool     setHopInterruptPin(uint8_t pin, uint8_t dio = 1);
+
+    /// Adds a channel to the receive scan list. The coding rate, CRC and header mode are the same for all channels.
+    /// Takes effect at the next call to startScan().
+    /// \param[in] centre Frequency in MHz
+    /// \param[in] sf Spreading factor, 7 to 12
+    /// \param[in] bandwidth Signal bandwidth in Hz, as for setSignalBandwidth(). Defaults to 125000.
+    /// \return true if successful, false if there are already RH_RF95_MAX_SCAN_CHANNELS channels
+    bool     addScanChannel(float centre, uint8_t sf, long bandwidth = 125000);
+
+    /// Removes all the channels from the receive scan list. Stops scanning.
+    void     clearScanChannels();
+
+    /// Starts receiving on all the channels in the scan list, hopping between them with CAD.
+    /// \return true if scanning started, false if there are no channels in the scan list, or if hopping()
+    bool     startScan();
+
+    /// Stops scanning, and restores the frequency and modem configuration from when startScan() was called.
+    /// Leaves the radio idle.
+    void     stopScan();
+
+    /// Tells whether startScan() has been called, without stopScan()
+    /// \return true if scanning
+    bool     scanning() { return _scanning; }
+
+    /// Returns the channel the last message was received on while scanning.
+    /// \return The index of the channel in the scan list, in the order they were added
+    uint8_t  scanChannel() { return _rxScanChannel; }
+
+    /// Returns the transmit time remaining in the duty cycle budget for the current frequency.
+    /// \return The remaining transmit time in microseconds, or 0xffffffff if the current frequency
+    /// is not in any sub-band set with setDutyCycleBand()
+    uint32_t dutyCycleBudget();
+
+    /// Returns how long until a message can be sent within the duty cycle limit for the current
+    /// frequency and modem configuration.
+    /// \param[in] len The length of the message in octets, as would be passed to send()
+    /// \return The time to wait in milliseconds, 0 if the message can be sent now, or 0xffffffff if
+    /// the message is too long to ever be sent within the limit
+    unsigned long dutyCycleWait(uint8_t len);
+
 protected:
     /// This is a low level function to handle the interrupts for one instance of RH_RF95.
     /// Called automatically by isr*()
@@ -874,6 +1144,24 @@ protected:
     /// Clear our local receive buffer
     void clearRxBuf();
 
+    /// Tunes to the next frequency in the hop table. Called when the radio signals FhssChangeChannel.
+    void           handleHop();
+
+    /// Services frequency hopping, if enabled and there is no hop interrupt pin.
+    void           pollHop();
+
+    /// Tunes to the first frequency in the hop table, ready for the next message, if hopping is enabled.
+    void           hopReset();
+
+    /// Tunes to the next channel in the scan list and starts CAD on it.
+    /// Called by the interrupt handler and available() while scanning.
+    void           scanNext();
+
+    /// Starts receiving on the current scan channel if CAD detected activity there,
+    /// else moves to the next one.
+    /// \param[in] detected true if CAD detected activity
+    void           scanCadDone(bool detected);
+
     /// Called by RH_RF95 when the radio mode is about to change to a new setting.
     /// Can be used by subclasses to implement antenna switching etc.
     /// \param[in] mode RHMode the new mode about to take effect
@@ -929,6 +1217,83 @@ private:
     /// If true, sends CRCs in every packet and requires a valid CRC in every received packet
     bool                _enableCRC;
 
+    /// \brief Transmit time accounting for a frequency sub-band with a duty cycle limit
+    typedef struct
+    {
+	uint32_t      minFreq;    ///< Lowest frequency in kHz
+	uint32_t      maxFreq;    ///< Highest frequency in kHz
+	uint16_t      dutyCycle;  ///< Permitted duty cycle in tenths of a percent
+	uint32_t      budget;     ///< Transmit time available in microseconds
+	unsigned long lastUpdate; ///< millis() when budget was last updated
+    } DutyCycleBand;
+
+    /// Finds the duty cycle sub-band containing the current frequency and brings its budget up to date.
+    /// \return The sub-band, or NULL if the current frequency is not limited
+    DutyCycleBand*      dutyCycleBand();
+
+    /// Current frequency in kHz
+    uint32_t            _frequency;
+
+    /// Sub-bands with duty cycle limits
+    DutyCycleBand       _dutyCycleBands[RH_RF95_NUM_DUTY_CYCLE_BANDS];
+
+    /// Number of sub-bands in _dutyCycleBands
+    uint8_t             _numDutyCycleBands;
+
+    /// Values for RH_RF95_REG_06_FRF_MSB to RH_RF95_REG_08_FRF_LSB for each frequency in the hop table
+    uint8_t             _hopTable[RH_RF95_MAX_HOP_CHANNELS][3];
+
+    /// Number of frequencies in _hopTable
+    uint8_t             _numHopChannels;
+
+    /// Symbols between hops, 0 if hopping is disabled
+    uint8_t             _hopPeriod;
+
+    /// True if FhssChangeChannel is connected to an interrupt
+    bool                _hopInterrupt;
+
+    /// Bits to add to RH_RF95_REG_40_DIO_MAPPING1 to route FhssChangeChannel to the hop interrupt pin
+    uint8_t             _hopDioMapping;
+
+    /// \brief Register values for a channel in the receive scan list
+    typedef struct
+    {
+	uint32_t      freq;       ///< Frequency in kHz
+	uint8_t       frf[3];     ///< Values for RH_RF95_REG_06_FRF_MSB to RH_RF95_REG_08_FRF_LSB
+	uint8_t       reg_1d;     ///< Value for register RH_RF95_REG_1D_MODEM_CONFIG1
+	uint8_t       reg_1e;     ///< Value for register RH_RF95_REG_1E_MODEM_CONFIG2
+	uint8_t       reg_26;     ///< Value for register RH_RF95_REG_26_MODEM_CONFIG3
+    } ScanChannel;
+
+    /// Sets the frequency and modem registers for a channel
+    /// \param[in] channel The channel
+    void                setScanChannelRegisters(const ScanChannel* channel);
+
+    /// The receive scan list. Until startScan(), only the bandwidth, spreading factor and
+    /// low data rate bits of the registers are set
+    ScanChannel         _scanChannels[RH_RF95_MAX_SCAN_CHANNELS];
+
+    /// Number of channels in _scanChannels
+    uint8_t             _numScanChannels;
+
+    /// The frequency and modem configuration to restore when scanning stops
+    ScanChannel         _scanHome;
+
+    /// The symbol timeout to restore when scanning stops
+    uint8_t             _scanHomeSymbTimeout;
+
+    /// The index in _scanChannels of the channel the radio is tuned to
+    volatile uint8_t    _scanIndex;
+
+    /// The index in _scanChannels of the channel the last message was received on
+    volatile uint8_t    _rxScanChannel;
+
+    /// True between startScan() and stopScan()
+    bool                _scanning;
+
+    /// True while the scanner is using the radio, ie the current CAD or RX was started by scanNext()
+    volatile bool       _scanBusy;
+
 };
 
 /// @example rf95_client.pde
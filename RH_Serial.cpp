@@ -38,8 +38,22 @@ bool RH_Serial::init()
 // Call this often
 bool RH_Serial::available()
 {
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    // Parse straight out of the HardwareSerial receive buffer, which is filled in bulk.
+    // Stop at the end of a valid frame so any following frame stays buffered
+    const uint8_t* data;
+    int count;
+    while (!_rxBufValid && (count = _serial.readBuffer(&data)) > 0)
+    {
+	int i = 0;
+	while (!_rxBufValid && i < count)
+	    handleRx(data[i++]);
+	_serial.consume(i);
+    }
+#else
     while (!_rxBufValid &&_serial.available())
 	handleRx(_serial.read());
+#endif
     return _rxBufValid;
 }
 
@@ -59,8 +73,11 @@ bool RH_Serial::waitAvailableTimeout(uint16_t timeout)
 #if (RH_PLATFORM == RH_PLATFORM_UNIX)
     // Unix version driver in RHutil/HardwareSerial knows how to wait without polling
     unsigned long starttime = millis();
+    if (available())
+	return true;
     while ((millis() - starttime) < timeout)
     {
+	// Sleeps in poll() until more characters arrive
 	_serial.waitAvailableTimeout(timeout - (millis() - starttime));
         if (available())
            return true;
@@ -210,9 +227,12 @@ bool RH_Serial::send(const uint8_t* data, uint8_t len)
     if (!waitCAD()) 
 	return false;  // Check channel activity
 
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    _txBufLen = 0;
+#endif
     _txFcs = 0xffff;    // Initial value
-    _serial.write(DLE); // Not in FCS
-    _serial.write(STX); // Not in FCS
+    txRaw(DLE); // Not in FCS
+    txRaw(STX); // Not in FCS
     // First the 4 headers
     txData(_txHeaderTo);
     txData(_txHeaderFrom);
@@ -222,25 +242,38 @@ bool RH_Serial::send(const uint8_t* data, uint8_t len)
     while (len--)
 	txData(*data++);
     // End of message
-    _serial.write(DLE);
+    txRaw(DLE);
     _txFcs = RHcrc_ccitt_update(_txFcs, DLE);
-    _serial.write(ETX);
+    txRaw(ETX);
     _txFcs = RHcrc_ccitt_update(_txFcs, ETX);
 
     // Now send the calculated FCS for this message
-    _serial.write((_txFcs >> 8) & 0xff);
-    _serial.write(_txFcs & 0xff);
+    txRaw((_txFcs >> 8) & 0xff);
+    txRaw(_txFcs & 0xff);
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    // The whole frame in one system call
+    _serial.write(_txBuf, _txBufLen);
+#endif
     return true;
 }
 
 void  RH_Serial::txData(uint8_t ch)
 {
     if (ch == DLE)    // DLE stuffing required?
-	_serial.write(DLE); // Not in FCS
-    _serial.write(ch);
+	txRaw(DLE); // Not in FCS
+    txRaw(ch);
     _txFcs = RHcrc_ccitt_update(_txFcs, ch);
 }
 
+void  RH_Serial::txRaw(uint8_t ch)
+{
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    _txBuf[_txBufLen++] = ch;
+#else
+    _serial.write(ch);
+#endif
+}
+
 uint8_t RH_Serial::maxMessageLength()
 {
     return RH_SERIAL_MAX_MESSAGE_LEN;
@@ -33,6 +33,9 @@
 #define RH_SERIAL_MAX_MESSAGE_LEN (RH_SERIAL_MAX_PAYLOAD_LEN - RH_SERIAL_HEADER_LEN)
 #endif
 
+// The longest possible transmitted frame: DLE STX, every payload octet DLE stuffed, DLE ETX and the FCS
+#define RH_SERIAL_MAX_FRAME_LEN (2 + (RH_SERIAL_MAX_PAYLOAD_LEN * 2) + 2 + 2)
+
 #if (RH_PLATFORM == RH_PLATFORM_STM32F2)
  #define HardwareSerial USARTSerial
 #elif (RH_PLATFORM == RH_PLATFORM_ARDUINO) && defined(ARDUINO_attinyxy6)
@@ -144,7 +147,21 @@ class HardwareSerial;
 /// RH_HARDWARESERIAL_DEVICE_NAME=/dev/ttyUSB0 ./serial_reliable_datagram_client 
 /// \endcode
 /// You should see the 2 programs passing messages to each other.
-/// 
+///
+/// \par Performance on Linux and OSX
+///
+/// On Linux and OSX, RH_Serial parses received frames directly from the receive buffer inside
+/// RHutil/HardwareSerial, which is filled with one read() system call for however many characters
+/// have arrived, and each frame is sent with a single write() system call. waitAvailableTimeout() sleeps
+/// in poll() until characters arrive. This keeps the CPU load low even at high baud rates such as
+/// 1Mbaud RS485. To wait for this and other drivers in the same poll() or epoll() loop, add
+/// serial().fd() to your loop, and call available() whenever it becomes readable:
+/// \code
+/// struct pollfd fds[2] = {{ driver.serial().fd(), POLLIN, 0 }, { otherFd, POLLIN, 0 }};
+/// while (!driver.available())
+///     poll(fds, 2, -1); // and handle otherFd as required
+/// \endcode
+///
 class RH_Serial : public RHGenericDriver
 {
 public:
@@ -256,6 +273,18 @@ protected:
 
     /// FCS for transmitted data
     uint16_t        _txFcs;
+
+    /// Sends a single octet to the serial port, without DLE stuffing or FCS.
+    /// On Unix and OSX the frame is assembled in _txBuf and sent with one write() by send()
+    void  txRaw(uint8_t ch);
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    /// The frame being assembled for transmission
+    uint8_t         _txBuf[RH_SERIAL_MAX_FRAME_LEN];
+
+    /// Number of octets in _txBuf
+    uint8_t         _txBufLen;
+#endif
 };
 
 /// @example serial_reliable_datagram_client.pde
@@ -16,31 +16,60 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netdb.h>
+#include <time.h>
+#include <sys/time.h>
 #include <string>
 
+// Monotonic time in microseconds
+static uint64_t monotonicMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 RH_TCP::RH_TCP(const char* server)
     : _server(server),
-      _rxBufLen(0),
-      _rxBufValid(false),
-      _socket(-1)
+      _socket(-1),
+      _socketBufHead(0),
+      _socketBufLen(0),
+      _rxQueueHead(0),
+      _rxQueueLen(0),
+      _bitRate(RH_TCP_DEFAULT_BIT_RATE),
+      _preambleLen(0),
+      _txDoneTime(0),
+      _protocolVersion(RH_TCP_PROTOCOL_VERSION_1),
+      _frequency(0),
+      _spreadingFactor(0),
+      _lastSNR(0),
+      _lastTxTime(0),
+      _datagram(false)
 {
+    // Override server from environment
+    char* e = getenv("RH_TCP_SERVER");
+    if (e)
+	_server = e;
 }
     
 bool RH_TCP::init()
 {   
+    closeConnection(); // In case we are reconnecting
     if (!connectToServer())
 	return false;
-    return sendThisAddress(_thisAddress);
+    _mode = RHModeIdle;
+    // Use version 1 until the server tells us it knows better
+    _protocolVersion = RH_TCP_PROTOCOL_VERSION_1;
+    return sendVersion() && sendThisAddress(_thisAddress);
 }
     
 bool RH_TCP::connectToServer()
 {
     struct addrinfo hints;
     struct addrinfo *result, *rp;
-    int sfd, s;
-    struct sockaddr_storage peer_addr;
-    socklen_t peer_addr_len;
+    int s;
 
     memset(&hints, 0, sizeof(struct addrinfo));
     hints.ai_family = AF_UNSPEC;    // Allow IPv4 or IPv6
@@ -52,45 +81,62 @@ bool RH_TCP::connectToServer()
     hints.ai_next = NULL;
     
     std::string server(_server);
-    std::string port("4000");
-    size_t indexOfSeparator = server.find_first_of(':');
-    if (indexOfSeparator != std::string::npos)
+    _datagram = false;
+    if (server.compare(0, 5, "unix:") == 0)
     {
-	port = server.substr(indexOfSeparator+1);
-	server.erase(indexOfSeparator);
+	_datagram = true;
+	if (!connectToUnixServer(server.c_str() + 5))
+	    return false;
     }
-
-    s = getaddrinfo(server.c_str(), port.c_str(), &hints, &result);
-    if (s != 0) 
+    else
     {
-	fprintf(stderr, "RH_TCP::connect getaddrinfo failed: %s\n", gai_strerror(s));
-	return false;
-    }
+	if (server.compare(0, 4, "udp:") == 0)
+	{
+	    _datagram = true;
+	    hints.ai_socktype = SOCK_DGRAM;
+	    server.erase(0, 4);
+	}
+	std::string port("4000");
+	size_t indexOfSeparator = server.find_first_of(':');
+	if (indexOfSeparator != std::string::npos)
+	{
+	    port = server.substr(indexOfSeparator+1);
+	    server.erase(indexOfSeparator);
+	}
 
-    // getaddrinfo() returns a list of address structures.
-    // Try each address until we successfully connect(2).
-    // If socket(2) (or connect(2)) fails, we (close the socket
-    // and) try the next address. */
+	s = getaddrinfo(server.c_str(), port.c_str(), &hints, &result);
+	if (s != 0) 
+	{
+	    fprintf(stderr, "RH_TCP::connect getaddrinfo failed: %s\n", gai_strerror(s));
+	    return false;
+	}
 
-    for (rp = result; rp != NULL; rp = rp->ai_next) 
-    {
-	_socket = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-	if (_socket == -1)
-	    continue;
+	// getaddrinfo() returns a list of address structures.
+	// Try each address until we successfully connect(2).
+	// If socket(2) (or connect(2)) fails, we (close the socket
+	// and) try the next address. */
+
+	for (rp = result; rp != NULL; rp = rp->ai_next) 
+	{
+	    _socket = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+	    if (_socket == -1)
+		continue;
 	
-	if (connect(_socket, rp->ai_addr, rp->ai_addrlen) == 0)
-	    break;                  /* Success */
+	    if (connect(_socket, rp->ai_addr, rp->ai_addrlen) == 0)
+		break;                  /* Success */
 
-	close(_socket);
-    }
+	    close(_socket);
+	    _socket = -1;
+	}
 
-    if (rp == NULL) 
-    {               /* No address succeeded */
-	fprintf(stderr, "RH_TCP::connect could not connect to %s\n", _server);
-	return false;
-    }
+	freeaddrinfo(result);           /* No longer needed */
 
-    freeaddrinfo(result);           /* No longer needed */
+	if (rp == NULL) 
+	{               /* No address succeeded */
+	    fprintf(stderr, "RH_TCP::connect could not connect to %s\n", _server);
+	    return false;
+	}
+    }
 
     // Now make the socket non-blocking
     int on = 1;
@@ -105,102 +151,266 @@ bool RH_TCP::connectToServer()
     return true;
 }
 
-void RH_TCP::clearRxBuf()
+bool RH_TCP::connectToUnixServer(const char* path)
+{
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+	fprintf(stderr, "RH_TCP::connect socket path too long: %s\n", path);
+	return false;
+    }
+    _socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (_socket == -1)
+    {
+	fprintf(stderr, "RH_TCP::connect could not create socket: %s\n", strerror(errno));
+	return false;
+    }
+    // Bind to an automatically chosen abstract address, so the server has somewhere to reply to
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (bind(_socket, (struct sockaddr*)&addr, sizeof(sa_family_t)) != 0)
+    {
+	fprintf(stderr, "RH_TCP::connect could not bind socket: %s\n", strerror(errno));
+	close(_socket);
+	_socket = -1;
+	return false;
+    }
+    strcpy(addr.sun_path, path);
+    if (connect(_socket, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+	fprintf(stderr, "RH_TCP::connect could not connect to %s: %s\n", path, strerror(errno));
+	close(_socket);
+	_socket = -1;
+	return false;
+    }
+    return true;
+}
+
+void RH_TCP::closeConnection()
+{
+    if (_socket >= 0)
+	close(_socket);
+    _socket = -1;
+    _socketBufHead = 0;
+    _socketBufLen = 0; // Discard any partial message
+}
+
+uint8_t RH_TCP::socketBufPeek(uint16_t offset)
+{
+    return _socketBuf[(_socketBufHead + offset) % RH_TCP_SOCKETBUF_LEN];
+}
+
+void RH_TCP::socketBufCopy(uint8_t* dest, uint16_t offset, uint16_t len)
 {
-    _rxBufValid = false;
-    _rxBufLen = 0;
+    uint16_t start = (_socketBufHead + offset) % RH_TCP_SOCKETBUF_LEN;
+    uint16_t first = RH_TCP_SOCKETBUF_LEN - start; // Octets before the end of the ring
+    if (first > len)
+	first = len;
+    memcpy(dest, _socketBuf + start, first);
+    memcpy(dest + first, _socketBuf, len - first);
 }
 
-void RH_TCP::checkForEvents()
+uint32_t RH_TCP::socketBufPeek32(uint16_t offset)
 {
-    #define RH_TCP_SOCKETBUF_LEN 500
-    static uint8_t socketBuf[RH_TCP_SOCKETBUF_LEN]; // Room for several messages
-    static uint16_t socketBufLen = 0;
+    return ((uint32_t)socketBufPeek(offset) << 24)
+	| ((uint32_t)socketBufPeek(offset + 1) << 16)
+	| ((uint32_t)socketBufPeek(offset + 2) << 8)
+	| socketBufPeek(offset + 3);
+}
+
+RH_TCP::RxPacket* RH_TCP::queuePacket(uint16_t offset, uint8_t payloadLen)
+{
+    uint8_t to = socketBufPeek(offset);
+    if (!_promiscuous &&
+	to != _thisAddress &&
+	to != RH_BROADCAST_ADDRESS)
+	return NULL; // Not for us
+    if (_rxQueueLen >= RH_TCP_RX_QUEUE_LEN)
+    {
+	// No room, drop it
+	_rxBad++;
+	return NULL;
+    }
+    RxPacket* packet = &_rxQueue[(_rxQueueHead + _rxQueueLen) % RH_TCP_RX_QUEUE_LEN];
+    packet->to     = to;
+    packet->from   = socketBufPeek(offset + 1);
+    packet->id     = socketBufPeek(offset + 2);
+    packet->flags  = socketBufPeek(offset + 3);
+    packet->len    = payloadLen;
+    packet->rssi   = 0;
+    packet->snr    = 0;
+    packet->txTime = 0;
+    socketBufCopy(packet->payload, offset + RH_TCP_HEADER_LEN, payloadLen);
+    _rxQueueLen++;
+    _rxGood++;
+    return packet;
+}
 
-    // Read at most the amount of space we have left in the buffer
-    ssize_t count = read(_socket, socketBuf + socketBufLen, sizeof(socketBuf) - socketBufLen);
+// Reads as much as is available from a stream socket into the free space in the ring buffer
+bool RH_TCP::readStream()
+{
+    // The free space may be in 2 parts if it wraps around the end
+    uint16_t tail = (_socketBufHead + _socketBufLen) % RH_TCP_SOCKETBUF_LEN;
+    uint16_t space = RH_TCP_SOCKETBUF_LEN - _socketBufLen;
+    struct iovec iov[2];
+    iov[0].iov_base = _socketBuf + tail;
+    iov[0].iov_len  = RH_TCP_SOCKETBUF_LEN - tail;
+    if (iov[0].iov_len > space)
+	iov[0].iov_len = space;
+    iov[1].iov_base = _socketBuf;
+    iov[1].iov_len  = space - iov[0].iov_len;
+    ssize_t count = readv(_socket, iov, iov[1].iov_len ? 2 : 1);
     if (count < 0)
     {
-	if (errno != EAGAIN)
-	{
-	    fprintf(stderr,"RH_TCP::checkForEvents read error: %s\n", strerror(errno));
-	    exit(1);
-	}
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	    return true; // Nothing to read just now
+	fprintf(stderr, "RH_TCP::checkForEvents read error: %s\n", strerror(errno));
+	closeConnection();
+	return false;
     }
     else if (count == 0)
     {
 	// End of file
-	fprintf(stderr,"RH_TCP::checkForEvents unexpected end of file on read\n");
-	exit(1);
+	fprintf(stderr, "RH_TCP::checkForEvents unexpected end of file on read\n");
+	closeConnection();
+	return false;
     }
-    else
+    _socketBufLen += count;
+    return true;
+}
+
+// Receives as many datagrams as will fit in the ring buffer with one system call
+bool RH_TCP::readDatagrams()
+{
+    struct mmsghdr msgs[RH_TCP_DGRAM_BATCH];
+    struct iovec   iovs[RH_TCP_DGRAM_BATCH];
+    unsigned int   batch = (RH_TCP_SOCKETBUF_LEN - _socketBufLen) / sizeof(RHTcpPacketExt);
+    if (batch > RH_TCP_DGRAM_BATCH)
+	batch = RH_TCP_DGRAM_BATCH;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (unsigned int i = 0; i < batch; i++)
+    {
+	iovs[i].iov_base = _dgramBuf[i];
+	iovs[i].iov_len  = sizeof(_dgramBuf[i]);
+	msgs[i].msg_hdr.msg_iov    = &iovs[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int count = recvmmsg(_socket, msgs, batch, MSG_DONTWAIT, NULL);
+    if (count < 0)
+    {
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	    return true; // Nothing to read just now
+	fprintf(stderr, "RH_TCP::checkForEvents receive error: %s\n", strerror(errno));
+	closeConnection();
+	return false;
+    }
+
+    // Each datagram is one complete message. Append them to the ring buffer
+    // to be processed the same way as a stream
+    for (int i = 0; i < count; i++)
+    {
+	uint32_t len = msgs[i].msg_len;
+	if (len < sizeof(uint32_t) + 1
+	    || (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+	    || ntohl(*(uint32_t*)_dgramBuf[i]) != len - sizeof(uint32_t))
+	{
+	    // Not exactly one whole message, ignore it
+	    _rxBad++;
+	    continue;
+	}
+	uint16_t tail = (_socketBufHead + _socketBufLen) % RH_TCP_SOCKETBUF_LEN;
+	uint16_t first = RH_TCP_SOCKETBUF_LEN - tail; // Octets before the end of the ring
+	if (first > len)
+	    first = len;
+	memcpy(_socketBuf + tail, _dgramBuf[i], first);
+	memcpy(_socketBuf, _dgramBuf[i] + first, len - first);
+	_socketBufLen += len;
+    }
+    return true;
+}
+
+bool RH_TCP::checkForEvents()
+{
+    if (_socket < 0)
+	return false;
+    if (!(_datagram ? readDatagrams() : readStream()))
+	return false;
+
+    // Process all the complete messages in the buffer
+    while (_socketBufLen >= sizeof(uint32_t))
     {
-	socketBufLen += count;
-	while (socketBufLen >= 5)
+	// Length is in network byte order, and may wrap around the end of the ring
+	uint32_t len = socketBufPeek32(0);
+	if (len < 1 || len > sizeof(RHTcpPacketExt) - sizeof(uint32_t))
+	{
+	    // Bogus length
+	    fprintf(stderr, "RH_TCP::checkForEvents read ridiculous length: %u. Corrupt message stream?\n", len);
+	    closeConnection();
+	    return false;
+	}
+	uint32_t messageLen = len + sizeof(uint32_t);
+	if (_socketBufLen < messageLen)
+	    break; // Partial message, leave it where it is until the rest arrives
+
+	uint8_t type = socketBufPeek(4);
+	if (type == RH_TCP_MESSAGE_TYPE_PACKET || type == RH_TCP_MESSAGE_TYPE_PACKET_EXT)
 	{
-	    RHTcpTypeMessage* message = ((RHTcpTypeMessage*)socketBuf);
-	    uint32_t len = ntohl(message->length);
-	    uint32_t messageLen = len + sizeof(message->length);
-	    if (len > sizeof(socketBuf) - sizeof(message->length))
+	    // The length allows any message type, so check it against the fixed part of this type
+	    // and the payload space in an RxPacket. Drop the packet if it does not fit
+	    uint32_t fixedLen = 1 + RH_TCP_HEADER_LEN;
+	    if (type == RH_TCP_MESSAGE_TYPE_PACKET_EXT)
+		fixedLen += RH_TCP_PACKET_EXT_LEN;
+	    if (len < fixedLen || len - fixedLen > RH_TCP_MAX_MESSAGE_LEN)
+		_rxBad++;
+	    else if (type == RH_TCP_MESSAGE_TYPE_PACKET)
 	    {
-		// Bogus length
-		fprintf(stderr, "RH_TCP::checkForEvents read ridiculous length: %d. Corrupt message stream? Aborting\n", len);
-		exit(1);
+		// The headers follow the length and type
+		queuePacket(5, len - fixedLen);
 	    }
-	    if (socketBufLen >= len + sizeof(message->length))
+	    // Only receive packets sent with the same radio parameters
+	    else if (socketBufPeek32(8) == _frequency && socketBufPeek(12) == _spreadingFactor)
 	    {
-		// Got at least all of this message
-		if (message->type == RH_TCP_MESSAGE_TYPE_PACKET && len >= 5)
+		RxPacket* packet = queuePacket(5 + RH_TCP_PACKET_EXT_LEN, len - fixedLen);
+		if (packet)
 		{
-		    // REVISIT: need to check if we are actually receiving?
-		    // Its a new packet, extract the headers and payload
-		    RHTcpPacket* packet = ((RHTcpPacket*)socketBuf);
-		    _rxHeaderTo    = packet->to;
-		    _rxHeaderFrom  = packet->from;
-		    _rxHeaderId    = packet->id;
-		    _rxHeaderFlags = packet->flags;
-		    uint32_t payloadLen = len - 5;
-		    if (payloadLen <= sizeof(_rxBuf))
-		    {
-			// Enough room in our receiver buffer
-			memcpy(_rxBuf, packet->payload, payloadLen);
-			_rxBufLen = payloadLen;
-			_rxBufFull = true;
-		    }
+		    packet->rssi   = (int16_t)((socketBufPeek(5) << 8) | socketBufPeek(6));
+		    packet->snr    = (int8_t)socketBufPeek(7);
+		    packet->txTime = (uint64_t)socketBufPeek32(13) * 1000000 + socketBufPeek32(17);
 		}
-		// check for other message types here
-		// Now remove the used message by copying the trailing bytes (maybe start of a new message?)
-		// to the top of the buffer
-		memcpy(socketBuf, socketBuf + messageLen, sizeof(socketBuf) - messageLen);
-		socketBufLen -= messageLen;
 	    }
 	}
-    }
-}
+	else if (type == RH_TCP_MESSAGE_TYPE_VERSION && len >= 2)
+	{
+	    // The server supports at least version 2
+	    uint8_t version = socketBufPeek(5);
+	    _protocolVersion = version < RH_TCP_PROTOCOL_VERSION ? version : RH_TCP_PROTOCOL_VERSION;
+	}
+	// check for other message types here
 
-void RH_TCP::validateRxBuf()
-{
-    // The headers have already been extracted
-    if (_promiscuous ||
-	_rxHeaderTo == _thisAddress ||
-	_rxHeaderTo == RH_BROADCAST_ADDRESS)
-    {
-	_rxGood++;
-	_rxBufValid = true;
+	// Now remove the used message
+	_socketBufHead = (_socketBufHead + messageLen) % RH_TCP_SOCKETBUF_LEN;
+	_socketBufLen -= messageLen;
     }
+    return true;
 }
 
 bool RH_TCP::available()
 {
-    if (_socket < 0)
-	return false;
     checkForEvents();
-    if (_rxBufFull)
-    {
-	validateRxBuf();
-	_rxBufFull= false;
-    }
-    return _rxBufValid;
+    checkTxDone();
+    if (_mode == RHModeTx || !_rxQueueLen)
+	return false;
+    // Make the headers of the oldest packet available
+    RxPacket* packet = &_rxQueue[_rxQueueHead];
+    _rxHeaderTo    = packet->to;
+    _rxHeaderFrom  = packet->from;
+    _rxHeaderId    = packet->id;
+    _rxHeaderFlags = packet->flags;
+    _lastRssi      = packet->rssi;
+    _lastSNR       = packet->snr;
+    _lastTxTime    = packet->txTime;
+    return true;
 }
 
 // Block until something is available
@@ -212,6 +422,11 @@ void RH_TCP::waitAvailable()
 // Block until something is available or timeout expires
 bool RH_TCP::waitAvailableTimeout(uint16_t timeout)
 {
+    if (available())
+	return true; // Already received
+    if (_socket < 0)
+	return false;
+
     int            max_fd;
     fd_set         input;
     int            result;
@@ -242,24 +457,83 @@ bool RH_TCP::recv(uint8_t* buf, uint8_t* len)
     if (!available())
 	return false;
 
+    RxPacket* packet = &_rxQueue[_rxQueueHead];
     if (buf && len)
     {
-	if (*len > _rxBufLen)
-	    *len = _rxBufLen;
-	memcpy(buf, _rxBuf, *len);
+	if (*len > packet->len)
+	    *len = packet->len;
+	memcpy(buf, packet->payload, *len);
     }
-    clearRxBuf();
+    _rxQueueHead = (_rxQueueHead + 1) % RH_TCP_RX_QUEUE_LEN;
+    _rxQueueLen--;
     return true;
 }
 
 bool RH_TCP::send(const uint8_t* data, uint8_t len)
 {
+    if (len > RH_TCP_MAX_MESSAGE_LEN)
+	return false;
     if (!waitCAD()) 
 	return false;  // Check channel activity (prob not possible for this driver?)
 
-    bool ret = sendPacket(data, len);
-    delay(10); // Wait for transmit to succeed. REVISIT: depends on length and speed
-    return ret;
+    waitPacketSent(); // Make sure we dont interrupt an outgoing message
+    if (!sendPacket(data, len))
+	return false;
+    // The simulated radio is busy until the packet has been on the air for long enough
+    _txDoneTime = monotonicMicros() + airtime(len);
+    _mode = RHModeTx;
+    return true;
+}
+
+void RH_TCP::checkTxDone()
+{
+    if (_mode == RHModeTx && monotonicMicros() >= _txDoneTime)
+	_mode = RHModeIdle;
+}
+
+bool RH_TCP::waitPacketSent()
+{
+    if (_mode == RHModeTx)
+    {
+	uint64_t now = monotonicMicros();
+	if (now < _txDoneTime)
+	    usleep(_txDoneTime - now);
+	_mode = RHModeIdle;
+    }
+    return true;
+}
+
+bool RH_TCP::waitPacketSent(uint16_t timeout)
+{
+    if (_mode != RHModeTx)
+	return true;
+    uint64_t now = monotonicMicros();
+    if (now < _txDoneTime && _txDoneTime - now > (uint64_t)timeout * 1000)
+    {
+	// Will not finish in time
+	delay(timeout);
+	return false;
+    }
+    return waitPacketSent();
+}
+
+void RH_TCP::setBitRate(uint32_t bitRate)
+{
+    _bitRate = bitRate;
+}
+
+void RH_TCP::setPreambleLength(uint16_t bytes)
+{
+    _preambleLen = bytes;
+}
+
+uint32_t RH_TCP::airtime(uint8_t len)
+{
+    if (!_bitRate)
+	return 0;
+    uint64_t bits = ((uint64_t)_preambleLen + RH_TCP_HEADER_LEN + len) * 8;
+    // Round up to the next microsecond
+    return (bits * 1000000 + _bitRate - 1) / _bitRate;
 }
 
 uint8_t RH_TCP::maxMessageLength()
@@ -285,19 +559,79 @@ bool RH_TCP::sendThisAddress(uint8_t thisAddress)
     return sent > 0;
 }
 
+bool RH_TCP::setFrequency(float centre)
+{
+    _frequency = (uint32_t)(centre * 1000 + 0.5); // kHz
+    return true;
+}
+
+void RH_TCP::setSpreadingFactor(uint8_t sf)
+{
+    _spreadingFactor = sf;
+}
+
+int RH_TCP::lastSNR()
+{
+    return _lastSNR;
+}
+
+uint64_t RH_TCP::lastTxTime()
+{
+    return _lastTxTime;
+}
+
+uint8_t RH_TCP::protocolVersion()
+{
+    return _protocolVersion;
+}
+
+bool RH_TCP::sendVersion()
+{
+    if (_socket < 0)
+	return false;
+    RHTcpVersion m;
+    m.length = htonl(2);
+    m.type = RH_TCP_MESSAGE_TYPE_VERSION;
+    m.version = RH_TCP_PROTOCOL_VERSION;
+    ssize_t sent = write(_socket, &m, sizeof(m));
+    return sent > 0;
+}
+
 bool RH_TCP::sendPacket(const uint8_t* data, uint8_t len)
 {
     if (_socket < 0)
 	return false;
+    if (_protocolVersion >= RH_TCP_PROTOCOL_VERSION_2)
+    {
+	RHTcpPacketExt m;
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	m.length = htonl(1 + RH_TCP_PACKET_EXT_LEN + RH_TCP_HEADER_LEN + len);
+	m.type            = RH_TCP_MESSAGE_TYPE_PACKET_EXT;
+	m.rssi            = 0; // Filled in by the server
+	m.snr             = 0;
+	m.frequency       = htonl(_frequency);
+	m.spreadingFactor = _spreadingFactor;
+	m.txTimeSec       = htonl(now.tv_sec);
+	m.txTimeUsec      = htonl(now.tv_usec);
+	m.to              = _txHeaderTo;
+	m.from            = _txHeaderFrom;
+	m.id              = _txHeaderId;
+	m.flags           = _txHeaderFlags;
+	memcpy(m.payload, data, len);
+	ssize_t sent = write(_socket, &m, sizeof(uint32_t) + 1 + RH_TCP_PACKET_EXT_LEN + RH_TCP_HEADER_LEN + len);
+	return sent > 0;
+    }
     RHTcpPacket m;
-    m.length = htonl(len + 4);
+    // Length counts the type and the 4 headers as well as the payload
+    m.length = htonl(len + 5);
     m.type  = RH_TCP_MESSAGE_TYPE_PACKET;
     m.to    = _txHeaderTo;
     m.from  = _txHeaderFrom;
     m.id    = _txHeaderId;
     m.flags = _txHeaderFlags;
     memcpy(m.payload, data, len);
-    ssize_t sent = write(_socket, &m, len + 8);
+    ssize_t sent = write(_socket, &m, len + 9);
     return sent > 0;
 }
 
@@ -8,6 +8,28 @@
 #include <RHGenericDriver.h>
 #include <RHTcpProtocol.h>
 
+// The size of the ring buffer that RHTcpProtocol messages are read into from the socket.
+// Must be bigger than the longest message
+#ifndef RH_TCP_SOCKETBUF_LEN
+#define RH_TCP_SOCKETBUF_LEN 8192
+#endif
+
+// The most datagrams received with one system call when using a datagram transport.
+// Also limited by the room in the ring buffer for maximum size messages
+#ifndef RH_TCP_DGRAM_BATCH
+#define RH_TCP_DGRAM_BATCH 16
+#endif
+
+// The default simulated bit rate, the same as the default for etherSimulator.pl
+#ifndef RH_TCP_DEFAULT_BIT_RATE
+#define RH_TCP_DEFAULT_BIT_RATE 10000
+#endif
+
+// The number of received packets that can be waiting to be collected by recv()
+#ifndef RH_TCP_RX_QUEUE_LEN
+#define RH_TCP_RX_QUEUE_LEN 16
+#endif
+
 /////////////////////////////////////////////////////////////////////
 /// \class RH_TCP RH_TCP.h <RH_TCP.h>
 /// \brief Driver to send and receive unaddressed, unreliable datagrams via sockets on a Linux simulator
@@ -58,6 +80,50 @@
 /// The simulated sketches send messages out to the 'ether' over the TCP connection to the etherServer.
 /// etherServer manages the delivery of each message to any other RH_TCP sketches that are running.
 ///
+/// Messages from the server are read into a ring buffer with as few system calls as possible. Each read
+/// may contain several messages and parts of messages. All the complete packets are put into a receive queue
+/// (of RH_TCP_RX_QUEUE_LEN packets) for collection by recv(), and a partial message at the end
+/// stays in the ring buffer until the rest arrives.
+/// If the receive queue is full, further packets are dropped and counted by rxBad().
+/// If the connection to the server fails or the message stream is corrupt, an error is printed to stderr
+/// and the connection is closed. After that, available() returns false once any queued packets have been
+/// collected, send() fails and connected() returns false. Call init() to reconnect.
+///
+/// \par Transports
+///
+/// By default RH_TCP connects to the server with TCP. For large simulations with many nodes,
+/// RH_TCP can also use UDP or Unix domain datagram sockets, with server names like
+/// "udp:localhost:4000" or "unix:/tmp/ether". Each RHTcpProtocol message is then sent as one datagram,
+/// and all the datagrams waiting are received with one recvmmsg() system call. These transports need a server that
+/// supports them, such as tools/etherSimulatorDgram, which also receives and sends in batches
+/// with recvmmsg() and sendmmsg(). etherSimulator.pl supports only TCP.
+/// The server name can also be set with the RH_TCP_SERVER environment variable, so existing
+/// simulator sketches can be run with another transport without change:
+/// \code
+/// tools/etherSimulatorDgram -x /tmp/ether &
+/// RH_TCP_SERVER=unix:/tmp/ether ./simulator_reliable_datagram_server
+/// \endcode
+/// Datagrams that are not exactly one message are discarded and counted by rxBad().
+///
+/// \par Transmit timing
+///
+/// send() returns as soon as the packet has been passed to the server, and the driver stays in RHModeTx
+/// for the simulated airtime of the packet: the preamble (see setPreambleLength()), the 4 headers and the payload
+/// at the bit rate set by setBitRate(). waitPacketSent() sleeps until exactly the end of the airtime,
+/// and available() returns false until then. The bit rate should be the same as the -b option
+/// given to etherSimulator.pl (10000 by default), which delays delivery to other nodes by the same time.
+///
+/// \par Simulated radio parameters
+///
+/// When connected to a server that supports RH_TCP_PROTOCOL_VERSION_2 (see RHTcpProtocol.h), each packet
+/// carries the frequency and spreading factor set by setFrequency() and setSpreadingFactor(), and the time
+/// it was sent. Packets sent on a different frequency or spreading factor are not received, so
+/// channel plans can be simulated. The server gives each delivered packet an RSSI and SNR
+/// for the link between the 2 nodes, available from lastRssi() and lastSNR(), so link quality aware routing
+/// can be tested. lastTxTime() gives the time the packet was sent, to measure latency.
+/// With a version 1 server, none of this is available: lastRssi() and lastSNR() return 0,
+/// and all packets are received. protocolVersion() tells which version is in use.
+///
 /// \par Prerequisites
 ///
 /// g++ compiler installed and in your $PATH
@@ -72,6 +138,8 @@ public:
     /// Format is "name[:port]", where name can be any valid host name or address (IPV4 or IPV6).
     /// The trailing :port is optional, and port can be any valid 
     /// port name or port number.
+    /// "udp:name[:port]" uses UDP instead of TCP, and "unix:path" uses a Unix domain datagram socket.
+    /// Overridden by the RH_TCP_SERVER environment variable, if set.
     RH_TCP(const char* server = "localhost:4000");
 
     /// Initialise the Driver transport hardware and software.
@@ -118,11 +186,37 @@ public:
     /// \return true if the message length was valid and it was correctly queued for transmit
     virtual bool send(const uint8_t* data, uint8_t len);
 
+    /// Blocks until the simulated transmission of the last packet sent has finished.
+    /// \return true
+    virtual bool waitPacketSent();
+
+    /// Blocks until the simulated transmission of the last packet sent has finished,
+    /// or until the timeout occurs, whichever happens first
+    /// \param[in] timeout Maximum time to wait in milliseconds.
+    /// \return true if the transmission finished within the timeout period. False if it timed out.
+    virtual bool waitPacketSent(uint16_t timeout);
+
     /// Returns the maximum message length 
     /// available in this Driver.
     /// \return The maximum legal message length
     virtual uint8_t maxMessageLength();
 
+    /// Sets the simulated bit rate used to calculate how long each transmission takes.
+    /// Should be the same as the -b option given to etherSimulator.pl.
+    /// \param[in] bitRate Bits per second. Defaults to RH_TCP_DEFAULT_BIT_RATE. 0 means transmissions take no time.
+    void setBitRate(uint32_t bitRate);
+
+    /// Sets the length of the simulated preamble (and any other per-packet overhead such as
+    /// sync words and CRC) that is added to the airtime of each packet. Defaults to 0, which is what
+    /// etherSimulator.pl assumes.
+    /// \param[in] bytes Preamble length in octets
+    void setPreambleLength(uint16_t bytes);
+
+    /// Calculates the simulated airtime of a packet, with the current bit rate and preamble length
+    /// \param[in] len Length of the message payload in octets
+    /// \return The airtime in microseconds
+    uint32_t airtime(uint8_t len);
+
     /// Sets the address of this node. Defaults to 0xFF. Subclasses or the user may want to change this.
     /// This will be used to test the adddress in incoming messages. In non-promiscuous mode,
     /// only messages with a TO header the same as thisAddress or the broadcast addess (0xFF) will be accepted.
@@ -134,18 +228,100 @@ public:
     /// \param[in] address The address of this node.
     void setThisAddress(uint8_t address);
 
+    /// Sets the simulated transmitter and receiver frequency. Only packets sent on the same frequency
+    /// are received. Requires RH_TCP_PROTOCOL_VERSION_2.
+    /// \param[in] centre Frequency in MHz. Defaults to 0.
+    /// \return true
+    bool setFrequency(float centre);
+
+    /// Sets the simulated spreading factor, or any other modem configuration tag. Only packets sent with the same
+    /// spreading factor are received. Requires RH_TCP_PROTOCOL_VERSION_2.
+    /// \param[in] sf The spreading factor. Defaults to 0.
+    void setSpreadingFactor(uint8_t sf);
+
+    /// Returns the Signal-to-noise ratio (SNR) of the last received message, as simulated by the server.
+    /// \return SNR of the last received message in dB, or 0 if the server does not support RH_TCP_PROTOCOL_VERSION_2
+    int lastSNR();
+
+    /// Returns the time the last received message was sent by the transmitting node
+    /// \return Microseconds since the epoch, or 0 if the server does not support RH_TCP_PROTOCOL_VERSION_2
+    uint64_t lastTxTime();
+
+    /// Returns the version of RHTcpProtocol agreed with the server.
+    /// \return RH_TCP_PROTOCOL_VERSION_1 until the server replies to our version message,
+    /// then the lower of its version and ours.
+    uint8_t protocolVersion();
+
+    /// Tells whether this driver is connected to the ether simulator server.
+    /// \return true if init() succeeded and there has been no error on the connection since
+    bool connected() { return _socket >= 0; }
+
 protected:
 
 private:
+    /// A received packet waiting in the receive queue
+    typedef struct
+    {
+	uint8_t     to;       ///< TO header
+	uint8_t     from;     ///< FROM header
+	uint8_t     id;       ///< ID header
+	uint8_t     flags;    ///< FLAGS header
+	uint8_t     len;      ///< Number of octets in payload
+	int16_t     rssi;     ///< Simulated RSSI in dBm
+	int8_t      snr;      ///< Simulated SNR in dB
+	uint64_t    txTime;   ///< Time sent, microseconds since the epoch
+	uint8_t     payload[RH_TCP_MAX_MESSAGE_LEN]; ///< The message
+    } RxPacket;
+
     /// Connect to the address and port specified by the server constructor argument.
     /// Prepares the socket for use.
     bool connectToServer();
 
-    /// Check for new messages from the ether simulator server
-    void checkForEvents();
+    /// Creates a Unix domain datagram socket connected to the server
+    /// \param[in] path The path of the server socket
+    /// \return true if successful
+    bool connectToUnixServer(const char* path);
+
+    /// Reads as much as is available from a stream socket into the ring buffer
+    /// \return false if there was an error, and the connection has been closed
+    bool readStream();
+
+    /// Receives the waiting datagrams from a datagram socket into the ring buffer
+    /// \return false if there was an error, and the connection has been closed
+    bool readDatagrams();
+
+    /// Check for new messages from the ether simulator server.
+    /// Reads whatever is available from the socket into the ring buffer, and queues all
+    /// the complete packets in it.
+    /// \return false if there was an error, and the connection has been closed
+    bool checkForEvents();
 
-    /// Clear the receive buffer
-    void clearRxBuf();
+    /// Adds the packet at the start of the ring buffer to the receive queue,
+    /// if it is addressed to this node and there is room
+    /// \param[in] offset Offset of the 4 headers from the start of the ring buffer
+    /// \param[in] payloadLen Number of octets in the packet payload, which follows the headers
+    /// \return The new entry in the receive queue, or NULL if the packet was not queued
+    RxPacket* queuePacket(uint16_t offset, uint8_t payloadLen);
+
+    /// Returns an octet from the ring buffer
+    /// \param[in] offset Offset from the start of the ring buffer
+    uint8_t socketBufPeek(uint16_t offset);
+
+    /// Returns a 32 bit value in network byte order from the ring buffer
+    /// \param[in] offset Offset from the start of the ring buffer
+    uint32_t socketBufPeek32(uint16_t offset);
+
+    /// Copies octets out of the ring buffer
+    /// \param[out] dest Where to copy them to
+    /// \param[in] offset Offset from the start of the ring buffer
+    /// \param[in] len Number of octets to copy
+    void socketBufCopy(uint8_t* dest, uint16_t offset, uint16_t len);
+
+    /// Closes the connection to the server after an error
+    void closeConnection();
+
+    /// Ends the simulated transmission if its airtime has elapsed
+    void checkTxDone();
 
     /// Sends thisAddress to the ether simulator server
     /// in a RHTcpThisAddress message.
@@ -153,6 +329,11 @@ private:
     /// \return true if successful
     bool sendThisAddress(uint8_t thisAddress);
 
+    /// Sends the highest protocol version we support to the ether simulator server
+    /// in a RHTcpVersion message.
+    /// \return true if successful
+    bool sendVersion();
+
     /// Sends a message to the ether simulator server for delivery to
     /// other nodes
     /// \param[in] data Array of data to be sent
@@ -167,21 +348,57 @@ private:
     /// The TCP socket used to communicate with the message server
     int         _socket;
 
-    /// Buffer to receive RHTcpProtocol messages
-    uint8_t     _rxBuf[RH_TCP_MAX_PAYLOAD_LEN + 5];
-    uint16_t    _rxBufLen;
-    bool        _rxBufValid;
+    /// Ring buffer that RHTcpProtocol messages are read into from the socket
+    uint8_t     _socketBuf[RH_TCP_SOCKETBUF_LEN];
+
+    /// Index in _socketBuf of the start of the first unprocessed message
+    uint16_t    _socketBufHead;
+
+    /// Number of unprocessed octets in _socketBuf
+    uint16_t    _socketBufLen;
+
+    /// Received packets waiting for recv()
+    RxPacket    _rxQueue[RH_TCP_RX_QUEUE_LEN];
+
+    /// Index in _rxQueue of the oldest packet
+    uint8_t     _rxQueueHead;
+
+    /// Number of packets in _rxQueue
+    uint8_t     _rxQueueLen;
+
+    /// Simulated bit rate in bits per second
+    uint32_t    _bitRate;
+
+    /// Simulated preamble length in octets
+    uint16_t    _preambleLen;
+
+    /// Monotonic time in microseconds when the current transmission ends
+    uint64_t    _txDoneTime;
+
+    /// The RH_TCP_PROTOCOL_VERSION_* agreed with the server
+    uint8_t     _protocolVersion;
+
+    /// Simulated frequency in kHz
+    uint32_t    _frequency;
+
+    /// Simulated spreading factor
+    uint8_t     _spreadingFactor;
+
+    /// SNR of the last received packet
+    int8_t      _lastSNR;
 
-    /// Check whether the latest received message is complete and uncorrupted
-    void            validateRxBuf();
+    /// Time the last received packet was sent, in microseconds since the epoch
+    uint64_t    _lastTxTime;
 
-    // Used in the interrupt handlers
-    /// Buf is filled but not validated
-    volatile bool   _rxBufFull;
+    /// True if the server is connected with a datagram socket
+    bool        _datagram;
 
+    /// Datagrams are received here before being added to the ring buffer
+    uint8_t     _dgramBuf[RH_TCP_DGRAM_BATCH][sizeof(RHTcpPacketExt)];
 };
 
 /// @example simulator_reliable_datagram_client.pde
 /// @example simulator_reliable_datagram_server.pde
+/// @example simulator_back_to_back.pde
 
 #endif
@@ -4,21 +4,22 @@
 // $Id: HardwareSerial.cpp,v 1.3 2015/08/13 02:45:47 mikem Exp mikem $
 
 #include <RadioHead.h>
-#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+#if (RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI)
 
-#include <HardwareSerial.h>
+#include <RHutil/HardwareSerial.h>
 
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <termios.h>
-#include <sys/ioctl.h>
-#include <sys/select.h>
+#include <poll.h>
 
 HardwareSerial::HardwareSerial(const char* deviceName)
     : _deviceName(deviceName),
-      _device(-1)
+      _device(-1),
+      _rxHead(0),
+      _rxTail(0)
 {
     // Override device name from environment
     char* e = getenv("RH_HARDWARESERIAL_DEVICE_NAME");
@@ -50,39 +51,80 @@ int HardwareSerial::peek(void)
 
 int HardwareSerial::available()
 {
-    int bytes;
-
-    if (ioctl(_device, FIONREAD, &bytes) != 0)
-    {
-	fprintf(stderr, "HardwareSerial::available ioctl failed: %s\n", strerror(errno));
-	return 0;
-    }
-    return bytes;
+    if (_rxHead < _rxTail)
+	return _rxTail - _rxHead;
+    return fillBuffer();
 }
 
 int HardwareSerial::read()
 {
-    uint8_t data;
-    ssize_t result = ::read(_device, &data, 1);
-    if (result != 1)
+    if (_rxHead >= _rxTail && !fillBuffer())
+	return -1; // Nothing available, like Arduino
+//    printf("got: %02x\n", _rxBuf[_rxHead]);
+    return _rxBuf[_rxHead++];
+}
+
+int HardwareSerial::readBuffer(const uint8_t** data)
+{
+    int count = available();
+    *data = _rxBuf + _rxHead;
+    return count;
+}
+
+void HardwareSerial::consume(int count)
+{
+    _rxHead += count;
+    if (_rxHead > _rxTail)
+	_rxHead = _rxTail;
+}
+
+// Called only when the buffer is empty, so we can start again from the beginning,
+// and read as much as will fit in one go
+int HardwareSerial::fillBuffer()
+{
+    _rxHead = _rxTail = 0;
+    if (_device == -1)
+	return 0;
+    ssize_t result = ::read(_device, _rxBuf, sizeof(_rxBuf));
+    if (result < 0)
     {
-	fprintf(stderr, "HardwareSerial::read read failed: %s\n", strerror(errno));
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+	    fprintf(stderr, "HardwareSerial::fillBuffer read failed: %s\n", strerror(errno));
 	return 0;
     }
-//    printf("got: %02x\n", data);
-    return data;
+    _rxTail = result;
+    return _rxTail;
 }
 
 size_t HardwareSerial::write(uint8_t ch)
 {
-    size_t result = ::write(_device, &ch, 1);
-    if (result != 1)
+    return write(&ch, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t len)
+{
+    size_t sent = 0;
+    while (sent < len)
     {
-	fprintf(stderr, "HardwareSerial::write failed: %s\n", strerror(errno));
-	return 0;
+	ssize_t result = ::write(_device, buf + sent, len - sent);
+	if (result < 0)
+	{
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+	    {
+		// Device output buffer is full, wait for room
+		struct pollfd pfd = { _device, POLLOUT, 0 };
+		poll(&pfd, 1, -1);
+		continue;
+	    }
+	    fprintf(stderr, "HardwareSerial::write failed: %s\n", strerror(errno));
+	    break;
+	}
+	sent += result;
     }
-//    printf("sent: %02x\n", ch);
-    return 1; // OK
+//    printf("sent: %d\n", sent);
+    return sent;
 }
 
 bool HardwareSerial::openDevice()
@@ -97,8 +139,10 @@ bool HardwareSerial::openDevice()
 	return false;
     }
 
-    // Device opened
-    fcntl(_device, F_SETFL, 0);
+    // Device opened. Leave it non-blocking so we can read whatever is available
+    // in one go without checking how much there is first
+    fcntl(_device, F_SETFL, O_NONBLOCK);
+    _rxHead = _rxTail = 0;
     return true;
 }
 
@@ -218,28 +262,14 @@ void HardwareSerial::waitAvailable()
 // Block until something is available or timeout expires
 bool HardwareSerial::waitAvailableTimeout(uint16_t timeout)
 {
-    int            max_fd;
-    fd_set         input;
-    int            result;
+    if (_rxHead < _rxTail)
+	return true; // Already buffered, the device may not be readable
 
-    FD_ZERO(&input);
-    FD_SET(_device, &input);
-    max_fd = _device + 1;
-
-    if (timeout)
-    {
-	struct timeval timer;
-	// Timeout is in milliseconds
-	timer.tv_sec  = timeout / 1000;
-	timer.tv_usec = (timeout % 1000) * 1000;
-	result = select(max_fd, &input, NULL, NULL, &timer);
-    }
-    else
-    {
-	result = select(max_fd, &input, NULL, NULL, NULL);
-    }
-    if (result < 0)
-	fprintf(stderr, "HardwareSerial::waitAvailableTimeout: select failed %s\n", strerror(errno));
+    struct pollfd pfd = { _device, POLLIN, 0 };
+    // Timeout is in milliseconds, 0 means forever
+    int result = poll(&pfd, 1, timeout ? timeout : -1);
+    if (result < 0 && errno != EINTR)
+	fprintf(stderr, "HardwareSerial::waitAvailableTimeout: poll failed %s\n", strerror(errno));
     return result > 0;
 }
 
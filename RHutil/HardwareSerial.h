@@ -7,6 +7,12 @@
 
 #include <stdio.h>
 
+// The number of received octets HardwareSerial buffers. Each time the buffer empties,
+// as many octets as will fit are read from the device in one system call
+#ifndef RH_HARDWARESERIAL_RX_BUF_LEN
+#define RH_HARDWARESERIAL_RX_BUF_LEN 4096
+#endif
+
 /////////////////////////////////////////////////////////////////////
 /// \class HardwareSerial HardwareSerial.h <RHutil/HardwareSerial.h>
 /// \brief Encapsulates a Posix compliant serial port as a HarwareSerial
@@ -23,6 +29,15 @@
 ///
 /// Device naming conventions vary from OS to OS. ON linux, an FTDI serial port may have a name like
 /// /dev/ttyUSB0. On OSX, it might be something like /dev/tty.usbserial-A501YSWL
+/// \par Buffering
+///
+/// Received characters are read from the device in bulk into an internal buffer, so available() and read()
+/// do not usually need a system call for every character. This matters at high baud rates: at 1Mbaud
+/// a port can deliver 100000 characters per second. readBuffer() and consume() give direct access
+/// to the buffered characters. write(const uint8_t*, size_t) sends a whole buffer with one system call.
+/// The device is opened non-blocking. waitAvailableTimeout() uses poll(), and fd() returns the
+/// file descriptor so the port can share a poll() or epoll() event loop with other file descriptors.
+///
 /// \par errors
 ///
 /// A number of these methods print error messages to stderr in the event of an IO error.
@@ -58,15 +73,26 @@ public:
     int peek(void);
 
     /// Returns the number of bytes immediately available to be read from the
-    /// device.
+    /// device. If the receive buffer is empty, reads as many characters as are waiting in the device into it.
     /// \return 0 if none available else the number of characters available for immediate reading
     int available();
 
     /// Read and return the next available character.
-    /// If no character is available prints a message to stderr and returns 0;
-    /// \return The next available character
+    /// \return The next available character, or -1 if none is available, as with Arduino Stream::read()
     int read();
 
+    /// Gives direct access to the received characters in the receive buffer, without consuming them.
+    /// If the receive buffer is empty, reads as many characters as are waiting in the device into it.
+    /// Call consume() to remove the characters that have been processed.
+    /// \param[out] data Set to point to the first buffered character
+    /// \return The number of buffered characters at data, 0 if none
+    int readBuffer(const uint8_t** data);
+
+    /// Removes characters from the front of the receive buffer, after they have been
+    /// examined with readBuffer()
+    /// \param[in] count The number of characters to remove. Must not be more than readBuffer() returned.
+    void consume(int count);
+
     /// Transmit a single character oin the serial port.
     /// Returns immediately.
     /// IO errors are repored by printing aa message to stderr.
@@ -74,6 +100,14 @@ public:
     /// \return 1 if successful else 0
     size_t write(uint8_t ch);
 
+    /// Transmit a buffer of characters on the serial port, with as few system calls as possible.
+    /// Blocks until all the characters have been accepted by the device.
+    /// IO errors are repored by printing aa message to stderr.
+    /// \param[in] buf The characters to send
+    /// \param[in] len The number of characters to send
+    /// \return The number of characters sent
+    size_t write(const uint8_t* buf, size_t len);
+
     // These are not usually in HardwareSerial but we 
     // need them in a Unix environment
 
@@ -86,15 +120,37 @@ public:
     /// \return true if a message is available as reported by available()
     bool waitAvailableTimeout(uint16_t timeout);
 
+    /// Returns the file descriptor of the open device, so it can be added to a poll() or epoll()
+    /// event loop that also waits for other drivers. When the descriptor becomes readable, call available()
+    /// (or RH_Serial::available()) to collect the characters.
+    /// Caution: characters may already be buffered, even if the descriptor is not readable.
+    /// Check available() before waiting.
+    /// \return The file descriptor, or -1 if the device is not open
+    int fd() { return _device; }
+
 protected:
     bool openDevice();
     bool closeDevice();
     bool setBaud(int baud);
 
+    /// Reads as many characters as are waiting in the device into the empty receive buffer,
+    /// without blocking.
+    /// \return The number of characters now in the receive buffer
+    int  fillBuffer();
+
 private:
     const char* _deviceName;
     int         _device; // file desriptor
     int         _baud;
+
+    /// Received characters not yet read
+    uint8_t     _rxBuf[RH_HARDWARESERIAL_RX_BUF_LEN];
+
+    /// Index in _rxBuf of the next character to read
+    int         _rxHead;
+
+    /// Index in _rxBuf after the last buffered character
+    int         _rxTail;
 };
 
 #endif
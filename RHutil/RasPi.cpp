@@ -92,6 +92,11 @@ void digitalWrite(unsigned char pin, unsigned char value)
   bcm2835_gpio_write(pin,value);
 }
 
+unsigned char digitalRead(unsigned char pin)
+{
+  return bcm2835_gpio_lev(pin);
+}
+
 unsigned long millis()
 {
   //Declare a variable to store current time
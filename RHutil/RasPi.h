@@ -24,6 +24,10 @@ typedef unsigned char byte;
   #define OUTPUT BCM2835_GPIO_FSEL_OUTP
 #endif
 
+#ifndef INPUT
+  #define INPUT BCM2835_GPIO_FSEL_INPT
+#endif
+
 class SPIClass
 {
   public:
@@ -66,6 +70,8 @@ void pinMode(unsigned char pin, unsigned char mode);
 
 void digitalWrite(unsigned char pin, unsigned char value);
 
+unsigned char digitalRead(unsigned char pin);
+
 unsigned long millis();
 
 void delay (unsigned long delay);
@@ -1685,6 +1685,23 @@ these examples and explanations and extend them to suit your needs.
 // Specifies an invalid IO pin selection
 #define RH_INVALID_PIN       0xff
 
+// Octets of reassembly memory in each RHFragmentedDatagram, shared by all the messages being received at once.
+// Each message needs its length plus 1 bit per fragment. Kept small on processors with little RAM.
+// Increase it to receive bigger messages (eg -DRH_FRAGMENT_POOL_LEN=65535 on Linux),
+// or reduce it if you only use streaming receive
+#ifndef RH_FRAGMENT_POOL_LEN
+ #if defined(__AVR__) || (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8) || (RH_PLATFORM == RH_PLATFORM_ATTINY) || (RH_PLATFORM == RH_PLATFORM_ATTINY_MEGA) || (RH_PLATFORM == RH_PLATFORM_MSP430)
+  #define RH_FRAGMENT_POOL_LEN 128
+ #else
+  #define RH_FRAGMENT_POOL_LEN 1024
+ #endif
+#endif
+
+// Compile time check for use inside constant expressions, such as the modem configuration generator macros
+// in some drivers. Evaluates to 0 if cond is true, and fails to compile (with a negative array size error) if it is false.
+// Works with all C++ versions, so can be used in PROGMEM table initialisers
+#define RH_CONFIG_CHECK(cond) (0 * sizeof(char[(cond) ? 1 : -1]))
+
 // Uncomment this is to enable Encryption (see RHEncryptedDriver):
 // But ensure you have installed the Crypto directory from arduinolibs first:
 // http://rweather.github.io/arduinolibs/index.html
@@ -0,0 +1,73 @@
+// nrf24_burst_client.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to send bursts of messages back to back
+// with the RH_NRF24 class, using sendBurst() and waitBurstSent().
+// The nRF24 hardware acknowledges and retransmits each message (auto-ack), so 
+// burstSent() and burstFailed() tell how many of the messages in each burst were delivered.
+// It is designed to work with the other example nrf24_burst_server.
+
+#include <SPI.h>
+#include <RH_NRF24.h>
+
+#define CLIENT_ADDRESS 1
+#define SERVER_ADDRESS 2
+
+// The number of messages in each burst
+#define BURST_LEN 100
+
+// Singleton instance of the radio driver
+RH_NRF24 nrf24;
+// RH_NRF24 nrf24(8, 7); // use this to be electrically compatible with Mirf
+// RH_NRF24 nrf24(8, 10);// For Leonardo, need explicit SS pin
+// RH_NRF24 nrf24(8, 7); // For RFM73 on Anarduino Mini
+
+void setup() 
+{
+  Serial.begin(9600);
+  while (!Serial) 
+    ; // wait for serial port to connect. Needed for Leonardo only
+  if (!nrf24.init())
+    Serial.println("init failed");
+  // Defaults after init are 2.402 GHz (channel 2), 2Mbps, 0dBm
+  if (!nrf24.setChannel(1))
+    Serial.println("setChannel failed");
+  if (!nrf24.setRF(RH_NRF24::DataRate2Mbps, RH_NRF24::TransmitPower0dBm))
+    Serial.println("setRF failed");    
+  // Up to 15 retries, 500 microseconds apart
+  if (!nrf24.setAutoAck(true, 15, 500))
+    Serial.println("setAutoAck failed");
+  nrf24.setThisAddress(CLIENT_ADDRESS);
+  nrf24.setHeaderFrom(CLIENT_ADDRESS);
+  nrf24.setHeaderTo(SERVER_ADDRESS);
+}
+
+void loop()
+{
+  Serial.println("Sending a burst to nrf24_burst_server");
+  uint8_t data[RH_NRF24_MAX_MESSAGE_LEN];
+  uint16_t i;
+  unsigned long start = millis();
+  for (i = 0; i < BURST_LEN; i++)
+  {
+    // Each message carries its number in the burst
+    memset(data, 0, sizeof(data));
+    data[0] = i >> 8;
+    data[1] = i & 0xff;
+    if (!nrf24.sendBurst(data, sizeof(data)))
+    {
+      Serial.println("sendBurst failed");
+      break;
+    }
+  }
+  bool ok = nrf24.waitBurstSent();
+  unsigned long elapsed = millis() - start;
+
+  Serial.print(ok ? "burst complete: " : "burst incomplete: ");
+  Serial.print(nrf24.burstSent());
+  Serial.print(" sent, ");
+  Serial.print(nrf24.burstFailed());
+  Serial.print(" failed in ");
+  Serial.print(elapsed);
+  Serial.println(" ms");
+  delay(2000);
+}
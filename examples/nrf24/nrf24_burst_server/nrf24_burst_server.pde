@@ -0,0 +1,65 @@
+// nrf24_burst_server.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to receive bursts of messages with the RH_NRF24 class
+// and hardware acknowledgement (auto-ack).
+// Counts the messages received, and reports once a second.
+// It is designed to work with the other example nrf24_burst_client.
+
+#include <SPI.h>
+#include <RH_NRF24.h>
+
+#define CLIENT_ADDRESS 1
+#define SERVER_ADDRESS 2
+
+// Singleton instance of the radio driver
+RH_NRF24 nrf24;
+// RH_NRF24 nrf24(8, 7); // use this to be electrically compatible with Mirf
+// RH_NRF24 nrf24(8, 10);// For Leonardo, need explicit SS pin
+// RH_NRF24 nrf24(8, 7); // For RFM73 on Anarduino Mini
+
+uint32_t received = 0;
+unsigned long lastReport = 0;
+
+void setup() 
+{
+  Serial.begin(9600);
+  while (!Serial) 
+    ; // wait for serial port to connect. Needed for Leonardo only
+  if (!nrf24.init())
+    Serial.println("init failed");
+  // Defaults after init are 2.402 GHz (channel 2), 2Mbps, 0dBm
+  if (!nrf24.setChannel(1))
+    Serial.println("setChannel failed");
+  if (!nrf24.setRF(RH_NRF24::DataRate2Mbps, RH_NRF24::TransmitPower0dBm))
+    Serial.println("setRF failed");    
+  // Must agree with the client
+  if (!nrf24.setAutoAck(true, 15, 500))
+    Serial.println("setAutoAck failed");
+  nrf24.setThisAddress(SERVER_ADDRESS);
+  nrf24.setHeaderFrom(SERVER_ADDRESS);
+  nrf24.setHeaderTo(CLIENT_ADDRESS);
+}
+
+void loop()
+{
+  uint8_t buf[RH_NRF24_MAX_MESSAGE_LEN];
+  uint8_t len = sizeof(buf);
+  // Empty the RX FIFO as fast as possible, so the burst is not slowed down
+  while (nrf24.recv(buf, &len))
+  {
+    received++;
+    len = sizeof(buf);
+  }
+
+  if (millis() - lastReport > 1000)
+  {
+    if (received)
+    {
+      Serial.print("received ");
+      Serial.print(received);
+      Serial.println(" messages");
+    }
+    received = 0;
+    lastReport = millis();
+  }
+}
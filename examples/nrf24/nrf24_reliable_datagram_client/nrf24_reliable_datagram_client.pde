@@ -28,6 +28,9 @@ void setup()
   if (!manager.init())
     Serial.println("init failed");
   // Defaults after init are 2.402 GHz (channel 2), 2Mbps, 0dBm
+  // Uncomment to have the radio do the ACKs and retransmissions itself.
+  // Must be the same on client and server
+  //driver.setAutoAck(true);
 }
 
 uint8_t data[] = "Hello World!";
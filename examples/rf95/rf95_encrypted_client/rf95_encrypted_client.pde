@@ -31,6 +31,8 @@ void setup()
   // Setup Power,dBm
   rf95.setTxPower(13);
   myCipher.setKey(encryptkey, sizeof(encryptkey));
+  // Uncomment for authenticated encryption with an 8 octet tag. The other end must do the same
+  //myDriver.setAEAD(8);
   Serial.println("Waiting for radio to setup");
   delay(1000);
   Serial.println("Setup completed");
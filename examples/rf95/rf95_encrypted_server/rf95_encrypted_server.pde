@@ -27,6 +27,8 @@ void setup() {
   // Setup Power,dBm
   rf95.setTxPower(13);
   myCipher.setKey(encryptkey, 16);
+  // Uncomment for authenticated encryption with an 8 octet tag. The other end must do the same
+  //myDriver.setAEAD(8);
   delay(4000);
   Serial.println("Setup completed");
 }
@@ -0,0 +1,53 @@
+// simulator_ask_multi_receiver.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to use RH_ASKMultiReceiver on Linux to demodulate messages from up to 8 
+// ASK/OOK receivers at once, such as receivers on different frequencies connected to GPIO pins 
+// sampled together by a logic analyser or a GPIO sampling program.
+// Reads samples from the file named on the command line, or stdin, and exits at the end of the samples.
+// Each sample is one octet, with bit 0 from the receiver for channel 0 etc, at 8 samples per bit (16kHz at 2000bps).
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_multi_receiver/simulator_ask_multi_receiver.pde
+// Run with ./simulator_ask_multi_receiver capture.raw
+
+#include <RH_ASK.h>
+
+RH_ASKMultiReceiver receiver(8);
+RHASKFileSampleSource source; // stdin
+
+void setup()
+{
+  if (_simulator_argc > 1 && !source.open(_simulator_argv[1]))
+  {
+    fprintf(stderr, "could not open %s\n", _simulator_argv[1]);
+    exit(1);
+  }
+  receiver.setSampleSource(&source);
+}
+
+void loop()
+{
+  uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+  uint8_t buflen;
+  uint8_t ready = receiver.available();
+  uint8_t channel;
+
+  for (channel = 0; channel < receiver.channels(); channel++)
+  {
+    buflen = sizeof(buf);
+    if ((ready & (1 << channel)) && receiver.recv(channel, buf, &buflen))
+    {
+      printf("channel %d: ", channel);
+      RHGenericDriver::printBuffer("Got:", buf, buflen);
+    }
+  }
+  if (!ready && source.atEnd())
+  {
+    for (channel = 0; channel < receiver.channels(); channel++)
+      printf("channel %d: good %d bad %d\n", channel, receiver.rxGood(channel), receiver.rxBad(channel));
+    exit(0);
+  }
+  if (!ready)
+    delay(1); // Wait for more samples
+}
@@ -0,0 +1,48 @@
+// simulator_ask_sample_receiver.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to use RH_ASK on Linux to demodulate messages from a stream of samples,
+// such as a recorded capture, or a sound card connected to a cheap 433MHz OOK receiver.
+// Reads 8 bit unsigned samples at 48kHz from the file named on the command line, or stdin,
+// and exits at the end of the samples.
+// It is designed to work with the other example simulator_ask_sample_transmitter
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_sample_receiver/simulator_ask_sample_receiver.pde
+// Run with ./simulator_ask_sample_receiver capture.raw
+// or live: arecord -t raw -f U8 -r 48000 -c 1 | ./simulator_ask_sample_receiver
+
+#include <RH_ASK.h>
+
+#define SAMPLE_RATE 48000
+
+RH_ASK driver(2000);
+RHASKFileSampleSource source; // stdin
+
+void setup()
+{
+  if (_simulator_argc > 1 && !source.open(_simulator_argv[1]))
+  {
+    fprintf(stderr, "could not open %s\n", _simulator_argv[1]);
+    exit(1);
+  }
+  if (!driver.init())
+    fprintf(stderr, "init failed\n");
+  driver.setSampleSource(&source, SAMPLE_RATE);
+}
+
+void loop()
+{
+  uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+  uint8_t buflen = sizeof(buf);
+
+  if (driver.recv(buf, &buflen))
+    driver.printBuffer("Got:", buf, buflen);
+  else if (source.atEnd())
+  {
+    printf("good %d bad %d\n", driver.rxGood(), driver.rxBad());
+    exit(0);
+  }
+  else
+    delay(1); // Wait for more samples
+}
@@ -0,0 +1,47 @@
+// simulator_ask_sample_transmitter.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to use RH_ASK on Linux to modulate messages into a stream of samples, 
+// such as for a sound card connected to an OOK transmitter, or to make a capture for testing
+// the receiver. Writes 8 bit unsigned samples at 48kHz to the file named on the command line, or stdout.
+// It is designed to work with the other example simulator_ask_sample_receiver
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_sample_transmitter/simulator_ask_sample_transmitter.pde
+// Run with ./simulator_ask_sample_transmitter capture.raw
+// or to play it: ./simulator_ask_sample_transmitter | aplay -t raw -f U8 -r 48000
+
+#include <RH_ASK.h>
+
+#define SAMPLE_RATE 48000
+#define NUM_MESSAGES 10
+
+RH_ASK driver(2000);
+RHASKFileSampleSource source(-1, 1);
+
+void setup()
+{
+  if (_simulator_argc > 1 && !source.open(NULL, _simulator_argv[1]))
+  {
+    fprintf(stderr, "could not open %s\n", _simulator_argv[1]);
+    exit(1);
+  }
+  if (!driver.init())
+    fprintf(stderr, "init failed\n");
+  driver.setSampleSource(&source, SAMPLE_RATE);
+}
+
+void loop()
+{
+  static int count = 0;
+  char msg[20];
+  uint8_t silence[SAMPLE_RATE / 100]; // 10ms
+
+  snprintf(msg, sizeof(msg), "hello %d", count);
+  driver.send((uint8_t *)msg, strlen(msg));
+  driver.waitPacketSent(); // Writes the samples
+  memset(silence, 0, sizeof(silence));
+  source.write(silence, sizeof(silence));
+  if (++count >= NUM_MESSAGES)
+    exit(0);
+}
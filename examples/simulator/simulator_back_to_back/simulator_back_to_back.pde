@@ -0,0 +1,87 @@
+// simulator_back_to_back.pde
+// -*- mode: C++ -*-
+// Test sketch for the 'Luminiferous Ether' simulators, with the RHReliableDatagram class
+// and the RH_TCP driver. Node 2 answers each request from node 1 with its ACK
+// immediately followed by a reply, so both of its packets are on the air back to back.
+// They must never be lost as a collision with each other: node 1 reports how many exchanges
+// needed a retransmission, which should be none on a perfect simulated link.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead 
+// tools/simBuild examples/simulator/simulator_back_to_back/simulator_back_to_back.pde
+// Run with
+// tools/etherSimulatorDgram &
+// RH_TCP_SERVER=udp:localhost:4000 ./simulator_back_to_back 2 &
+// RH_TCP_SERVER=udp:localhost:4000 ./simulator_back_to_back 1
+// Node 1 exits with status 0 if all the exchanges succeeded without retransmission
+
+#include <RHReliableDatagram.h>
+#include <RH_TCP.h>
+
+#define CLIENT_ADDRESS 1
+#define SERVER_ADDRESS 2
+
+// The number of request and reply exchanges node 1 makes
+#define EXCHANGES 200
+
+// Singleton instance of the radio driver
+RH_TCP driver;
+
+// Class to manage message delivery and receipt, using the driver declared above
+RHReliableDatagram manager(driver, CLIENT_ADDRESS);
+
+uint8_t request[] = "Request";
+uint8_t reply[] = "Reply";
+// Dont put this on the stack:
+uint8_t buf[RH_TCP_MAX_MESSAGE_LEN];
+
+void setup() 
+{
+  Serial.begin(9600);
+  if (!manager.init())
+  {
+    Serial.println("init failed");
+    exit(1);
+  }
+  // Node address from the command line
+  if (_simulator_argc >= 2)
+     manager.setThisAddress(atoi(_simulator_argv[1]));
+}
+
+void loop()
+{
+  uint8_t len = sizeof(buf);
+  uint8_t from;
+
+  if (manager.thisAddress() != CLIENT_ADDRESS)
+  {
+    // Answer each request with the ACK and then the reply, back to back.
+    // Exit when the client has gone quiet
+    if (manager.recvfromAckTimeout(buf, &len, 5000, &from))
+      manager.sendtoWait(reply, sizeof(reply), from);
+    else
+      exit(0);
+    return;
+  }
+
+  uint16_t replies = 0;
+  uint16_t retried = 0;
+  for (uint16_t i = 0; i < EXCHANGES; i++)
+  {
+    uint32_t before = manager.retransmissions();
+    len = sizeof(buf);
+    if (   manager.sendtoWait(request, sizeof(request), SERVER_ADDRESS)
+	&& manager.recvfromAckTimeout(buf, &len, 1000, &from))
+      replies++;
+    if (manager.retransmissions() != before)
+      retried++;
+  }
+  Serial.print("replies: ");
+  Serial.print((unsigned int)replies);
+  Serial.print(" of ");
+  Serial.print((unsigned int)EXCHANGES);
+  Serial.print(", exchanges with retransmissions: ");
+  Serial.print((unsigned int)retried);
+  Serial.println("");
+  exit(replies == EXCHANGES && !retried ? 0 : 1);
+}
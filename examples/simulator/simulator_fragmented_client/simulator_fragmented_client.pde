@@ -0,0 +1,73 @@
+// simulator_fragmented_client.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to send messages much larger than the driver can carry
+// with the RHFragmentedDatagram class, using the RH_SIMULATOR driver to control a SIMULATOR radio.
+// It is designed to work with the other example simulator_fragmented_server
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_fragmented_client/simulator_fragmented_client.pde
+// Run with ./simulator_fragmented_client
+// Make sure you also have the 'Luminiferous Ether' simulator tools/etherSimulator.pl running
+
+#include <RHFragmentedDatagram.h>
+#include <RH_TCP.h>
+
+#define CLIENT_ADDRESS 1
+#define SERVER_ADDRESS 2
+
+// Singleton instance of the radio driver
+RH_TCP driver;
+
+// Class to manage message delivery and receipt, using the driver declared above
+RHFragmentedDatagram manager(driver, CLIENT_ADDRESS);
+
+void setup()
+{
+  Serial.begin(9600);
+  if (!manager.init())
+    Serial.println("init failed");
+
+  // Maybe set this address from teh command line
+  if (_simulator_argc >= 2)
+     manager.setThisAddress(atoi(_simulator_argv[1]));
+}
+
+// Dont put this on the stack:
+uint8_t data[1000];
+uint8_t buf[100];
+
+void loop()
+{
+  // Fill the message with a pattern the server can check
+  for (uint16_t i = 0; i < sizeof(data); i++)
+    data[i] = i & 0xff;
+
+  Serial.println("Sending to simulator_fragmented_server");
+
+  // Send a message to manager_server
+  if (manager.sendtoWait(data, sizeof(data), SERVER_ADDRESS))
+  {
+    // Now wait for a reply from the server
+    uint16_t len = sizeof(buf);
+    uint8_t from;
+    if (manager.recvfromTimeout(buf, &len, 2000, &from))
+    {
+      Serial.print("got reply from : 0x");
+      Serial.print(from, HEX);
+      Serial.print(": ");
+      Serial.println((char*)buf);
+    }
+    else
+    {
+      Serial.println("No reply, is simulator_fragmented_server running?");
+    }
+  }
+  else
+    Serial.println("sendtoWait failed");
+  Serial.print("retransmissions: ");
+  Serial.print((unsigned int)manager.retransmissions());
+  Serial.println("");
+  delay(500);
+}
+
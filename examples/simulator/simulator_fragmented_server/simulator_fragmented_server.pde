@@ -0,0 +1,61 @@
+// simulator_fragmented_server.pde
+// -*- mode: C++ -*-
+// Example sketch showing how to receive messages much larger than the driver can carry
+// with the RHFragmentedDatagram class, using the RH_SIMULATOR driver to control a SIMULATOR radio.
+// It is designed to work with the other example simulator_fragmented_client
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_fragmented_server/simulator_fragmented_server.pde
+// Run with ./simulator_fragmented_server
+// Make sure you also have the 'Luminiferous Ether' simulator tools/etherSimulator.pl running
+
+#include <RHFragmentedDatagram.h>
+#include <RH_TCP.h>
+
+#define CLIENT_ADDRESS 1
+#define SERVER_ADDRESS 2
+
+// Singleton instance of the radio driver
+RH_TCP driver;
+
+// Class to manage message delivery and receipt, using the driver declared above
+RHFragmentedDatagram manager(driver, SERVER_ADDRESS);
+
+void setup()
+{
+  Serial.begin(9600);
+  if (!manager.init())
+    Serial.println("init failed");
+}
+
+uint8_t data[] = "And hello back to you";
+// Dont put this on the stack:
+uint8_t buf[RH_FRAGMENT_POOL_LEN];
+
+void loop()
+{
+  // Wait for a message addressed to us from the client
+  manager.waitAvailable();
+
+  uint16_t len = sizeof(buf);
+  uint8_t from;
+  if (manager.recvfrom(buf, &len, &from))
+  {
+      // Check the pattern sent by the client
+      uint16_t i;
+      for (i = 0; i < len; i++)
+	  if (buf[i] != (i & 0xff))
+	      break;
+      Serial.print("got request from : 0x");
+      Serial.print(from, HEX);
+      Serial.print(": ");
+      Serial.print((unsigned int)len);
+      Serial.println(i == len ? " octets OK" : " octets corrupted");
+
+      // Send a reply back to the originator client
+      if (!manager.sendtoWait(data, sizeof(data), from))
+	  Serial.println("sendtoWait failed");
+  }
+}
+
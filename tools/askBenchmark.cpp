@@ -0,0 +1,158 @@
+// askBenchmark.cpp
+//
+// Microbenchmark for the RH_ASK receiver on Linux.
+// Checks the 6 bit symbol decoder against the symbol table and times it on its own,
+// then times the whole receiver handler per timer tick on a stream of modulated messages,
+// and checks the messages are received.
+// The ticks that complete an octet and decode it are the slowest, and limit the bit rate
+// the timer interrupt can sustain, so on x86 they are also counted separately in CPU cycles.
+// Build and run it with the symbol lookup table and the linear search with tools/askBenchmark
+
+#include <RH_ASK.h>
+#include <sys/time.h>
+#if defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+ #define HAVE_RDTSC
+#endif
+
+SerialSimulator Serial;
+int    _simulator_argc;
+char** _simulator_argv;
+unsigned long millis() { return 0; }
+void delay(unsigned long ms) { (void)ms; }
+long random(long to) { return random() % to; }
+long random(long from, long to) { return from + random() % (to - from); }
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// Gives access to the protected decoders
+class BenchASK : public RH_ASK
+{
+public:
+    uint8_t decode6(uint8_t symbol) { return symbol_6to4(symbol);}
+    int16_t decode12(uint16_t bits) { return symbol_12to8(bits);}
+    uint8_t rxBufLen() { return _rxBufLen;}
+};
+
+// The 16 valid 6 bit symbols, from the RH_ASK specification, in nybble order
+static const uint8_t ref_symbols[16] =
+{
+    0xd,  0xe,  0x13, 0x15, 0x16, 0x19, 0x1a, 0x1c, 
+    0x23, 0x25, 0x26, 0x29, 0x2a, 0x2c, 0x32, 0x34
+};
+
+// Nybble for a 6 bit symbol by linear search of the reference, -1 if invalid
+static int16_t ref_decode6(uint8_t symbol)
+{
+    for (uint8_t i = 0; i < 16; i++)
+	if (ref_symbols[i] == symbol)
+	    return i;
+    return -1;
+}
+
+#define NUM_MESSAGES 100
+static uint8_t samples[NUM_MESSAGES * 8000];
+
+int main(int argc, char** argv)
+{
+    uint32_t reps = argc > 1 ? atol(argv[1]) : 1000;
+    BenchASK tx, rx;
+    uint32_t len = 0, i, r;
+    uint32_t sum = 0;
+
+#ifdef RH_ASK_SYMBOL_SEARCH
+    printf("RH_ASK_SYMBOL_SEARCH, %lu repetitions\n", (unsigned long)reps);
+#else
+    printf("symbol lookup table, %lu repetitions\n", (unsigned long)reps);
+#endif
+
+    // Check every 6 bit symbol against the reference, including the invalid ones,
+    // which symbol_12to8 rejects and symbol_6to4 decodes as 0
+    bool match = true;
+    for (i = 0; i < 64; i++)
+    {
+	int16_t ref = ref_decode6(i);
+	if (   tx.decode6(i) != (ref < 0 ? 0 : ref)
+	    || tx.decode12(i | (ref_symbols[0] << 6)) != (ref < 0 ? -1 : ref << 4))
+	    match = false;
+    }
+    printf("symbols      %s\n", match ? "ok" : "MISMATCH");
+
+    // Decode every possible pair of symbols
+    double t0 = now();
+    for (r = 0; r < reps * 10; r++)
+	for (i = 0; i < 4096; i++)
+	    sum += tx.decode12((i + r) & 0xfff);
+    double t1 = now();
+    printf("symbol_12to8 %8.2f ns per octet (%lu)\n", (t1 - t0) * 1e9 / (reps * 10 * 4096.0), (unsigned long)sum);
+    // Valid symbols only, as received in a good message
+    for (r = 0; r < reps * 10; r++)
+	for (i = 0; i < 4096; i++)
+	    sum += tx.decode6(ref_symbols[(i + r) & 0xf]);
+    double t2 = now();
+    printf("symbol_6to4  %8.2f ns per symbol (%lu)\n", (t2 - t1) * 1e9 / (reps * 10 * 4096.0), (unsigned long)sum);
+
+    // Modulate some messages, 1 sample per timer tick
+    tx.init();
+    tx.setSampleSource(NULL);
+    for (i = 0; i < NUM_MESSAGES; i++)
+    {
+	uint8_t msg[RH_ASK_MAX_MESSAGE_LEN];
+	memset(msg, i, sizeof(msg));
+	tx.send(msg, sizeof(msg));
+	len += tx.transmitSamples(samples + len, sizeof(samples) - len);
+	memset(samples + len, 0, 100);
+	len += 100;
+    }
+
+    // Demodulate them
+    rx.init();
+    rx.setSampleSource(NULL);
+    uint32_t good = 0;
+    double t3 = now();
+    for (r = 0; r < reps / 10 + 1; r++)
+    {
+	uint32_t index = 0;
+	while (index < len)
+	{
+	    index += rx.receiveSamples(samples + index, len - index);
+	    if (rx.available())
+	    {
+		rx.recv(NULL, NULL);
+		good++;
+	    }
+	}
+    }
+    double t4 = now();
+    printf("receiver     %8.2f ns per tick, %lu of %lu messages received\n",
+	   (t4 - t3) * 1e9 / ((reps / 10 + 1) * (double)len),
+	   (unsigned long)good, (unsigned long)(NUM_MESSAGES * (reps / 10 + 1)));
+
+#ifdef HAVE_RDTSC
+    // Cycles per tick, one tick at a time, separating the ticks that decode an octet
+    uint64_t cycles[2] = { 0, 0 }, ticks[2] = { 0, 0 }, worst = 0;
+    uint32_t index = 0;
+    while (index < len)
+    {
+	uint8_t before = rx.rxBufLen();
+	uint64_t c0 = __rdtsc();
+	index += rx.receiveSamples(samples + index, 1);
+	uint64_t c = __rdtsc() - c0;
+	uint8_t decoded = rx.rxBufLen() != before;
+	cycles[decoded] += c;
+	ticks[decoded]++;
+	if (decoded && c > worst)
+	    worst = c;
+	if (rx.available())
+	    rx.recv(NULL, NULL);
+    }
+    printf("cycles       %8.1f per tick, %8.1f per decoding tick, worst %lu (including rdtsc)\n",
+	   (double)cycles[0] / ticks[0], (double)cycles[1] / ticks[1], (unsigned long)worst);
+#endif
+    return match && good == NUM_MESSAGES * (reps / 10 + 1) ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+// crcBenchmark.cpp
+//
+// Microbenchmark for the RadioHead CRC routines in RHCRC.cpp on Linux.
+// Times the octet at a time _update functions against the buffer _buf functions
+// for a maximum size packet and a large block, and checks both against a bitwise reference
+// implementation here, independent of RH_CRC_METHOD.
+// Build and run it for each RH_CRC_METHOD with tools/crcBenchmark
+
+#include <RHCRC.h>
+#include <sys/time.h>
+
+static uint8_t data[65535];
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// Bitwise reference CRCs, shift right for the reflected polynomials and left for xmodem
+static uint16_t ref_reflected(uint16_t crc, const uint8_t* buf, uint16_t len, uint16_t poly)
+{
+    while (len--)
+    {
+	crc ^= *buf++;
+	for (uint8_t i = 0; i < 8; i++)
+	    crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+    }
+    return crc;
+}
+
+static uint16_t ref_xmodem(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+    {
+	crc ^= (uint16_t)*buf++ << 8;
+	for (uint8_t i = 0; i < 8; i++)
+	    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+    return crc;
+}
+
+static uint16_t ref_crc16(uint16_t crc, const uint8_t* buf, uint16_t len) { return ref_reflected(crc, buf, len, 0xa001); }
+static uint16_t ref_ccitt(uint16_t crc, const uint8_t* buf, uint16_t len) { return ref_reflected(crc, buf, len, 0x8408); }
+static uint8_t ref_ibutton(uint8_t crc, const uint8_t* buf, uint16_t len) { return ref_reflected(crc, buf, len, 0x8c); }
+
+// Runs one CRC both ways over len octets, for about total octets, and prints MB/s for each
+#define BENCH(name, type, init, update, buffer, reference)		\
+    {									\
+	type c1 = init, c2 = init, c3 = init;				\
+	uint32_t reps = total / len, r;					\
+	uint16_t i;							\
+	double t0 = now();						\
+	for (r = 0; r < reps; r++)					\
+	    for (i = 0; i < len; i++)					\
+		c1 = update(c1, data[i]);				\
+	double t1 = now();						\
+	for (r = 0; r < reps; r++)					\
+	    c2 = buffer(c2, data, len);					\
+	double t2 = now();						\
+	for (r = 0; r < reps; r++)					\
+	    c3 = reference(c3, data, len);				\
+	bool match = c1 == c3 && c2 == c3;				\
+	printf("%-8s %5u  update %8.1f MB/s  buf %8.1f MB/s  %s\n",	\
+	       name, len, total / (t1 - t0) / 1e6, total / (t2 - t1) / 1e6, \
+	       match ? "ok" : "MISMATCH");				\
+	if (!match) ok = false;						\
+    }
+
+int main(int argc, char** argv)
+{
+    uint32_t total = argc > 1 ? atol(argv[1]) : 100000000;
+    uint16_t lens[] = { 255, 65535 };
+    bool ok = true;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(data); i++)
+	data[i] = (i * 2654435761u) >> 24;
+
+    printf("RH_CRC_METHOD %d, %lu octets per test\n", RH_CRC_METHOD, (unsigned long)total);
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+	uint16_t len = lens[i];
+	BENCH("crc16",   uint16_t, 0xffff, RHcrc16_update,       RHcrc16_buf,       ref_crc16);
+	BENCH("xmodem",  uint16_t, 0x0000, RHcrc_xmodem_update,  RHcrc_xmodem_buf,  ref_xmodem);
+	BENCH("ccitt",   uint16_t, 0xffff, RHcrc_ccitt_update,   RHcrc_ccitt_buf,   ref_ccitt);
+	BENCH("ibutton", uint8_t,  0x00,   RHcrc_ibutton_update, RHcrc_ibutton_buf, ref_ibutton);
+    }
+    return ok ? 0 : 1;
+}
@@ -21,8 +21,14 @@ $bps = $main::opt_b
 # Config that shows probability of successful transmission between nodes
 # Read from config file
 my %netconfig;
+# Config that shows the RSSI and SNR of the link between nodes
+my %linkconfig;
+# RSSI in dBm and SNR in dB for links not in the config file
+my $default_rssi = -50;
+my $default_snr = 10;
 
 use warnings;
+use Time::HiRes;
 use POE qw(Component::Server::TCP Filter::Block);
 use strict;
 
@@ -53,6 +59,9 @@ sub usage
 # In this example, the probability of successful transmission
 # between nodes 10 and 2 (and vice versa) is given as 0.5 (ie 50% chance)
 # probability:10:2:0.5
+# Specify the RSSI (dBm) and SNR (dB) reported by nodeb when receiving from nodea (and vice versa)
+# link:nodea:nodeb:rssi:snr
+# link:10:2:-95:-3
 sub readConfig
 {
     my ($config) = @_;
@@ -66,6 +75,11 @@ sub readConfig
 		$netconfig{$1}{$2} = $3;
 		$netconfig{$2}{$1} = $3; # Bidirectional
 	    }
+	    elsif (/^link:(\d{1,3}):(\d{1,3}):(-?\d+):(-?\d+)/)
+	    {
+		$linkconfig{$1}{$2} = [$3, $4];
+		$linkconfig{$2}{$1} = [$3, $4]; # Bidirectional
+	    }
 	}
 	close(CONFIG);
     }
@@ -102,6 +116,11 @@ my $filter = POE::Filter::Block->new( LengthCodec => [ \&encoder, \&decoder ] );
 my $RH_TCP_MESSAGE_TYPE_NOP                = 0; # Not used
 my $RH_TCP_MESSAGE_TYPE_THISADDRESS        = 1; # Specifies the thisAddress of the connected sketch
 my $RH_TCP_MESSAGE_TYPE_PACKET             = 2; # Message to/from the connected sketch
+my $RH_TCP_MESSAGE_TYPE_VERSION            = 3; # Protocol version negotiation
+my $RH_TCP_MESSAGE_TYPE_PACKET_EXT         = 4; # Message with radio parameters, protocol version 2
+
+# The highest protocol version we support
+my $RH_TCP_PROTOCOL_VERSION = 2;
 
 my %clients;
 
@@ -117,6 +136,16 @@ sub probabilityOfSuccessfulDelivery
     return 1.0;
 }
 
+# Return the RSSI and SNR of a message from one node as received by another
+sub linkQuality
+{
+    my ($from, $to) = @_;
+
+    return @{$linkconfig{$from}{$to}}
+        if exists $linkconfig{$from}{$to};
+    return ($default_rssi, $default_snr);
+}
+
 # Return true if the message is simulted to have been received successfully
 # taking into account the probability of sucessful delivery
 sub willDeliverFromTo
@@ -132,18 +161,47 @@ sub willDeliverFromTo
 sub deliverMessages
 {
     my ($key, $value);
+    my $now = Time::HiRes::time();
     while (($key, $value) = each(%clients))
     {
-	next unless defined $$value{'packet'}; # No packet waiting for delivery
-	# Find how long since the message was transmitted and see it its time to 
-	# deliver it to the client.
-	# We are waiting here for the transmission time of the message to elapse
-	# given the message length and the bits per second
-	my $elapsed = Time::HiRes::tv_interval([$$value{'packetreceived'}], [Time::HiRes::gettimeofday]);
-	if ($elapsed > length($$value{'packet'}) * 8 / $bps)
+	# There may be packets waiting for delivery on each frequency and spreading factor
+	foreach my $channel (keys %{$$value{'packets'}})
 	{
-	    $$value{'client'}->put(pack('Ca*', $RH_TCP_MESSAGE_TYPE_PACKET, $$value{'packet'}));
-	    delete $$value{'packet'}; # Delivered, forget it
+	    my @waiting;
+	    foreach my $pending (@{$$value{'packets'}{$channel}})
+	    {
+		# We are waiting here for the transmission time of the message to elapse
+		# given the message length and the bits per second
+		if ($$pending{'end'} > $now)
+		{
+		    push(@waiting, $pending);
+		    next;
+		}
+
+		if ($$value{'version'} >= 2)
+		{
+		    # Include the radio parameters, and the simulated link quality
+		    my ($rssi, $snr) = linkQuality($$pending{'from'}, $$value{'thisaddress'});
+		    $$value{'client'}->put(pack('CncNCNNa*', $RH_TCP_MESSAGE_TYPE_PACKET_EXT,
+						$rssi & 0xffff, $snr,
+						$$pending{'frequency'}, $$pending{'spreadingfactor'},
+						$$pending{'txtimesec'}, $$pending{'txtimeusec'},
+						$$pending{'packet'}));
+		}
+		else
+		{
+		    $$value{'client'}->put(pack('Ca*', $RH_TCP_MESSAGE_TYPE_PACKET, $$pending{'packet'}));
+		}
+		# Delivered, forget it
+	    }
+	    if (@waiting)
+	    {
+		$$value{'packets'}{$channel} = \@waiting;
+	    }
+	    else
+	    {
+		delete $$value{'packets'}{$channel};
+	    }
 	}
     }
 }
@@ -167,7 +225,7 @@ POE::Component::Server::TCP->new(
     ClientConnected => sub {
 	my $client = $_[HEAP]{client};
 	# Create a new object to hold data about RH_TCP messages to and from this client
-	$clients{$client} = {'client' => $client};
+	$clients{$client} = {'client' => $client, 'version' => 1, 'packets' => {}};
     },
 
     ClientInput => sub {
@@ -182,10 +240,35 @@ POE::Component::Server::TCP->new(
 	    # Set the client objects thisaddress
 	    $clients{$client}{'thisaddress'} = $thisaddress;
 	}
-	elsif ($type == $RH_TCP_MESSAGE_TYPE_PACKET)
+	elsif ($type == $RH_TCP_MESSAGE_TYPE_VERSION)
+	{
+	    # Client tells us the highest protocol version it supports, reply with ours
+	    my ($length, $type, $version) = unpack('NCC', $client_input);
+	    $clients{$client}{'version'} = $version < $RH_TCP_PROTOCOL_VERSION ? $version : $RH_TCP_PROTOCOL_VERSION;
+	    $client->put(pack('CC', $RH_TCP_MESSAGE_TYPE_VERSION, $RH_TCP_PROTOCOL_VERSION));
+	}
+	elsif ($type == $RH_TCP_MESSAGE_TYPE_PACKET || $type == $RH_TCP_MESSAGE_TYPE_PACKET_EXT)
 	{
 	    # New packet for transmission
-	    my ($length, $type, $packet) = unpack('NCa*', $client_input);
+	    my ($length, $packet);
+	    # Version 1 packets are sent on frequency 0, spreading factor 0
+	    my ($rssi, $snr, $frequency, $sf, $txtimesec, $txtimeusec) = (0, 0, 0, 0, 0, 0);
+	    if ($type == $RH_TCP_MESSAGE_TYPE_PACKET_EXT)
+	    {
+		($length, $type, $rssi, $snr, $frequency, $sf, $txtimesec, $txtimeusec, $packet)
+		    = unpack('NCncNCNNa*', $client_input);
+	    }
+	    else
+	    {
+		($length, $type, $packet) = unpack('NCa*', $client_input);
+	    }
+	    # A radio sends one packet at a time, so a packet sent back to back with the previous one
+	    # (which its client timed itself) starts when that one ends, and never collides with it
+	    my $start = Time::HiRes::time();
+	    $start = $clients{$client}{'txend'}
+	        if defined $clients{$client}{'txend'} && $clients{$client}{'txend'} > $start;
+	    my $end = $start + length($packet) * 8 / $bps;
+	    $clients{$client}{'txend'} = $end;
 	    # Try to deliver the packet to all the other clients
 	    my ($key, $value);
 	    while (($key, $value) = each(%clients))
@@ -195,19 +278,35 @@ POE::Component::Server::TCP->new(
 		# Check the network config and see if delivery to this node is possible
 		next unless willDeliverFromTo($clients{$client}{'thisaddress'}, $$value{thisaddress});
 
-		# The packet reached this destination, see if it collided with 
-		# another packet
-		if (defined $$value{'packet'})
+		# Version 1 clients can only receive on frequency 0, spreading factor 0
+		next if $$value{'version'} < 2 && ($frequency || $sf);
+
+		# The packet reached this destination, see if it collided with a packet
+		# from another client on the same frequency and spreading factor, in the air at the same time
+		my $channel = "$frequency:$sf";
+		my @waiting = grep { $$_{'sender'} eq $client || $$_{'start'} >= $end || $start >= $$_{'end'} }
+		    @{$$value{'packets'}{$channel} || []};
+		if (@waiting != @{$$value{'packets'}{$channel} || []})
 		{
 		    # Collision with waiting packet, delete it
-		    delete $$value{'packet'};
+		    $$value{'packets'}{$channel} = \@waiting;
 		}
 		else
 		{
 		    # New packet, queue it for delivery to the client after the
 		    # nominal transmission time is complete
-		    $$value{'packet'} = $packet;
-		    $$value{'packetreceived'} = Time::HiRes::gettimeofday();
+		    push(@{$$value{'packets'}{$channel}},
+		    {
+			'packet'          => $packet,
+			'start'           => $start,
+			'end'             => $end,
+			'sender'          => "$client",
+			'from'            => $clients{$client}{'thisaddress'},
+			'frequency'       => $frequency,
+			'spreadingfactor' => $sf,
+			'txtimesec'       => $txtimesec,
+			'txtimeusec'      => $txtimeusec,
+		    });
 		}
 	    }
 	}
@@ -0,0 +1,468 @@
+// etherSimulatorDgram.cpp
+//
+// Simulates the luminiferous ether for RH_TCP clients, like etherSimulator.pl,
+// but over UDP or Unix domain datagram sockets instead of TCP. Every datagram waiting
+// is received with one recvmmsg() call, and all the messages due for delivery are
+// sent with one sendmmsg() call, so large simulations spend little time in system calls.
+// Uses the same config file format as etherSimulator.pl.
+// Build and run it with tools/etherSimulatorDgram
+// Part of the RadioHead library
+
+#include <RadioHead.h>
+#include <RHTcpProtocol.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <string>
+#include <map>
+#include <vector>
+
+// The most datagrams received or sent with one system call
+#define BATCH 256
+
+// A packet waiting for its simulated airtime to pass before delivery to a client
+typedef struct
+{
+    double          startAt;    // Monotonic time in seconds when the transmission starts
+    double          deliverAt;  // Monotonic time in seconds when the transmission ends
+    std::string     packet;     // The 4 headers and payload
+    std::string     sender;     // Key of the sending client in clients
+    int             from;       // thisAddress of the sender
+    uint32_t        frequency;
+    uint8_t         spreadingFactor;
+    uint32_t        txTimeSec;
+    uint32_t        txTimeUsec;
+} Pending;
+
+// A connected RH_TCP client, identified by its socket address
+typedef struct
+{
+    struct sockaddr_storage addr;
+    socklen_t       addrLen;
+    int             thisAddress; // -1 until the client tells us
+    uint8_t         version;     // Agreed RH_TCP_PROTOCOL_VERSION_*
+    double          txEnd;       // When the transmission of the last packet from this client ends
+    std::multimap<uint64_t, Pending> pending; // Keyed by frequency and spreading factor
+} Client;
+
+// A message waiting to be sent by sendmmsg()
+typedef struct
+{
+    std::string     data;       // Including the length
+    std::string     client;     // Key of the destination in clients
+} Outgoing;
+
+static std::map<std::string, Client> clients;
+static std::vector<Outgoing>         outgoing;
+static std::map<std::pair<int, int>, double> probability;
+static std::map<std::pair<int, int>, std::pair<int, int> > linkQuality;
+static int    sock = -1;
+static double bps = 10000;
+static int    defaultRssi = -50;
+static int    defaultSnr = 10;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-h] [-c configfile] [-b bitspersec] [-p portnumber] [-x socketpath]\n", name);
+    exit(1);
+}
+
+// Reads the same config file as etherSimulator.pl:
+// probability:nodea:nodeb:probability
+// link:nodea:nodeb:rssi:snr
+static void readConfig(const char* config)
+{
+    FILE* f = fopen(config, "r");
+    if (!f)
+    {
+	fprintf(stderr, "Could not open config file %s: %s\n", config, strerror(errno));
+	exit(1);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+	int a, b, rssi, snr;
+	double p;
+	if (sscanf(line, "probability:%d:%d:%lf", &a, &b, &p) == 3)
+	{
+	    probability[std::make_pair(a, b)] = p;
+	    probability[std::make_pair(b, a)] = p; // Bidirectional
+	}
+	else if (sscanf(line, "link:%d:%d:%d:%d", &a, &b, &rssi, &snr) == 4)
+	{
+	    linkQuality[std::make_pair(a, b)] = std::make_pair(rssi, snr);
+	    linkQuality[std::make_pair(b, a)] = std::make_pair(rssi, snr); // Bidirectional
+	}
+    }
+    fclose(f);
+}
+
+// Return true if the message is simulated to have been received successfully
+// taking into account the probability of sucessful delivery
+static bool willDeliverFromTo(int from, int to)
+{
+    std::map<std::pair<int, int>, double>::iterator it = probability.find(std::make_pair(from, to));
+    if (it == probability.end())
+	return true; // If no explicit probability, use 1.0 (certainty)
+    return drand48() < it->second;
+}
+
+static void queueMessage(const std::string& client, const std::string& message)
+{
+    Outgoing o;
+    uint32_t len = htonl(message.size());
+    o.data.assign((const char*)&len, sizeof(len));
+    o.data += message;
+    o.client = client;
+    outgoing.push_back(o);
+}
+
+static void handlePacket(const std::string& sender, const uint8_t* msg, uint32_t len)
+{
+    Pending p;
+    p.frequency = 0; // Version 1 packets are sent on frequency 0, spreading factor 0
+    p.spreadingFactor = 0;
+    p.txTimeSec = p.txTimeUsec = 0;
+    if (msg[0] == RH_TCP_MESSAGE_TYPE_PACKET_EXT)
+    {
+	if (len < 1 + RH_TCP_PACKET_EXT_LEN + RH_TCP_HEADER_LEN)
+	    return;
+	p.frequency       = ntohl(*(uint32_t*)(msg + 4));
+	p.spreadingFactor = msg[8];
+	p.txTimeSec       = ntohl(*(uint32_t*)(msg + 9));
+	p.txTimeUsec      = ntohl(*(uint32_t*)(msg + 13));
+	p.packet.assign((const char*)msg + 1 + RH_TCP_PACKET_EXT_LEN, len - 1 - RH_TCP_PACKET_EXT_LEN);
+    }
+    else
+    {
+	if (len < 1 + RH_TCP_HEADER_LEN)
+	    return;
+	p.packet.assign((const char*)msg + 1, len - 1);
+    }
+    Client& s = clients[sender];
+    p.sender = sender;
+    p.from = s.thisAddress;
+    // A radio sends one packet at a time, so a packet sent back to back with the previous one
+    // (which its client timed itself) starts when that one ends, and never collides with it.
+    // Delivered after the nominal transmission time
+    p.startAt = now();
+    if (s.txEnd > p.startAt)
+	p.startAt = s.txEnd;
+    p.deliverAt = p.startAt + p.packet.size() * 8 / bps;
+    s.txEnd = p.deliverAt;
+    uint64_t channel = ((uint64_t)p.frequency << 8) | p.spreadingFactor;
+
+    // Try to deliver the packet to all the other clients
+    for (std::map<std::string, Client>::iterator it = clients.begin(); it != clients.end(); it++)
+    {
+	if (it->first == sender)
+	    continue; // Dont deliver back to the same client
+	Client& c = it->second;
+	// Check the network config and see if delivery to this node is possible
+	if (!willDeliverFromTo(p.from, c.thisAddress))
+	    continue;
+	// Version 1 clients can only receive on frequency 0, spreading factor 0
+	if (c.version < RH_TCP_PROTOCOL_VERSION_2 && channel)
+	    continue;
+	// The packet reached this destination, see if it collided with a packet
+	// from another client on the same frequency and spreading factor, in the air at the same time
+	bool collision = false;
+	std::multimap<uint64_t, Pending>::iterator q = c.pending.lower_bound(channel);
+	while (q != c.pending.end() && q->first == channel)
+	{
+	    if (   q->second.sender != sender
+		&& q->second.startAt < p.deliverAt
+		&& p.startAt < q->second.deliverAt)
+	    {
+		c.pending.erase(q++); // Collision with waiting packet, both lost
+		collision = true;
+	    }
+	    else
+		q++;
+	}
+	if (!collision)
+	    c.pending.insert(std::make_pair(channel, p));
+    }
+}
+
+static void handleMessage(const struct sockaddr_storage* addr, socklen_t addrLen, const uint8_t* buf, uint32_t len)
+{
+    if (len < sizeof(uint32_t) + 1 || ntohl(*(uint32_t*)buf) != len - sizeof(uint32_t))
+	return; // Not exactly one message
+    const uint8_t* msg = buf + sizeof(uint32_t);
+    len -= sizeof(uint32_t);
+
+    // Find the client, or make a new one
+    std::string key((const char*)addr, addrLen);
+    std::map<std::string, Client>::iterator it = clients.find(key);
+    if (it == clients.end())
+    {
+	Client c;
+	memcpy(&c.addr, addr, addrLen);
+	c.addrLen = addrLen;
+	c.thisAddress = -1;
+	c.version = RH_TCP_PROTOCOL_VERSION_1;
+	c.txEnd = 0;
+	it = clients.insert(std::make_pair(key, c)).first;
+    }
+
+    switch (msg[0])
+    {
+	case RH_TCP_MESSAGE_TYPE_THISADDRESS:
+	    if (len >= 2)
+		it->second.thisAddress = msg[1];
+	    break;
+
+	case RH_TCP_MESSAGE_TYPE_VERSION:
+	    if (len >= 2)
+	    {
+		// Client tells us the highest protocol version it supports, reply with ours
+		it->second.version = msg[1] < RH_TCP_PROTOCOL_VERSION ? msg[1] : RH_TCP_PROTOCOL_VERSION;
+		uint8_t reply[2] = { RH_TCP_MESSAGE_TYPE_VERSION, RH_TCP_PROTOCOL_VERSION };
+		queueMessage(key, std::string((const char*)reply, sizeof(reply)));
+	    }
+	    break;
+
+	case RH_TCP_MESSAGE_TYPE_PACKET:
+	case RH_TCP_MESSAGE_TYPE_PACKET_EXT:
+	    handlePacket(key, msg, len);
+	    break;
+
+	default:
+	    break;
+    }
+}
+
+// Queues all the packets whose airtime has passed, and returns the time
+// until the next one is due in seconds, or -1 if none are waiting
+static double deliverMessages()
+{
+    double t = now();
+    double next = -1;
+    for (std::map<std::string, Client>::iterator it = clients.begin(); it != clients.end(); it++)
+    {
+	Client& c = it->second;
+	std::multimap<uint64_t, Pending>::iterator p = c.pending.begin();
+	while (p != c.pending.end())
+	{
+	    if (p->second.deliverAt > t)
+	    {
+		if (next < 0 || p->second.deliverAt < next)
+		    next = p->second.deliverAt;
+		p++;
+		continue;
+	    }
+	    if (c.version >= RH_TCP_PROTOCOL_VERSION_2)
+	    {
+		// Include the radio parameters, and the simulated link quality
+		std::pair<int, int> q(defaultRssi, defaultSnr);
+		std::map<std::pair<int, int>, std::pair<int, int> >::iterator l
+		    = linkQuality.find(std::make_pair(p->second.from, c.thisAddress));
+		if (l != linkQuality.end())
+		    q = l->second;
+		uint8_t ext[1 + RH_TCP_PACKET_EXT_LEN];
+		uint16_t rssi = htons((uint16_t)q.first);
+		uint32_t frequency = htonl(p->second.frequency);
+		uint32_t sec = htonl(p->second.txTimeSec);
+		uint32_t usec = htonl(p->second.txTimeUsec);
+		ext[0] = RH_TCP_MESSAGE_TYPE_PACKET_EXT;
+		memcpy(ext + 1, &rssi, 2);
+		ext[3] = (uint8_t)q.second;
+		memcpy(ext + 4, &frequency, 4);
+		ext[8] = p->second.spreadingFactor;
+		memcpy(ext + 9, &sec, 4);
+		memcpy(ext + 13, &usec, 4);
+		queueMessage(it->first, std::string((const char*)ext, sizeof(ext)) + p->second.packet);
+	    }
+	    else
+	    {
+		queueMessage(it->first, std::string(1, (char)RH_TCP_MESSAGE_TYPE_PACKET) + p->second.packet);
+	    }
+	    c.pending.erase(p++); // Delivered, forget it
+	}
+    }
+    if (next < 0)
+	return -1;
+    return next - t;
+}
+
+// Sends all the outgoing messages, in batches
+static void sendMessages()
+{
+    size_t next = 0;
+    while (next < outgoing.size())
+    {
+	struct mmsghdr msgs[BATCH];
+	struct iovec   iovs[BATCH];
+	size_t         index[BATCH]; // Index in outgoing of each message in the batch
+	// Copies of the destination addresses, since a failed send may erase a client
+	// that later messages in the batch are addressed to
+	struct sockaddr_storage addrs[BATCH];
+	unsigned int   count = 0;
+	memset(msgs, 0, sizeof(msgs));
+	while (count < BATCH && next < outgoing.size())
+	{
+	    Outgoing& o = outgoing[next++];
+	    std::map<std::string, Client>::iterator it = clients.find(o.client);
+	    if (it == clients.end())
+		continue; // Client has gone away since this was queued
+	    Client& c = it->second;
+	    iovs[count].iov_base = (void*)o.data.data();
+	    iovs[count].iov_len  = o.data.size();
+	    memcpy(&addrs[count], &c.addr, c.addrLen);
+	    msgs[count].msg_hdr.msg_name    = &addrs[count];
+	    msgs[count].msg_hdr.msg_namelen = c.addrLen;
+	    msgs[count].msg_hdr.msg_iov     = &iovs[count];
+	    msgs[count].msg_hdr.msg_iovlen  = 1;
+	    index[count] = next - 1;
+	    count++;
+	}
+	unsigned int done = 0;
+	while (done < count)
+	{
+	    int sent = sendmmsg(sock, msgs + done, count - done, 0);
+	    if (sent < 0)
+	    {
+		if (errno == EINTR)
+		    continue;
+		// This message failed. If the client has gone away, forget it
+		if (errno == ECONNREFUSED || errno == ENOENT)
+		    clients.erase(outgoing[index[done]].client);
+		else if (errno != EAGAIN && errno != ENOBUFS)
+		    fprintf(stderr, "etherSimulatorDgram: sendmmsg failed: %s\n", strerror(errno));
+		sent = 1; // Skip it
+	    }
+	    done += sent;
+	}
+    }
+    outgoing.clear();
+}
+
+static int openUdp(const char* port)
+{
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET6;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+    int s = getaddrinfo(NULL, port, &hints, &result);
+    if (s != 0)
+    {
+	fprintf(stderr, "getaddrinfo failed: %s\n", gai_strerror(s));
+	exit(1);
+    }
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd < 0)
+    {
+	fprintf(stderr, "Could not open UDP socket: %s\n", strerror(errno));
+	exit(1);
+    }
+    int off = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)); // IPV4 as well
+    if (bind(fd, result->ai_addr, result->ai_addrlen) != 0)
+    {
+	fprintf(stderr, "Could not bind UDP port %s: %s\n", port, strerror(errno));
+	exit(1);
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+static int openUnix(const char* path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+	fprintf(stderr, "Socket path too long: %s\n", path);
+	exit(1);
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+	fprintf(stderr, "Could not bind socket %s: %s\n", path, strerror(errno));
+	exit(1);
+    }
+    return fd;
+}
+
+int main(int argc, char** argv)
+{
+    const char* port = "4000";
+    const char* path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "hc:b:p:x:")) != -1)
+    {
+	switch (opt)
+	{
+	    case 'c': readConfig(optarg); break;
+	    case 'b': bps = atof(optarg); break;
+	    case 'p': port = optarg; break;
+	    case 'x': path = optarg; break;
+	    default: usage(argv[0]);
+	}
+    }
+    if (bps <= 0)
+	usage(argv[0]);
+    srand48(getpid() ^ time(NULL));
+    sock = path ? openUnix(path) : openUdp(port);
+
+    // Big socket buffers, so bursts from many clients are not lost
+    int size = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    static uint8_t                 bufs[BATCH][sizeof(RHTcpPacketExt)];
+    static struct sockaddr_storage addrs[BATCH];
+    struct mmsghdr                 msgs[BATCH];
+    struct iovec                   iovs[BATCH];
+    while (1)
+    {
+	// Wait for more messages, or until the next packet is due for delivery
+	struct pollfd pfd = { sock, POLLIN, 0 };
+	double wait = deliverMessages();
+	sendMessages();
+	struct timespec timeout;
+	timeout.tv_sec = (time_t)wait;
+	timeout.tv_nsec = (long)((wait - timeout.tv_sec) * 1000000000);
+	ppoll(&pfd, 1, wait < 0 ? NULL : &timeout, NULL);
+
+	for (unsigned int i = 0; i < BATCH; i++)
+	{
+	    iovs[i].iov_base = bufs[i];
+	    iovs[i].iov_len  = sizeof(bufs[i]);
+	    memset(&msgs[i], 0, sizeof(msgs[i]));
+	    msgs[i].msg_hdr.msg_name    = &addrs[i];
+	    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+	    msgs[i].msg_hdr.msg_iov     = &iovs[i];
+	    msgs[i].msg_hdr.msg_iovlen  = 1;
+	}
+	int count = recvmmsg(sock, msgs, BATCH, MSG_DONTWAIT, NULL);
+	for (int i = 0; i < count; i++)
+	{
+	    if (!(msgs[i].msg_hdr.msg_flags & MSG_TRUNC))
+		handleMessage(&addrs[i], msgs[i].msg_hdr.msg_namelen, bufs[i], msgs[i].msg_len);
+	}
+	deliverMessages();
+	sendMessages();
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// modemConfigCheck.cpp
+//
+// Compile time check that the modem configuration generators RH_RF69_MODEM_CONFIG and
+// RH_RF95_MODEM_CONFIG (and their _FULL and _LDRO forms) reproduce every canned configuration
+// in the MODEM_CONFIG_TABLEs in RH_RF69.cpp and RH_RF95.cpp. The canned values are copied here,
+// so keep them in step with those tables.
+// Compiling is the check: run tools/modemConfigCheck
+
+#include <RH_RF69.h>
+#include <RH_RF95.h>
+
+// Same as in RH_RF69.cpp
+#define CONFIG_FSK (RH_RF69_DATAMODUL_DATAMODE_PACKET | RH_RF69_DATAMODUL_MODULATIONTYPE_FSK | RH_RF69_DATAMODUL_MODULATIONSHAPING_FSK_NONE)
+#define CONFIG_GFSK (RH_RF69_DATAMODUL_DATAMODE_PACKET | RH_RF69_DATAMODUL_MODULATIONTYPE_FSK | RH_RF69_DATAMODUL_MODULATIONSHAPING_FSK_BT1_0)
+#define CONFIG_OOK (RH_RF69_DATAMODUL_DATAMODE_PACKET | RH_RF69_DATAMODUL_MODULATIONTYPE_OOK | RH_RF69_DATAMODUL_MODULATIONSHAPING_OOK_NONE)
+#define CONFIG_NOWHITE (RH_RF69_PACKETCONFIG1_PACKETFORMAT_VARIABLE | RH_RF69_PACKETCONFIG1_DCFREE_NONE | RH_RF69_PACKETCONFIG1_CRC_ON | RH_RF69_PACKETCONFIG1_ADDRESSFILTERING_NONE)
+#define CONFIG_WHITE (RH_RF69_PACKETCONFIG1_PACKETFORMAT_VARIABLE | RH_RF69_PACKETCONFIG1_DCFREE_WHITENING | RH_RF69_PACKETCONFIG1_CRC_ON | RH_RF69_PACKETCONFIG1_ADDRESSFILTERING_NONE)
+
+// Channel filter bandwidths in Hz used by the canned RF69 configurations, as RH_RF69_RXBW_HZ
+#define FSK_BW_M24_E4  20833  // 0x14
+#define FSK_BW_M24_E5  10416  // 0x15
+#define FSK_BW_M24_E3  41666  // 0x13
+#define FSK_BW_M24_E2  83333  // 0x12
+#define FSK_BW_M16_E2 125000  // 0x02
+#define FSK_BW_M16_E1 250000  // 0x01
+#define FSK_BW_M16_E0 500000  // 0x00
+#define OOK_BW_M20_E0 200000  // 0x08
+#define OOK_BW_M24_E1  83333  // 0x11
+#define OOK_BW_M24_E5   5208  // 0x15
+#define OOK_BW_M24_E4  10416  // 0x14
+#define OOK_BW_M24_E3  20833  // 0x13
+#define OOK_BW_M24_E2  41666  // 0x12
+#define OOK_BW_M16_E2  62500  // 0x02
+
+// The canned OOK configurations set the frequency deviation register to 0x10, which OOK does not use
+#define OOK_FDEV 977
+
+// OOK_Rb1Bw1 sets DccFreq to 100
+#define OOK_DCCFREQ 0x80
+
+static constexpr RH_RF69::ModemConfig rf69Canned[] =
+{
+    //  02,        03,   04,   05,   06,   19,   1a,  37
+    { CONFIG_FSK,  0x3e, 0x80, 0x00, 0x52, 0xf4, 0xf4, CONFIG_WHITE}, // FSK_Rb2Fd5
+    { CONFIG_FSK,  0x34, 0x15, 0x00, 0x4f, 0xf4, 0xf4, CONFIG_WHITE}, // FSK_Rb2_4Fd4_8
+    { CONFIG_FSK,  0x1a, 0x0b, 0x00, 0x9d, 0xf4, 0xf4, CONFIG_WHITE}, // FSK_Rb4_8Fd9_6
+    { CONFIG_FSK,  0x0d, 0x05, 0x01, 0x3b, 0xf4, 0xf4, CONFIG_WHITE}, // FSK_Rb9_6Fd19_2
+    { CONFIG_FSK,  0x06, 0x83, 0x02, 0x75, 0xf3, 0xf3, CONFIG_WHITE}, // FSK_Rb19_2Fd38_4
+    { CONFIG_FSK,  0x03, 0x41, 0x04, 0xea, 0xf2, 0xf2, CONFIG_WHITE}, // FSK_Rb38_4Fd76_8
+    { CONFIG_FSK,  0x02, 0x2c, 0x07, 0xae, 0xe2, 0xe2, CONFIG_WHITE}, // FSK_Rb57_6Fd120
+    { CONFIG_FSK,  0x01, 0x00, 0x08, 0x00, 0xe1, 0xe1, CONFIG_WHITE}, // FSK_Rb125Fd125
+    { CONFIG_FSK,  0x00, 0x80, 0x10, 0x00, 0xe0, 0xe0, CONFIG_WHITE}, // FSK_Rb250Fd250
+    { CONFIG_FSK,  0x02, 0x40, 0x03, 0x33, 0x42, 0x42, CONFIG_WHITE}, // FSK_Rb55555Fd50
+    { CONFIG_FSK,  0x02, 0x40, 0x03, 0x33, 0x42, 0x42, CONFIG_NOWHITE}, // FSK_MOTEINO
+    { CONFIG_GFSK, 0x3e, 0x80, 0x00, 0x52, 0xf4, 0xf5, CONFIG_WHITE}, // GFSK_Rb2Fd5
+    { CONFIG_GFSK, 0x34, 0x15, 0x00, 0x4f, 0xf4, 0xf4, CONFIG_WHITE}, // GFSK_Rb2_4Fd4_8
+    { CONFIG_GFSK, 0x1a, 0x0b, 0x00, 0x9d, 0xf4, 0xf4, CONFIG_WHITE}, // GFSK_Rb4_8Fd9_6
+    { CONFIG_GFSK, 0x0d, 0x05, 0x01, 0x3b, 0xf4, 0xf4, CONFIG_WHITE}, // GFSK_Rb9_6Fd19_2
+    { CONFIG_GFSK, 0x06, 0x83, 0x02, 0x75, 0xf3, 0xf3, CONFIG_WHITE}, // GFSK_Rb19_2Fd38_4
+    { CONFIG_GFSK, 0x03, 0x41, 0x04, 0xea, 0xf2, 0xf2, CONFIG_WHITE}, // GFSK_Rb38_4Fd76_8
+    { CONFIG_GFSK, 0x02, 0x2c, 0x07, 0xae, 0xe2, 0xe2, CONFIG_WHITE}, // GFSK_Rb57_6Fd120
+    { CONFIG_GFSK, 0x01, 0x00, 0x08, 0x00, 0xe1, 0xe1, CONFIG_WHITE}, // GFSK_Rb125Fd125
+    { CONFIG_GFSK, 0x00, 0x80, 0x10, 0x00, 0xe0, 0xe0, CONFIG_WHITE}, // GFSK_Rb250Fd250
+    { CONFIG_GFSK, 0x02, 0x40, 0x03, 0x33, 0x42, 0x42, CONFIG_WHITE}, // GFSK_Rb55555Fd50
+    { CONFIG_OOK,  0x7d, 0x00, 0x00, 0x10, 0x88, 0x88, CONFIG_WHITE}, // OOK_Rb1Bw1
+    { CONFIG_OOK,  0x68, 0x2b, 0x00, 0x10, 0xf1, 0xf1, CONFIG_WHITE}, // OOK_Rb1_2Bw75
+    { CONFIG_OOK,  0x34, 0x15, 0x00, 0x10, 0xf5, 0xf5, CONFIG_WHITE}, // OOK_Rb2_4Bw4_8
+    { CONFIG_OOK,  0x1a, 0x0b, 0x00, 0x10, 0xf4, 0xf4, CONFIG_WHITE}, // OOK_Rb4_8Bw9_6
+    { CONFIG_OOK,  0x0d, 0x05, 0x00, 0x10, 0xf3, 0xf3, CONFIG_WHITE}, // OOK_Rb9_6Bw19_2
+    { CONFIG_OOK,  0x06, 0x83, 0x00, 0x10, 0xf2, 0xf2, CONFIG_WHITE}, // OOK_Rb19_2Bw38_4
+    { CONFIG_OOK,  0x03, 0xe8, 0x00, 0x10, 0xe2, 0xe2, CONFIG_WHITE}, // OOK_Rb32Bw64
+};
+
+// In ModemConfigChoice order. The _FULL form is used where the canned configuration is outside
+// the limits RH_RF69_MODEM_CONFIG checks, or does not use its default AFC bandwidth or DC canceller cutoff
+static constexpr RH_RF69::ModemConfig rf69Generated[] =
+{
+    RH_RF69_MODEM_CONFIG(CONFIG_FSK, 2000, 5000, FSK_BW_M24_E4, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_FSK, 2400, 4800, FSK_BW_M24_E4, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_FSK, 4800, 9600, FSK_BW_M24_E4, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_FSK, 9600, 19200, FSK_BW_M24_E4, FSK_BW_M24_E4, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_FSK, 19200, 38400, FSK_BW_M24_E3, FSK_BW_M24_E3, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_FSK, 38400, 76800, FSK_BW_M24_E2, FSK_BW_M24_E2, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_FSK, 57600, 120000, FSK_BW_M16_E2, FSK_BW_M16_E2, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_FSK, 125000, 125000, FSK_BW_M16_E1, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_FSK, 250000, 250000, FSK_BW_M16_E0, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_FSK, 55555, 50000, FSK_BW_M16_E2, FSK_BW_M16_E2, RH_RF69_RXBW_DCCFREQ_DEFAULT, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_FSK, 55555, 50000, FSK_BW_M16_E2, FSK_BW_M16_E2, RH_RF69_RXBW_DCCFREQ_DEFAULT, CONFIG_NOWHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_GFSK, 2000, 5000, FSK_BW_M24_E4, FSK_BW_M24_E5, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_GFSK, 2400, 4800, FSK_BW_M24_E4, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_GFSK, 4800, 9600, FSK_BW_M24_E4, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_GFSK, 9600, 19200, FSK_BW_M24_E4, FSK_BW_M24_E4, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_GFSK, 19200, 38400, FSK_BW_M24_E3, FSK_BW_M24_E3, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_GFSK, 38400, 76800, FSK_BW_M24_E2, FSK_BW_M24_E2, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_GFSK, 57600, 120000, FSK_BW_M16_E2, FSK_BW_M16_E2, RH_RF69_RXBW_DCCFREQ_LOWEST, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_GFSK, 125000, 125000, FSK_BW_M16_E1, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_GFSK, 250000, 250000, FSK_BW_M16_E0, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_GFSK, 55555, 50000, FSK_BW_M16_E2, FSK_BW_M16_E2, RH_RF69_RXBW_DCCFREQ_DEFAULT, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG_FULL(CONFIG_OOK, 1000, OOK_FDEV, OOK_BW_M20_E0, OOK_BW_M20_E0, OOK_DCCFREQ, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_OOK, 1200, OOK_FDEV, OOK_BW_M24_E1, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_OOK, 2400, OOK_FDEV, OOK_BW_M24_E5, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_OOK, 4800, OOK_FDEV, OOK_BW_M24_E4, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_OOK, 9600, OOK_FDEV, OOK_BW_M24_E3, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_OOK, 19200, OOK_FDEV, OOK_BW_M24_E2, CONFIG_WHITE),
+    RH_RF69_MODEM_CONFIG(CONFIG_OOK, 32000, OOK_FDEV, OOK_BW_M16_E2, CONFIG_WHITE),
+};
+
+static constexpr RH_RF95::ModemConfig rf95Canned[] =
+{
+    //  1d,     1e,      26
+    { 0x72,   0x74,    0x04}, // Bw125Cr45Sf128
+    { 0x92,   0x74,    0x04}, // Bw500Cr45Sf128
+    { 0x48,   0x94,    0x04}, // Bw31_25Cr48Sf512
+    { 0x78,   0xc4,    0x0c}, // Bw125Cr48Sf4096
+    { 0x72,   0xb4,    0x04}, // Bw125Cr45Sf2048
+};
+
+// Bw31_25Cr48Sf512 and Bw125Cr45Sf2048 leave low data rate optimisation off, although RH_RF95_NEEDS_LDRO
+static constexpr RH_RF95::ModemConfig rf95Generated[] =
+{
+    RH_RF95_MODEM_CONFIG(125000, 5, 7, true),
+    RH_RF95_MODEM_CONFIG(500000, 5, 7, true),
+    RH_RF95_MODEM_CONFIG_LDRO(31250, 8, 9, true, false),
+    RH_RF95_MODEM_CONFIG(125000, 8, 12, true),
+    RH_RF95_MODEM_CONFIG_LDRO(125000, 5, 11, true, false),
+};
+
+#define COUNT(a) (sizeof(a) / sizeof(a[0]))
+static_assert(COUNT(rf69Canned) == RH_RF69::OOK_Rb32Bw64 + 1, "rf69Canned is not the same size as ModemConfigChoice");
+static_assert(COUNT(rf69Generated) == COUNT(rf69Canned), "rf69Generated is not the same size as rf69Canned");
+static_assert(COUNT(rf95Canned) == RH_RF95::Bw125Cr45Sf2048 + 1, "rf95Canned is not the same size as ModemConfigChoice");
+static_assert(COUNT(rf95Generated) == COUNT(rf95Canned), "rf95Generated is not the same size as rf95Canned");
+
+// True if the configurations from index i onwards are the same
+constexpr bool same(const RH_RF69::ModemConfig* a, const RH_RF69::ModemConfig* b, size_t i, size_t count)
+{
+    return i == count
+	|| (   a[i].reg_02 == b[i].reg_02 && a[i].reg_03 == b[i].reg_03 && a[i].reg_04 == b[i].reg_04
+	    && a[i].reg_05 == b[i].reg_05 && a[i].reg_06 == b[i].reg_06 && a[i].reg_19 == b[i].reg_19
+	    && a[i].reg_1a == b[i].reg_1a && a[i].reg_37 == b[i].reg_37
+	    && same(a, b, i + 1, count));
+}
+constexpr bool same(const RH_RF95::ModemConfig* a, const RH_RF95::ModemConfig* b, size_t i, size_t count)
+{
+    return i == count
+	|| (   a[i].reg_1d == b[i].reg_1d && a[i].reg_1e == b[i].reg_1e && a[i].reg_26 == b[i].reg_26
+	    && same(a, b, i + 1, count));
+}
+
+static_assert(same(rf69Generated, rf69Canned, 0, COUNT(rf69Canned)), "RH_RF69_MODEM_CONFIG does not reproduce the canned configurations");
+static_assert(same(rf95Generated, rf95Canned, 0, COUNT(rf95Canned)), "RH_RF95_MODEM_CONFIG does not reproduce the canned configurations");
@@ -0,0 +1,241 @@
+#!/usr/bin/perl
+#
+# rf24ConfigCompiler.pl
+#
+# Compile a radio configuration header file generated by Silicon Labs
+# Wireless Development Suite (WDS) (such as those in RF24configs) into a
+# compact command list for RH_RF24::configure() and RH_RF24::setConfiguration().
+#
+# All the SET_PROPERTY commands are merged and regrouped into the longest
+# possible runs of consecutive properties (up to 12 per command), so the radio
+# needs fewer commands (and fewer waits for CTS) to load the configuration.
+# Properties that RH_RF24 always sets itself are left out, and with -d, so is
+# everything that is the same as in a base configuration. That makes a small
+# delta that switches a radio already running the base configuration to this one.
+#
+# The output is in the same format as RADIO_CONFIGURATION_DATA_ARRAY:
+# <bytecount> <command> <bytecount-1 bytes of args/data> ... 0x00
+#
+# usage: tools/rf24ConfigCompiler.pl [-n name] [-b] [-k] [-d base_config.h] radio_config.h > output
+# -n name  the name of the generated PROGMEM array. Defaults to a name
+#          derived from the input file name
+# -b       output the raw binary command list instead of a C header
+# -k       keep the properties that RH_RF24 sets itself
+# -d base  only output the commands and properties that differ from the
+#          WDS radio configuration file base
+#
+# Example:
+# tools/rf24ConfigCompiler.pl RF24configs/radio_config_Si4464_30_915_2GFSK_10_20.h > RF24configs/rf24_915_10_20.h
+# and then in your sketch:
+# #include <RF24configs/rf24_915_10_20.h>
+# ...
+# rf24.setConfiguration(rf24_915_10_20);
+
+use strict;
+use Getopt::Std;
+use File::Basename;
+
+# The maximum number of properties in one SET_PROPERTY command
+my $MAX_PROPERTIES = 12;
+my $CMD_SET_PROPERTY = 0x11;
+# The most unchanged properties we will send to avoid starting another SET_PROPERTY
+my $MAX_GAP = 4;
+
+my %opts;
+getopts('n:bkd:', \%opts) && @ARGV == 1
+    or die "usage: $0 [-n name] [-b] [-k] [-d base_config.h] radio_config.h\n";
+my $input = $ARGV[0];
+my $name = $opts{n};
+if (!defined $name)
+{
+    $name = basename($input, '.h');
+    $name =~ s/^radio_config_//;
+    $name = "rf24_config_$name";
+    $name =~ s/\W/_/g;
+}
+
+# The properties RH_RF24 always sets itself in init() and setConfiguration(), so
+# there is no point in loading them from the configuration
+my @overridden = (
+    [0x0100, 0x0103], # INT_CTL_*
+    [0x0200, 0x0203], # FRR_CTL_*
+    [0x1000, 0x1004], # PREAMBLE_TX_LENGTH to PREAMBLE_CONFIG, setPreambleLength()
+    [0x1100, 0x1104], # SYNC_*, setSyncWords()
+    [0x1200, 0x1200], # PKT_CRC_CONFIG, setCRCPolynomial()
+    [0x1206, 0x1206], # PKT_CONFIG1
+    [0x1208, 0x1220], # PKT_LEN to PKT_FIELD_5_CRC_CONFIG
+    [0x2200, 0x2202], # PA_MODE to PA_BIAS_CLKDUTY, setTxPower()
+    );
+
+# Read a WDS radio configuration file and return a reference to the list of
+# non-property commands, and a reference to a hash of property values
+sub read_config
+{
+    my ($file) = @_;
+
+    open(my $fh, '<', $file) or die "Could not open $file: $!\n";
+    my $text = join('', <$fh>);
+    close($fh);
+    # Join continuation lines, and remove comments
+    $text =~ s/\\\r?\n/ /g;
+    $text =~ s/\/\*.*?\*\///gs;
+    $text =~ s/\/\/[^\n]*//g;
+
+    # Find all the simple macros, and the first definition of the command array
+    my %macros;
+    my $array;
+    foreach (split(/\n/, $text))
+    {
+	if (/^\s*#define\s+RADIO_CONFIGURATION_DATA_ARRAY\s+\{(.*)\}/)
+	{
+	    $array = $1 unless defined $array;
+	}
+	elsif (/^\s*#define\s+(\w+)\s+(.*?)\s*$/)
+	{
+	    $macros{$1} = $2;
+	}
+    }
+    die "No RADIO_CONFIGURATION_DATA_ARRAY in $file\n" unless defined $array;
+
+    # Expand the array into bytes
+    my @bytes;
+    my $expand;
+    $expand = sub
+    {
+	my ($tokens, $depth) = @_;
+	die "Macro recursion too deep in $file\n" if $depth > 10;
+	foreach my $token (split(/\s*,\s*/, $tokens))
+	{
+	    $token =~ s/^\s+|\s+$//g;
+	    next if $token eq '';
+	    if ($token =~ /^(0x[0-9a-fA-F]+|\d+)$/)
+	    {
+		my $value = ($token =~ /^0x/i) ? hex($token) : $token;
+		die "Value $token out of range in $file\n" if $value > 255;
+		push(@bytes, $value);
+	    }
+	    elsif (exists $macros{$token})
+	    {
+		$expand->($macros{$token}, $depth + 1);
+	    }
+	    else
+	    {
+		die "Unknown token $token in RADIO_CONFIGURATION_DATA_ARRAY in $file\n";
+	    }
+	}
+    };
+    $expand->($array, 0);
+
+    # Split the bytes into commands, and the property writes
+    # <0x11> <group> <num> <start> <values...> into individual properties
+    my @other;
+    my %props;
+    my $count = 0;
+    while (@bytes)
+    {
+	my $len = shift(@bytes);
+	last if $len == 0;
+	die "Truncated command in $file\n" if $len > @bytes;
+	my @cmd = splice(@bytes, 0, $len);
+	$count++;
+	if ($cmd[0] == $CMD_SET_PROPERTY)
+	{
+	    die "Bad SET_PROPERTY command in $file\n" if $len != $cmd[2] + 4;
+	    for (my $i = 0; $i < $cmd[2]; $i++)
+	    {
+		$props{($cmd[1] << 8) + $cmd[3] + $i} = $cmd[4 + $i];
+	    }
+	}
+	else
+	{
+	    push(@other, \@cmd);
+	}
+    }
+    return (\@other, \%props, $count);
+}
+
+my ($other, $props, $count_in) = read_config($input);
+my %all = %$props;
+
+# Remove properties we dont need to send
+if (!$opts{k})
+{
+    foreach my $range (@overridden)
+    {
+	delete @$props{$range->[0] .. $range->[1]};
+    }
+}
+if (defined $opts{d})
+{
+    # Only send what differs from the base configuration
+    my ($base_other, $base_props) = read_config($opts{d});
+    foreach my $prop (keys %$props)
+    {
+	delete $props->{$prop}
+	    if exists $base_props->{$prop} && $base_props->{$prop} == $props->{$prop};
+    }
+    my %base_cmds = map { join(',', @$_) => 1 } @$base_other;
+    @$other = grep { !$base_cmds{join(',', @$_)} } @$other;
+}
+
+# Other commands (POWER_UP, GPIO_PIN_CFG etc) keep their order, and go first.
+# Then the properties, grouped into the longest possible SET_PROPERTY commands.
+# Short gaps between properties are filled with the values from the configuration
+# where they are known, since that is cheaper than starting a new command
+my @merged = @$other;
+my $prev;
+foreach my $prop (sort { $a <=> $b } keys %$props)
+{
+    my $cmd = $merged[-1];
+    my $gap = defined $prev ? $prop - $prev - 1 : 0;
+    if (defined $prev
+	&& $gap <= $MAX_GAP
+	&& ($prop >> 8) == ($prev >> 8)
+	&& $cmd->[2] + $gap < $MAX_PROPERTIES
+	&& !grep { !exists $all{$_} } ($prev + 1 .. $prop - 1))
+    {
+	$cmd->[2] += $gap + 1;
+	push(@$cmd, @all{$prev + 1 .. $prop - 1}, $props->{$prop});
+    }
+    else
+    {
+	push(@merged, [$CMD_SET_PROPERTY, $prop >> 8, 1, $prop & 0xff, $props->{$prop}]);
+    }
+    $prev = $prop;
+}
+
+my @out;
+foreach my $cmd (@merged)
+{
+    push(@out, scalar(@$cmd), @$cmd);
+}
+push(@out, 0);
+
+if ($opts{b})
+{
+    binmode(STDOUT);
+    print pack('C*', @out);
+    exit;
+}
+
+my $base = basename($input);
+my $guard = uc($name) . '_H';
+print "// $name.h\n";
+print "//\n";
+print "// RH_RF24 configuration generated by tools/rf24ConfigCompiler.pl from $base\n";
+print "// Relative to " . basename($opts{d}) . "\n" if defined $opts{d};
+print "// $count_in commands merged into " . scalar(@merged) . ", " . scalar(@out) . " octets\n";
+print "// Pass $name to RH_RF24::setConfiguration()\n";
+print "\n";
+print "#ifndef $guard\n";
+print "#define $guard\n";
+print "\n";
+print "PROGMEM static const uint8_t ${name}[] = {\n";
+foreach my $cmd (@merged)
+{
+    print "    " . join(', ', map { sprintf('0x%02x', $_) } (scalar(@$cmd), @$cmd)) . ",\n";
+}
+print "    0x00\n";
+print "};\n";
+print "\n";
+print "#endif\n";